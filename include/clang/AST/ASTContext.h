@@ -34,6 +34,7 @@
 #include "clang/Basic/SanitizerBlacklist.h"
 #include "clang/Basic/VersionTuple.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -60,6 +61,7 @@ namespace clang {
   class SelectorTable;
   class TargetInfo;
   class CXXABI;
+  class ConstexprBytecode;
   class MangleNumberingContext;
   // Decls
   class MangleContext;
@@ -432,6 +434,10 @@ private:
   std::unique_ptr<CXXABI> ABI;
   CXXABI *createCXXABI(const TargetInfo &T);
 
+  /// \brief The bytecode compiled for constexpr functions, created on first
+  /// use when -fexperimental-constexpr-bytecode is enabled.
+  std::unique_ptr<ConstexprBytecode> ConstexprBytecodeCache;
+
   /// \brief The logical -> physical address space map.
   const LangAS::Map *AddrSpaceMap;
 
@@ -475,6 +481,15 @@ public:
                           ast_type_traits::DynTypedNode *, ParentVector *>>
       ParentMapOtherNodes;
 
+  /// \brief The nodes in the parent maps that may be reachable from more than
+  /// one top-level declaration, keyed as in the maps.
+  struct ParentMapSharedNodes {
+    llvm::DenseSet<const void *> Pointers;
+    llvm::DenseSet<ast_type_traits::DynTypedNode,
+                   ast_type_traits::DynTypedNode::DenseMapInfo>
+        Others;
+  };
+
   /// Container for either a single DynTypedNode or for an ArrayRef to
   /// DynTypedNode. For use with ParentMap.
   class DynTypedNodeList {
@@ -515,25 +530,25 @@ public:
 
   /// \brief Returns the parents of the given node.
   ///
-  /// Note that this will lazily compute the parents of all nodes
-  /// and store them for later retrieval. Thus, the first call is O(n)
-  /// in the number of AST nodes.
+  /// Note that this lazily computes the parents of all nodes of one
+  /// top-level declaration at a time, and stores them for later retrieval.
+  /// For a declaration, the top-level declaration that lexically contains it
+  /// is visited first. Otherwise, the top-level declarations that have not
+  /// been visited yet are visited in order until the node is found, so the
+  /// first call for a node is O(n) in the number of AST nodes that precede
+  /// it. Top-level declarations that are added to the translation unit later
+  /// are visited as they are needed.
+  ///
+  /// A node below a template or a template instantiation may be reachable
+  /// from more than one top-level declaration, because instantiations reuse
+  /// the parts of their pattern that do not depend on template parameters,
+  /// and an out-of-line member of a class template is a top-level declaration
+  /// of its own. All remaining top-level declarations are visited before
+  /// returning the parents of such a node, so that they are complete.
   ///
   /// Caveats and FIXMEs:
-  /// Calculating the parent map over all AST nodes will need to load the
-  /// full AST. This can be undesirable in the case where the full AST is
-  /// expensive to create (for example, when using precompiled header
-  /// preambles). Thus, there are good opportunities for optimization here.
-  /// One idea is to walk the given node downwards, looking for references
-  /// to declaration contexts - once a declaration context is found, compute
-  /// the parent map for the declaration context; if that can satisfy the
-  /// request, loading the whole AST can be avoided. Note that this is made
-  /// more complex by statements in templates having multiple parents - those
-  /// problems can be solved by building closure over the templated parts of
-  /// the AST, which also avoids touching large parts of the AST.
-  /// Additionally, we will want to add an interface to already give a hint
-  /// where to search for the parents, for example when looking at a statement
-  /// inside a certain function.
+  /// Nodes that are added to a top-level declaration after it has been
+  /// visited are not found.
   ///
   /// 'NodeT' can be one of Decl, Stmt, Type, TypeLoc,
   /// NestedNameSpecifier or NestedNameSpecifierLoc.
@@ -543,6 +558,13 @@ public:
 
   DynTypedNodeList getParents(const ast_type_traits::DynTypedNode &Node);
 
+  /// \brief Computes the parents of the nodes in all top-level declarations
+  /// that have not been visited yet.
+  ///
+  /// Afterwards, \c getParents() does not modify the ASTContext until
+  /// another top-level declaration is added.
+  void buildParentMap();
+
   const clang::PrintingPolicy &getPrintingPolicy() const {
     return PrintingPolicy;
   }
@@ -602,6 +624,10 @@ public:
 
   DiagnosticsEngine &getDiagnostics() const;
 
+  /// \brief Retrieve the bytecode compiled for constexpr functions, used by
+  /// the constant evaluator under -fexperimental-constexpr-bytecode.
+  ConstexprBytecode &getConstexprBytecode();
+
   FullSourceLoc getFullLoc(SourceLocation Loc) const {
     return FullSourceLoc(Loc,SourceMgr);
   }
@@ -2539,8 +2565,22 @@ private:
   void ReleaseDeclContextMaps();
   void ReleaseParentMapEntries();
 
+  /// \brief Adds the parents of the nodes in the top-level declaration \p D
+  /// to the parent maps, unless they have been added already.
+  ///
+  /// \returns true if anything was added.
+  bool addParentMapDecl(Decl *D);
+
   std::unique_ptr<ParentMapPointers> PointerParents;
   std::unique_ptr<ParentMapOtherNodes> OtherParents;
+  std::unique_ptr<ParentMapSharedNodes> SharedParentNodes;
+
+  /// \brief The top-level declarations whose nodes are in the parent maps.
+  llvm::SmallPtrSet<const Decl *, 16> ParentMapDecls;
+
+  /// \brief The last top-level declaration that has been visited in order,
+  /// or null if none has been yet.
+  Decl *LastParentMapDecl;
 
   std::unique_ptr<VTableContextBase> VTContext;
 
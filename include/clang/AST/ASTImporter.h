@@ -49,6 +49,10 @@ namespace clang {
     /// \brief Whether to perform a minimal import.
     bool Minimal;
 
+    /// \brief Whether a function definition is imported as a redeclaration of
+    /// a function that is only declared in the "to" context.
+    bool DefinitionsAsRedecls;
+
     /// \brief Whether the last diagnostic came from the "from" context.
     bool LastDiagFromFrom;
     
@@ -99,6 +103,18 @@ namespace clang {
     /// \brief Whether the importer will perform a minimal import, creating
     /// to-be-completed forward declarations when possible.
     bool isMinimalImport() const { return Minimal; }
+
+    /// \brief Whether the importer imports a function definition as a
+    /// redeclaration of a function that is only declared in the "to"
+    /// context, rather than mapping it to that declaration.
+    bool importsDefinitionsAsRedecls() const { return DefinitionsAsRedecls; }
+
+    /// \brief Set whether the importer imports a function definition as a
+    /// redeclaration of a function that is only declared in the "to" context,
+    /// so that its body becomes available there.
+    void setImportDefinitionsAsRedecls(bool Value) {
+      DefinitionsAsRedecls = Value;
+    }
     
     /// \brief Import the given type from the "from" context into the "to"
     /// context.
@@ -1804,6 +1804,19 @@ private:
   StoredDeclsMap *CreateStoredDeclsMap(ASTContext &C) const;
 
   void buildLookupImpl(DeclContext *DCtx, bool Internal);
+
+  /// \brief Collect the declarations among \p Decls, which are lexically
+  /// within \p DCtx, that \c buildLookupImpl would add to the lookup table.
+  void collectLookupDecls(decl_range Decls, DeclContext *DCtx,
+                          SmallVectorImpl<NamedDecl *> &Result);
+
+  /// \brief Add the declarations \p Decls, which have been loaded from
+  /// external lexical storage, to a lookup table that is otherwise complete.
+  ///
+  /// \returns false, without adding anything, if one of them has a name that
+  /// is in the lookup table already, in which case the table must be rebuilt
+  /// to find the right declarations.
+  bool addLoadedDeclsToLookup(ArrayRef<NamedDecl *> Decls);
   void makeDeclVisibleInContextWithFlags(NamedDecl *D, bool Internal,
                                          bool Rediscoverable);
   void makeDeclVisibleInContextImpl(NamedDecl *D, bool Internal);
@@ -129,10 +129,30 @@ public:
       llvm::StringMap<llvm::TimeRecord> &Records;
     };
 
+    MatchFinderOptions() : NumThreads(1) {}
+
     /// \brief Enables per-check timers.
     ///
     /// It prints a report after match.
     llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief The number of threads \c matchAST() runs the matchers on.
+    ///
+    /// If greater than one, the top-level declarations of the translation
+    /// unit are split into contiguous shards that are matched concurrently,
+    /// each with its own memoization cache. The matches are buffered and the
+    /// callbacks are run on the calling thread afterwards, in the same order
+    /// as when matching on a single thread.
+    ///
+    /// The matchers themselves must then be safe to run concurrently: they
+    /// must not modify the AST or the \c ASTContext. Matchers that look up
+    /// the file of a location, such as \c isExpansionInMainFile and
+    /// \c isExpansionInSystemHeader, are safe. Matchers that compute line or
+    /// column numbers, or call any other \c SourceManager query that fills a
+    /// cache, are not: do not use them with more than one thread. ASTs with
+    /// an external source, and runs with \c CheckProfiling enabled, are
+    /// always matched on a single thread.
+    unsigned NumThreads;
   };
 
   MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
@@ -22,6 +22,7 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/iterator_range.h"
 #include <list>
 #include <vector>
@@ -254,6 +255,32 @@ private:
   typedef std::vector<DiagStatePoint> DiagStatePointsTy;
   mutable DiagStatePointsTy DiagStatePoints;
 
+  /// \brief The DiagStatePoints within one file, as positions in that file.
+  ///
+  /// The points within a file, or within a file or macro expansion that it
+  /// includes, are contiguous in DiagStatePoints. The position of a point is
+  /// its offset in the file, or the offset of the inclusion that it is in.
+  /// A location in the file can then be looked up by its offset instead of
+  /// being compared with the points in translation unit order; the state
+  /// before the first point in the file is that of the point before it.
+  struct FileDiagStatePositions {
+    /// \brief The index of the first point that does not come before the
+    /// start of the file.
+    unsigned First;
+    /// \brief Whether a point after the end of the file has been seen, so
+    /// that Positions has all of the points within it.
+    bool Complete;
+    /// \brief The positions of the points from First on that are within the
+    /// file.
+    SmallVector<unsigned, 4> Positions;
+  };
+
+  /// \brief The positions of the points within each file that the diagnostic
+  /// state was looked up in. The tables are extended lazily as points are
+  /// added, and discarded whenever a point is inserted anywhere other than at
+  /// the end.
+  mutable llvm::DenseMap<FileID, FileDiagStatePositions> DiagStatePositions;
+
   /// \brief Keeps the DiagState that was active during each diagnostic 'push'
   /// so we can get back at it when we 'pop'.
   std::vector<DiagState *> DiagStateOnPushStack;
@@ -278,6 +305,10 @@ private:
   /// the given source location.
   DiagStatePointsTy::iterator GetDiagStatePointForLoc(SourceLocation Loc) const;
 
+  /// \brief Returns the positions of the DiagStatePoints within the file
+  /// \p FID, as described for FileDiagStatePositions.
+  const FileDiagStatePositions &getDiagStatePositions(FileID FID) const;
+
   /// \brief Sticky flag set to \c true when an error is emitted.
   bool ErrorOccurred;
 
@@ -381,7 +412,10 @@ public:
     assert(SourceMgr && "SourceManager not set!");
     return *SourceMgr;
   }
-  void setSourceManager(SourceManager *SrcMgr) { SourceMgr = SrcMgr; }
+  void setSourceManager(SourceManager *SrcMgr) {
+    SourceMgr = SrcMgr;
+    DiagStatePositions.clear();
+  }
 
   //===--------------------------------------------------------------------===//
   //  DiagnosticsEngine characterization methods, used by a client to customize
@@ -23,6 +23,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Allocator.h"
 #include <memory>
 #include <map>
@@ -146,6 +147,13 @@ class FileManager : public RefCountedBase<FileManager> {
   /// \see SeenDirEntries
   llvm::StringMap<FileEntry*, llvm::BumpPtrAllocator> SeenFileEntries;
 
+  /// \brief The names of the entries in each directory that has been listed
+  /// by directoryMayContain, in lowercase, or null if the directory could not
+  /// be listed or reports entries under other paths, as a redirecting VFS
+  /// overlay does.
+  llvm::DenseMap<const DirectoryEntry *, std::unique_ptr<llvm::StringSet<>>>
+      DirectoryListings;
+
   /// \brief The canonical names of directories.
   llvm::DenseMap<const DirectoryEntry *, llvm::StringRef> CanonicalDirNames;
 
@@ -159,6 +167,7 @@ class FileManager : public RefCountedBase<FileManager> {
   // Statistics.
   unsigned NumDirLookups, NumFileLookups;
   unsigned NumDirCacheMisses, NumFileCacheMisses;
+  unsigned NumDirListings;
 
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
@@ -170,6 +179,10 @@ class FileManager : public RefCountedBase<FileManager> {
   /// or a directory) as virtual directories.
   void addAncestorsAsVirtualDirs(StringRef Path);
 
+  /// \brief Retrieve the names in \p Dir as stored in DirectoryListings,
+  /// listing it if that has not been done yet.
+  const llvm::StringSet<> *getDirectoryListing(const DirectoryEntry *Dir);
+
 public:
   FileManager(const FileSystemOptions &FileSystemOpts,
               IntrusiveRefCntPtr<vfs::FileSystem> FS = nullptr);
@@ -217,6 +230,17 @@ public:
   const FileEntry *getFile(StringRef Filename, bool OpenFile = false,
                            bool CacheFailure = true);
 
+  /// \brief Determine whether the file \p Filename, relative to the directory
+  /// \p Dir, might exist, without looking it up.
+  ///
+  /// This lists \p Dir and each of its subdirectories on the way to the file
+  /// the first time they are needed, and then checks their names in memory,
+  /// so that checking for many files that mostly do not exist in the same
+  /// directories takes few system calls. The names are compared ignoring
+  /// case, so a true result does not mean that the file exists; a false one
+  /// does mean that it does not.
+  bool directoryMayContain(const DirectoryEntry *Dir, StringRef Filename);
+
   /// \brief Returns the current file system options
   FileSystemOptions &getFileSystemOpts() { return FileSystemOpts; }
   const FileSystemOptions &getFileSystemOpts() const { return FileSystemOpts; }
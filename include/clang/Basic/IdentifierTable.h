@@ -436,6 +436,16 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// \brief The number of entries in \c LookupCache; a power of two.
+  static const unsigned LookupCacheSize = 1024;
+
+  /// \brief A direct-mapped cache of recently used identifiers, indexed by
+  /// the low bits of the hash computed with \c updateHash().
+  ///
+  /// Identifiers are never removed from the table, so an entry stays valid
+  /// until it is overwritten.
+  IdentifierInfo *LookupCache[LookupCacheSize];
+
 public:
   /// \brief Create the identifier table, populating it with info about the
   /// language keywords for the language specified by \p LangOpts.
@@ -482,6 +492,30 @@ public:
     return *II;
   }
 
+  /// \brief Add the character \p C to \p Hash, the hash of the characters of
+  /// an identifier that precede it.
+  ///
+  /// This lets the lexer hash an identifier while it scans it; the hash of
+  /// an identifier is the result of adding each of its characters in turn to
+  /// the hash 0.
+  static unsigned updateHash(unsigned Hash, char C) {
+    return Hash * 33 + static_cast<unsigned char>(C);
+  }
+
+  /// \brief Return the identifier token info for the specified named
+  /// identifier, whose hash computed with \c updateHash() is \p Hash.
+  ///
+  /// Recently used identifiers are found in a small cache without hashing
+  /// the name again or probing the hash table.
+  IdentifierInfo &getWithHash(StringRef Name, unsigned Hash) {
+    IdentifierInfo *&Cached = LookupCache[Hash & (LookupCacheSize - 1)];
+    if (Cached && Cached->getName() == Name)
+      return *Cached;
+    IdentifierInfo &II = get(Name);
+    Cached = &II;
+    return II;
+  }
+
   IdentifierInfo &get(StringRef Name, tok::TokenKind TokenCode) {
     IdentifierInfo &II = get(Name);
     II.TokenID = TokenCode;
@@ -49,6 +49,7 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <atomic>
 #include <cassert>
 #include <map>
 #include <memory>
@@ -639,8 +640,17 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// \brief A one-entry cache to speed up getFileID.
   ///
   /// LastFileIDLookup records the last FileID looked up or created, because it
-  /// is very common to look up many tokens from the same file.
-  mutable FileID LastFileIDLookup;
+  /// is very common to look up many tokens from the same file. It holds the
+  /// raw ID, and is atomic so that getFileID() can be called on several
+  /// threads at once, as the AST matchers do when matching in parallel.
+  mutable std::atomic<int> LastFileIDLookup;
+
+  FileID getLastFileIDLookup() const {
+    return FileID::get(LastFileIDLookup.load(std::memory_order_relaxed));
+  }
+  void setLastFileIDLookup(FileID FID) const {
+    LastFileIDLookup.store(FID.ID, std::memory_order_relaxed);
+  }
 
   /// \brief Holds information for \#line directives.
   ///
@@ -654,6 +664,24 @@ class SourceManager : public RefCountedBase<SourceManager> {
   mutable unsigned LastLineNoFilePos;
   mutable unsigned LastLineNoResult;
 
+  /// \brief A saved copy of the getLineNumber cache for one file.
+  struct LineNoCacheEntry {
+    FileID FID;
+    SrcMgr::ContentCache *ContentCache;
+    unsigned FilePos;
+    unsigned Result;
+  };
+
+  /// \brief The getLineNumber caches of the files queried most recently
+  /// before the current one.
+  ///
+  /// Diagnostics and debug info frequently alternate between a handful of
+  /// files (e.g. a header and the file including it), which would otherwise
+  /// throw away the one-entry cache above on every switch.
+  enum { NumRecentLineNoQueries = 4 };
+  mutable LineNoCacheEntry RecentLineNoQueries[NumRecentLineNoQueries];
+  mutable unsigned NextRecentLineNoVictim;
+
   /// \brief The file ID for the main source file of the translation unit.
   FileID MainFileID;
 
@@ -661,7 +689,7 @@ class SourceManager : public RefCountedBase<SourceManager> {
   FileID PreambleFileID;
 
   // Statistics for -print-stats.
-  mutable unsigned NumLinearScans, NumBinaryProbes;
+  mutable std::atomic<unsigned> NumLinearScans, NumBinaryProbes;
 
   /// \brief Associates a FileID with its "included/expanded in" decomposed
   /// location.
@@ -980,8 +1008,9 @@ public:
     unsigned SLocOffset = SpellingLoc.getOffset();
 
     // If our one-entry cache covers this offset, just return it.
-    if (isOffsetInFileID(LastFileIDLookup, SLocOffset))
-      return LastFileIDLookup;
+    FileID LastFID = getLastFileIDLookup();
+    if (isOffsetInFileID(LastFID, SLocOffset))
+      return LastFID;
 
     return getFileIDSlow(SLocOffset);
   }
@@ -1606,6 +1635,17 @@ private:
                                         int LoadedID = 0,
                                         unsigned LoadedOffset = 0);
 
+  /// \brief Return true if a local entry of \p Size bytes, plus the location
+  /// just past its end, can be allocated without running into the loaded
+  /// entries.
+  bool hasLocalSLocSpaceFor(unsigned Size) const {
+    return Size < CurrentLoadedOffset - NextLocalOffset;
+  }
+
+  /// \brief Report running out of source location address space as a fatal
+  /// error. Does not return.
+  void reportSLocSpaceExhausted(SourceLocation Loc) const;
+
   /// \brief Return true if the specified FileID contains the
   /// specified SourceLocation offset.  This is a very hot method.
   inline bool isOffsetInFileID(FileID FID, unsigned SLocOffset) const {
@@ -1652,6 +1692,8 @@ private:
   const SrcMgr::ContentCache *
   createMemBufferContentCache(std::unique_ptr<llvm::MemoryBuffer> Buf);
 
+  void switchLineNoCacheTo(FileID FID) const;
+
   FileID getFileIDSlow(unsigned SLocOffset) const;
   FileID getFileIDLocal(unsigned SLocOffset) const;
   FileID getFileIDLoaded(unsigned SLocOffset) const;
@@ -0,0 +1,97 @@
+//===--- TimeTrace.h - Hierarchical compilation time profiler ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the time-trace profiler behind -ftime-trace.
+///
+/// The profiler records nested, named time intervals ("events") together with
+/// the source entity they were spent on, such as the name of a template being
+/// instantiated or of a module being loaded, and writes them in the Chrome
+/// trace event format understood by chrome://tracing and similar viewers.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_TIMETRACE_H
+#define LLVM_CLANG_BASIC_TIMETRACE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+#include <utility>
+
+namespace clang {
+
+class TimeTraceProfiler;
+
+/// \brief The active profiler, or null if time tracing is disabled.
+extern TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// \brief Start recording time-trace events. Events shorter than
+/// \p GranularityUS microseconds are not written to the trace, although they
+/// still count towards the per-name totals.
+void initializeTimeTrace(unsigned GranularityUS);
+
+/// \brief Stop recording and discard all recorded events.
+void cleanupTimeTrace();
+
+/// \brief Whether time-trace events are being recorded.
+inline bool isTimeTraceEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// \brief Write the recorded events to \p OS as a Chrome trace event JSON
+/// object. Events that have not ended yet are left out.
+void writeTimeTrace(raw_ostream &OS);
+
+/// \brief Begin an event named \p Name, spent on the entity \p Detail. Every
+/// call must be matched by a call to endTimeTraceEvent.
+void beginTimeTraceEvent(StringRef Name, StringRef Detail = StringRef());
+
+/// \brief Begin an event whose detail is computed by calling \p Detail, which
+/// only happens if tracing is enabled.
+///
+/// This only takes part in overload resolution for callables, so that strings
+/// of any kind pick the overload above.
+template <typename DetailFn,
+          typename = decltype(std::string(std::declval<DetailFn &>()()))>
+void beginTimeTraceEvent(StringRef Name, DetailFn &&Detail) {
+  if (isTimeTraceEnabled())
+    beginTimeTraceEvent(Name, StringRef(Detail()));
+}
+
+/// \brief End the innermost event that has not ended yet.
+void endTimeTraceEvent();
+
+/// \brief Records a time-trace event covering the lifetime of the scope.
+///
+/// The detail may be given as a callback so that names are only computed when
+/// tracing is enabled; when it is disabled the scope costs a single test.
+class TimeTraceScope {
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name, StringRef Detail = StringRef()) {
+    if (isTimeTraceEnabled())
+      beginTimeTraceEvent(Name, Detail);
+  }
+  template <typename DetailFn,
+            typename = decltype(std::string(std::declval<DetailFn &>()()))>
+  TimeTraceScope(StringRef Name, DetailFn &&Detail) {
+    beginTimeTraceEvent(Name, Detail);
+  }
+  ~TimeTraceScope() {
+    if (isTimeTraceEnabled())
+      endTimeTraceEvent();
+  }
+};
+
+} // end namespace clang
+
+#endif
@@ -13,7 +13,9 @@
 #include "clang/Driver/Action.h"
 #include "clang/Driver/Job.h"
 #include "clang/Driver/Util.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Path.h"
 
 namespace llvm {
@@ -74,6 +76,10 @@ class Compilation {
   /// only be removed if we crash.
   ArgStringMap FailureResultFiles;
 
+  /// The files holding the parts after the first of object files whose code
+  /// is generated in parts, keyed by the name of the object file.
+  llvm::StringMap<llvm::opt::ArgStringList> ObjectPartitions;
+
   /// Redirection for stdout, stderr, etc.
   const StringRef **Redirects;
 
@@ -149,6 +155,22 @@ public:
     return Name;
   }
 
+  /// addObjectPartition - Add a file holding the next part of the object
+  /// file \p Object, which is linked along with it, and returns its argument.
+  const char *addObjectPartition(StringRef Object, const char *Name) {
+    ObjectPartitions[Object].push_back(Name);
+    return Name;
+  }
+
+  /// getObjectPartitions - Return the files holding the parts after the first
+  /// of the object file \p Object.
+  ArrayRef<const char *> getObjectPartitions(StringRef Object) const {
+    auto It = ObjectPartitions.find(Object);
+    if (It == ObjectPartitions.end())
+      return ArrayRef<const char *>();
+    return It->second;
+  }
+
   /// addResultFile - Add a file to remove on failure, and returns its
   /// argument.
   const char *addResultFile(const char *Name, const JobAction *JA) {
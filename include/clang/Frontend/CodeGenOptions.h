@@ -138,6 +138,10 @@ public:
   /// A list of command-line options to forward to the LLVM backend.
   std::vector<std::string> BackendOptions;
 
+  /// The files to write the parts of the object file after the first to,
+  /// when code is generated for the module in parts on separate threads.
+  std::vector<std::string> CodeGenPartitionOutputs;
+
   /// A list of dependent libraries.
   std::vector<std::string> DependentLibraries;
 
@@ -740,6 +740,16 @@ public:
 
   llvm::raw_null_ostream *createNullOutputFile();
 
+  /// Create the file that a report such as -ftime-trace is written to. It is
+  /// named after the output file, or after the main input file in the current
+  /// directory when writing to stdout, or \p DefaultName if there is neither,
+  /// with its extension replaced by \p Extension. The file is not tracked as
+  /// an output file, so it is kept even if the compilation fails.
+  ///
+  /// \return - Null on error, which has been diagnosed.
+  std::unique_ptr<llvm::raw_fd_ostream>
+  createReportFile(StringRef Extension, StringRef DefaultName);
+
   /// }
   /// @name Initialization Utility Methods
   /// {
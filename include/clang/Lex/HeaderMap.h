@@ -17,6 +17,7 @@
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
 #include <memory>
 
 namespace llvm {
@@ -26,16 +27,16 @@ namespace clang {
 
 class FileEntry;
 class FileManager;
-struct HMapBucket;
+struct HMapBucketV2;
 struct HMapHeader;
 
 /// Implementation for \a HeaderMap that doesn't depend on \a FileManager.
 class HeaderMapImpl {
-  std::unique_ptr<const llvm::MemoryBuffer> FileBuffer;
+  std::shared_ptr<const llvm::MemoryBuffer> FileBuffer;
   bool NeedsBSwap;
 
 public:
-  HeaderMapImpl(std::unique_ptr<const llvm::MemoryBuffer> File, bool NeedsBSwap)
+  HeaderMapImpl(std::shared_ptr<const llvm::MemoryBuffer> File, bool NeedsBSwap)
       : FileBuffer(std::move(File)), NeedsBSwap(NeedsBSwap) {}
 
   // Check for a valid header and extract the byte swap.
@@ -52,10 +53,17 @@ public:
   /// Print the contents of this headermap to stderr.
   void dump() const;
 
+  /// The hash function of version 2 header maps, which ignores case.
+  static uint32_t getHashV2(StringRef Key);
+
 private:
   unsigned getEndianAdjustedWord(unsigned X) const;
   const HMapHeader &getHeader() const;
-  HMapBucket getBucket(unsigned BucketNo) const;
+  bool isVersion2() const;
+
+  /// Return the specified hash table bucket, bswap'ing its fields as
+  /// appropriate. The hash of a bucket of a version 1 header map is 0.
+  HMapBucketV2 getBucket(unsigned BucketNo) const;
 
   /// Look up the specified string in the string table.  If the string index is
   /// not valid, return None.
@@ -67,12 +75,16 @@ private:
 /// symlinks to files.  Its advantages are that it is dense and more efficient
 /// to create and process than a directory of symlinks.
 class HeaderMap : private HeaderMapImpl {
-  HeaderMap(std::unique_ptr<const llvm::MemoryBuffer> File, bool BSwap)
+  HeaderMap(std::shared_ptr<const llvm::MemoryBuffer> File, bool BSwap)
       : HeaderMapImpl(std::move(File), BSwap) {}
 
 public:
   /// This attempts to load the specified file as a header map.  If it doesn't
   /// look like a HeaderMap, it gives up and returns null.
+  ///
+  /// The contents of header maps are shared by all of the compilations in the
+  /// process that use them at the same time, and only read again when the
+  /// file changes or no HeaderMap refers to them any more.
   static const HeaderMap *Create(const FileEntry *FE, FileManager &FM);
 
   /// Check to see if the specified relative filename is located in this
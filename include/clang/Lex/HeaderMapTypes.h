@@ -17,6 +17,7 @@ namespace clang {
 enum {
   HMAP_HeaderMagicNumber = ('h' << 24) | ('m' << 16) | ('a' << 8) | 'p',
   HMAP_HeaderVersion = 1,
+  HMAP_HeaderVersion2 = 2,
   HMAP_EmptyBucketKey = 0
 };
 
@@ -26,15 +27,27 @@ struct HMapBucket {
   uint32_t Suffix; // Offset (into strings) of value suffix.
 };
 
+/// A bucket of a version 2 header map. Version 2 header maps place keys with
+/// a better hash function (HeaderMapImpl::getHashV2), and store the hash of
+/// each key so that most keys that do not match can be skipped without
+/// comparing strings.
+struct HMapBucketV2 {
+  uint32_t Key;    // Offset (into strings) of key.
+  uint32_t Prefix; // Offset (into strings) of value prefix.
+  uint32_t Suffix; // Offset (into strings) of value suffix.
+  uint32_t Hash;   // Hash of the key.
+};
+
 struct HMapHeader {
   uint32_t Magic;          // Magic word, also indicates byte order.
-  uint16_t Version;        // Version number -- currently 1.
+  uint16_t Version;        // Version number -- 1 or 2.
   uint16_t Reserved;       // Reserved for future use - zero for now.
   uint32_t StringsOffset;  // Offset to start of string pool.
   uint32_t NumEntries;     // Number of entries in the string table.
   uint32_t NumBuckets;     // Number of buckets (always a power of 2).
   uint32_t MaxValueLength; // Length of longest result path (excluding nul).
-  // An array of 'NumBuckets' HMapBucket objects follows this header.
+  // An array of 'NumBuckets' HMapBucket (HMapBucketV2 in version 2) objects
+  // follows this header.
   // Strings follow the buckets, at StringsOffset.
 };
 
@@ -30,6 +30,7 @@ class DiagnosticsEngine;
 class ExternalPreprocessorSource;
 class FileEntry;
 class FileManager;
+class HeaderSearchCache;
 class HeaderSearchOptions;
 class IdentifierInfo;
 class Preprocessor;
@@ -199,6 +200,14 @@ class HeaderSearch {
   };
   llvm::StringMap<LookupFileCacheInfo, llvm::BumpPtrAllocator> LookupFileCache;
 
+  /// \brief The results of the lookups in earlier compilations with the same
+  /// search directories, if a header search cache path was given.
+  std::unique_ptr<HeaderSearchCache> PersistentLookupCache;
+
+  /// \brief Whether PersistentLookupCache has been opened for the current
+  /// search directories.
+  bool PersistentLookupCacheOpened;
+
   /// \brief Collection mapping a framework or subframework
   /// name like "Carbon" to the Carbon.framework directory.
   llvm::StringMap<FrameworkCacheEntry, llvm::BumpPtrAllocator> FrameworkMap;
@@ -272,6 +281,7 @@ public:
     SystemDirIdx = systemDirIdx;
     NoCurDirSearch = noCurDirSearch;
     //LookupFileCache.clear();
+    PersistentLookupCacheOpened = false;
   }
 
   /// \brief Add an additional search path.
@@ -281,6 +291,7 @@ public:
     if (!isAngled)
       AngledDirIdx++;
     SystemDirIdx++;
+    PersistentLookupCacheOpened = false;
   }
 
   /// \brief Set the list of system header prefixes.
@@ -385,6 +396,10 @@ public:
       Module *RequestingModule, ModuleMap::KnownHeader *SuggestedModule,
       bool SkipCache = false);
 
+  /// \brief Save the results of this compilation's header search lookups for
+  /// later compilations, if a header search cache path was given.
+  void writeLookupCache();
+
   /// \brief Look up a subframework for the specified \#include file.
   ///
   /// For example, if \#include'ing <HIToolbox/HIToolbox.h> from
@@ -532,6 +547,16 @@ public:
   /// \returns true if an error occurred, false otherwise.
   bool loadModuleMapFile(const FileEntry *File, bool IsSystem);
 
+  /// \brief Read the declarations of the module \p ModuleName in the given
+  /// module map file.
+  ///
+  /// With a module map index directory, the rest of the file is only read
+  /// when it is needed; otherwise, this reads the whole file.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool loadModuleMapFileForModule(const FileEntry *File, bool IsSystem,
+                                  StringRef ModuleName);
+
   /// \brief Collect the set of all known, top-level modules.
   ///
   /// \param Modules Will be filled with the set of known, top-level modules.
@@ -586,6 +611,22 @@ private:
                           bool IsSystemHeaderDir, Module *RequestingModule,
                           ModuleMap::KnownHeader *SuggestedModule);
 
+  /// \brief Determine whether the file \p Filename in the directory \p Dir
+  /// might exist and has to be looked up, or is known not to exist because
+  /// the directory was listed.
+  bool directoryMayContain(const DirectoryEntry *Dir, StringRef Filename);
+
+  /// \brief Retrieve the header search results of earlier compilations,
+  /// opening them for the current search directories if necessary.
+  HeaderSearchCache *getPersistentLookupCache();
+
+  /// \brief Record in the persistent lookup cache that a lookup of
+  /// \p Filename starting at search directory \p StartIdx found the file in
+  /// search directory \p HitIdx, or did not find it if \p HitIdx is the
+  /// number of search directories.
+  void notePersistentLookup(StringRef Filename, unsigned StartIdx,
+                            unsigned HitIdx);
+
 public:
   /// \brief Retrieve the module map.
   ModuleMap &getModuleMap() { return ModMap; }
@@ -652,13 +693,41 @@ private:
     LMM_NoDirectory,
     /// \brief There was either no module map file or the module map file was
     /// invalid.
-    LMM_InvalidModuleMap
+    LMM_InvalidModuleMap,
+    /// \brief Only the declarations in the module map file that were needed
+    /// were loaded; the file has not been loaded in full.
+    LMM_PartiallyLoaded
   };
 
+  /// \brief The directory that relative paths in the module map file \p File
+  /// are resolved against.
+  const DirectoryEntry *getModuleMapFileHomeDir(const FileEntry *File);
+
   LoadModuleMapResult loadModuleMapFileImpl(const FileEntry *File,
                                             bool IsSystem,
                                             const DirectoryEntry *Dir);
 
+  /// \brief Parse the declarations in the module map file \p File, and in the
+  /// corresponding private module map file, that declare the module
+  /// \p ModuleName, or that may make a header named \p HeaderFilename part
+  /// of a module.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool parseModuleMapFileLazily(const FileEntry *File, bool IsSystem,
+                                const DirectoryEntry *Dir,
+                                StringRef ModuleName,
+                                StringRef HeaderFilename);
+
+  /// \brief Try to load the declarations needed for the module \p ModuleName,
+  /// or for a header named \p HeaderFilename, from the module map file in
+  /// the given directory.
+  ///
+  /// Without a module map index directory, this loads the whole file.
+  LoadModuleMapResult loadModuleMapFileLazily(const DirectoryEntry *Dir,
+                                              bool IsSystem, bool IsFramework,
+                                              StringRef ModuleName,
+                                              StringRef HeaderFilename);
+
   /// \brief Try to load the module map file in the given directory.
   ///
   /// \param DirName The name of the directory where we will look for a module
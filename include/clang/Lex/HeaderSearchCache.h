@@ -0,0 +1,141 @@
+//===--- HeaderSearchCache.h - Header search results on disk ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the HeaderSearchCache interface, which saves the results
+// of header search lookups between compilations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+#define LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+namespace vfs {
+class FileSystem;
+}
+
+/// \brief The results of header search lookups, saved on disk so that later
+/// compilations with the same search directories can use them.
+///
+/// For a file name and the index of the search directory that a lookup of it
+/// starts at, the cache records the index of the first search directory that
+/// may contain the file; the ones before it are known not to, and need not be
+/// probed. The first index is the number of search directories if none of
+/// them contain the file.
+///
+/// That a directory does not contain "a/b.h" stays true for as long as the
+/// deepest of the directory and its subdirectory "a" that exists is not
+/// modified. The cache records the modification time of that directory along
+/// with the entry, and only uses the entry while the time is unchanged.
+class HeaderSearchCache {
+  /// \brief A directory whose contents some of the entries depend on.
+  struct Guard {
+    std::string Path;
+    time_t ModTime;
+    enum { Unchecked, Unchanged, Changed } State;
+  };
+
+  /// \brief The result of a lookup that started at search directory
+  /// \c StartIdx.
+  struct Entry {
+    unsigned StartIdx;
+    unsigned FirstCandidateIdx;
+    SmallVector<unsigned, 4> Guards;
+    bool Invalid;
+  };
+
+  IntrusiveRefCntPtr<vfs::FileSystem> FS;
+
+  /// \brief The path of the file that the cache is read from and written to.
+  std::string CacheFile;
+
+  /// \brief The names of the search directories, which must match those in
+  /// the cache file.
+  std::vector<std::string> SearchDirs;
+
+  /// \brief When this compilation started. Directories modified since could
+  /// still change without changing their modification time, and are not used
+  /// as guards.
+  time_t StartTime;
+
+  std::vector<Guard> Guards;
+
+  /// \brief The current guard for each directory path.
+  llvm::StringMap<unsigned> GuardIDs;
+
+  llvm::StringMap<SmallVector<Entry, 1>> Entries;
+
+  /// \brief Whether any entries were added, changed or invalidated since the
+  /// cache was read.
+  bool Modified;
+
+  HeaderSearchCache(const HeaderSearchCache &) = delete;
+  void operator=(const HeaderSearchCache &) = delete;
+
+  HeaderSearchCache(IntrusiveRefCntPtr<vfs::FileSystem> FS,
+                    StringRef CacheFile, ArrayRef<std::string> SearchDirs);
+
+  /// \brief Read the entries from the cache file, if it exists and was written
+  /// for the same search directories.
+  void read();
+
+  /// \brief Whether the directory of guard \p ID still has its recorded
+  /// modification time.
+  bool isUnchanged(unsigned ID);
+
+  /// \brief Returns the ID of a guard for the directory \p Path with its
+  /// current modification time, or -1 if it cannot be used as a guard.
+  int getGuard(StringRef Path);
+
+public:
+  /// \brief Open the cache for the given search directories in the directory
+  /// \p CacheDir.
+  ///
+  /// \param SearchDirs Describes the search directories, in order; the cache
+  /// file depends on their descriptions.
+  static std::unique_ptr<HeaderSearchCache>
+  open(IntrusiveRefCntPtr<vfs::FileSystem> FS, StringRef CacheDir,
+       ArrayRef<std::string> SearchDirs);
+
+  /// \brief Returns the index of the first search directory that may contain
+  /// \p Filename when looking it up starting at \p StartIdx. That is
+  /// \p StartIdx itself if the cache has no valid entry for the lookup.
+  unsigned getFirstCandidate(StringRef Filename, unsigned StartIdx);
+
+  /// \brief Record that the search directories from \p StartIdx up to, but
+  /// not including, \p FirstCandidateIdx do not contain \p Filename.
+  ///
+  /// \param GuardPaths For each of those directories, the deepest directory
+  /// on the way from it to \p Filename that exists.
+  void addLookup(StringRef Filename, unsigned StartIdx,
+                 unsigned FirstCandidateIdx, ArrayRef<std::string> GuardPaths);
+
+  /// \brief Write the cache file, if any entries were added, changed or
+  /// invalidated.
+  ///
+  /// \returns true if an error occurred.
+  bool write();
+
+  /// \brief The path of the file that the cache is read from and written to.
+  StringRef getCacheFile() const { return CacheFile; }
+};
+
+} // end namespace clang
+
+#endif
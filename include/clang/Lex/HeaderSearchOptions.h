@@ -93,6 +93,15 @@ public:
   /// \brief The directory used for a user build.
   std::string ModuleUserBuildPath;
 
+  /// \brief The directory in which the results of header search lookups are
+  /// saved for later compilations, if non-empty.
+  std::string HeaderSearchCachePath;
+
+  /// \brief The directory in which the indexes of module map files are saved,
+  /// if non-empty. Module map files are then only parsed in part, as the
+  /// declarations in them are needed.
+  std::string ModuleMapIndexPath;
+
   /// The module/pch container format.
   std::string ModuleFormat;
 
@@ -172,6 +181,10 @@ public:
   /// Whether the module includes debug information (-gmodules).
   unsigned UseDebugInfo : 1;
 
+  /// Whether search directories are listed once to find the headers that
+  /// they do not contain, instead of looking up each header in each of them.
+  unsigned ListSearchDirectories : 1;
+
   HeaderSearchOptions(StringRef _Sysroot = "/")
       : Sysroot(_Sysroot), ModuleFormat("raw"), DisableModuleHash(0),
         ImplicitModuleMaps(0), ModuleMapFileHomeIsCwd(0),
@@ -181,7 +194,7 @@ public:
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
         ModulesValidateSystemHeaders(false),
-        UseDebugInfo(false) {}
+        UseDebugInfo(false), ListSearchDirectories(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
@@ -24,6 +24,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
+#include <memory>
 #include <string>
 
 namespace clang {
@@ -226,7 +227,38 @@ private:
   /// map.
   llvm::DenseMap<const FileEntry *, bool> ParsedModuleMap;
 
+  /// \brief A module map file whose top-level declarations are parsed as they
+  /// are needed.
+  struct LazyModuleMapFile;
+
+  /// \brief The module map files that have been parsed in part, or that will
+  /// be; files are only parsed in part when a module map index directory is
+  /// given.
+  llvm::DenseMap<const FileEntry *, std::unique_ptr<LazyModuleMapFile>>
+      LazyModuleMaps;
+
+  /// \brief For each top-level module name, the module map files parsed in
+  /// part that may have declarations of it that were not parsed yet.
+  llvm::StringMap<SmallVector<const FileEntry *, 1>> PendingModules;
+
   friend class ModuleMapParser;
+
+  /// \brief Retrieve the state of the module map file \p File for parsing it
+  /// in part, indexing it if needed.
+  ///
+  /// \returns null if module map files are always parsed in full.
+  LazyModuleMapFile *getLazyModuleMapFile(const FileEntry *File, bool IsSystem,
+                                          const DirectoryEntry *HomeDir);
+
+  /// \brief Parse the top-level declarations of a module map file parsed in
+  /// part that were not parsed yet, and that declare the module
+  /// \p ModuleName or may declare a header named \p HeaderFilename. An empty
+  /// name matches every declaration.
+  ///
+  /// \returns true if an error occurred in any of the declarations of the
+  /// file parsed so far.
+  bool parseLazyModuleMapFile(const FileEntry *File, LazyModuleMapFile &Lazy,
+                              StringRef ModuleName, StringRef HeaderFilename);
   
   /// \brief Resolve the given export declaration into an actual export
   /// declaration.
@@ -242,7 +274,7 @@ private:
   /// if the export could not be resolved.
   Module::ExportDecl 
   resolveExport(Module *Mod, const Module::UnresolvedExportDecl &Unresolved,
-                bool Complain) const;
+                bool Complain);
 
   /// \brief Resolve the given module id to an actual module.
   ///
@@ -255,7 +287,7 @@ private:
   ///
   /// \returns The resolved module, or null if the module-id could not be
   /// resolved.
-  Module *resolveModuleId(const ModuleId &Id, Module *Mod, bool Complain) const;
+  Module *resolveModuleId(const ModuleId &Id, Module *Mod, bool Complain);
 
   /// \brief Looks up the modules that \p File corresponds to.
   ///
@@ -367,6 +399,12 @@ public:
   /// \returns The named module, if known; otherwise, returns null.
   Module *findModule(StringRef Name) const;
 
+  /// \brief Retrieve a module with the given name, parsing its declarations
+  /// in the module map files that have only been parsed in part.
+  ///
+  /// \returns The named module, if known; otherwise, returns null.
+  Module *findOrLoadModule(StringRef Name);
+
   /// \brief Retrieve a module with the given name using lexical name lookup,
   /// starting at the given context.
   ///
@@ -543,6 +581,26 @@ public:
   bool parseModuleMapFile(const FileEntry *File, bool IsSystem,
                           const DirectoryEntry *HomeDir,
                           SourceLocation ExternModuleLoc = SourceLocation());
+
+  /// \brief Parse the declarations of the top-level module \p ModuleName in
+  /// the given module map file.
+  ///
+  /// The other declarations in the file are parsed when the modules they
+  /// declare are looked up, or when the file is parsed in full. Without a
+  /// module map index directory, this parses the whole file.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool parseModuleMapFileForModule(const FileEntry *File, bool IsSystem,
+                                   const DirectoryEntry *HomeDir,
+                                   StringRef ModuleName);
+
+  /// \brief Parse the declarations in the given module map file that may
+  /// make a header with the file name \p HeaderFilename part of a module.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool parseModuleMapFileForHeader(const FileEntry *File, bool IsSystem,
+                                   const DirectoryEntry *HomeDir,
+                                   StringRef HeaderFilename);
     
   /// \brief Dump the contents of the module map, for debugging purposes.
   void dump();
@@ -0,0 +1,96 @@
+//===--- ModuleMapIndex.h - Index of a module map file ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the ModuleMapIndex interface, which lists the top-level
+// declarations of a module map file so that they can be parsed one at a time.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_MODULEMAPINDEX_H
+#define LLVM_CLANG_LEX_MODULEMAPINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Basic/SourceLocation.h"
+#include "llvm/ADT/SmallVector.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class FileEntry;
+class LangOptions;
+class SourceManager;
+
+/// \brief The top-level declarations of a module map file, with enough
+/// information about each of them to decide whether it has to be parsed.
+///
+/// An index can be saved on disk, where it stays valid for as long as the
+/// size and modification time of the module map file do not change.
+class ModuleMapIndex {
+public:
+  /// \brief A top-level module declaration.
+  struct Entry {
+    /// \brief The name of the top-level module that the declaration
+    /// declares or extends.
+    std::string Name;
+
+    /// \brief The offset of the first token of the declaration in the file.
+    unsigned Offset;
+
+    /// \brief Whether the declaration declares a submodule of a module
+    /// declared elsewhere, as in 'module Name.Sub'.
+    bool IsSubmodule;
+
+    /// \brief Whether the declaration could make any header part of a
+    /// module, through an umbrella header or directory, inferred submodules,
+    /// or another module map file.
+    bool AnyHeader;
+
+    /// \brief The file names of the headers that the declaration names.
+    SmallVector<std::string, 4> Headers;
+
+    /// \brief Whether parsing the declaration could make a header with the
+    /// file name \p Filename part of a module.
+    bool mayDeclareHeader(StringRef Filename) const;
+  };
+
+private:
+  std::vector<Entry> Entries;
+
+public:
+  ArrayRef<Entry> entries() const { return Entries; }
+
+  /// \brief Index the module map file \p FID.
+  ///
+  /// \returns null if the file contains anything that its index cannot
+  /// describe, such as inferred top-level modules; such a file has to be
+  /// parsed in full.
+  static std::unique_ptr<ModuleMapIndex> create(FileID FID,
+                                                SourceManager &SourceMgr,
+                                                const LangOptions &LangOpts);
+
+  /// \brief Read the index of the module map file \p File saved in the
+  /// directory \p IndexDir.
+  ///
+  /// \returns null if there is no saved index for the current contents of
+  /// the file.
+  static std::unique_ptr<ModuleMapIndex> read(StringRef IndexDir,
+                                              const FileEntry *File);
+
+  /// \brief Save this index of the module map file \p File in the directory
+  /// \p IndexDir.
+  ///
+  /// \returns true if an error occurred.
+  bool write(StringRef IndexDir, const FileEntry *File) const;
+};
+
+} // end namespace clang
+
+#endif
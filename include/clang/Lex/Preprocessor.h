@@ -1516,6 +1516,12 @@ public:
   /// updating the token kind accordingly.
   IdentifierInfo *LookUpIdentifierInfo(Token &Identifier) const;
 
+  /// Given a tok::raw_identifier token whose spelling has the hash \p Hash,
+  /// computed with IdentifierTable::updateHash(), look up the identifier
+  /// information for the token and install it into the token, updating the
+  /// token kind accordingly.
+  IdentifierInfo *LookUpIdentifierInfo(Token &Identifier, unsigned Hash) const;
+
 private:
   llvm::DenseMap<IdentifierInfo*,unsigned> PoisonReasons;
 
@@ -585,7 +585,13 @@ namespace clang {
     ovl_fail_enable_if,
 
     /// This candidate was not viable because its address could not be taken.
-    ovl_fail_addr_not_available
+    ovl_fail_addr_not_available,
+
+    /// This function template candidate was found not to be viable by
+    /// Sema::CheckTemplateCallShape, without performing template argument
+    /// deduction. The deduction failure is only worked out if the candidate
+    /// is diagnosed, at which point this becomes ovl_fail_bad_deduction.
+    ovl_fail_deduction_not_performed
   };
 
   /// OverloadCandidate - A single candidate in an overload set (C++ 13.3).
@@ -44,6 +44,7 @@
 #include "clang/Sema/TypoCorrection.h"
 #include "clang/Sema/Weak.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -165,6 +166,7 @@ namespace clang {
   class TemplateDecl;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
+  class TemplateStats;
   class TemplateTemplateParmDecl;
   class Token;
   class TypeAliasDecl;
@@ -6432,6 +6434,124 @@ public:
                           sema::TemplateDeductionInfo &Info,
                           bool InOverloadResolution = false);
 
+  /// \brief The kinds of argument types from which template arguments can
+  /// possibly be deduced for a function parameter.
+  enum CallArgKind {
+    /// \brief Any argument type, as far as a quick check can tell.
+    CAK_Any,
+    /// \brief A class type, for a parameter of the form simple-template-id.
+    CAK_Class,
+    /// \brief A pointer type, or an array or function type decaying to one.
+    CAK_Pointer,
+    /// \brief A pointer-to-member type.
+    CAK_MemberPointer
+  };
+
+  /// \brief A summary of the function parameters of a function template,
+  /// used to reject call candidates without performing template argument
+  /// deduction.
+  struct FunctionTemplateCallShape {
+    /// \brief The minimum number of call arguments.
+    unsigned MinArgs;
+    /// \brief The maximum number of call arguments, or UINT_MAX if there is
+    /// none.
+    unsigned MaxArgs;
+    /// \brief The kinds of argument types that the leading function
+    /// parameters, up to the first function parameter pack, accept.
+    SmallVector<CallArgKind, 4> ParamKinds;
+  };
+
+  /// \brief The call shapes of the function templates that have been call
+  /// candidates so far.
+  llvm::DenseMap<FunctionTemplateDecl *, FunctionTemplateCallShape>
+    FunctionTemplateCallShapes;
+
+  /// \brief Check the number and the kinds of the types of the call arguments
+  /// \p Args against the function parameters of \p FunctionTemplate, to see
+  /// whether template argument deduction for the call is bound to fail.
+  ///
+  /// \returns TDK_TooFewArguments or TDK_TooManyArguments if there are too
+  /// few or too many arguments, TDK_NonDeducedMismatch if the type of an
+  /// argument cannot match its parameter, and TDK_Success if template
+  /// argument deduction has to be performed to tell.
+  TemplateDeductionResult
+  CheckTemplateCallShape(FunctionTemplateDecl *FunctionTemplate,
+                         ArrayRef<Expr *> Args);
+
+  /// \brief A function template specialization that template argument
+  /// deduction produced for a call, keyed by the canonical types and the
+  /// value kinds of the call arguments, which is all that deduction
+  /// without explicit template arguments looks at for most arguments.
+  class DeducedCallSpecialization : public llvm::FoldingSetNode {
+  public:
+    typedef std::pair<QualType, ExprValueKind> CallArgKey;
+
+  private:
+    FunctionTemplateDecl *Template;
+    ArrayRef<CallArgKey> Args;
+    FunctionDecl *Specialization;
+
+  public:
+    DeducedCallSpecialization(FunctionTemplateDecl *Template,
+                              ArrayRef<CallArgKey> Args,
+                              FunctionDecl *Specialization)
+      : Template(Template), Args(Args), Specialization(Specialization) {}
+
+    FunctionDecl *getSpecialization() const { return Specialization; }
+    void setSpecialization(FunctionDecl *FD) { Specialization = FD; }
+
+    void Profile(llvm::FoldingSetNodeID &ID) {
+      Profile(ID, Template, Args);
+    }
+
+    static void Profile(llvm::FoldingSetNodeID &ID,
+                        FunctionTemplateDecl *Template,
+                        ArrayRef<CallArgKey> Args);
+  };
+
+  /// \brief The specializations produced by successful template argument
+  /// deduction for calls, so that deduction for calls with the same argument
+  /// types can reuse them rather than deducing again.
+  ///
+  /// Only successful deductions are remembered: a failed deduction may
+  /// succeed later in the translation unit (for instance once a class is
+  /// complete), whereas the specialization produced by a successful one is
+  /// what any later deduction would find again.
+  llvm::FoldingSet<DeducedCallSpecialization> DeducedCallSpecializations;
+
+private:
+  /// \brief The implementations of the DeduceTemplateArguments overloads
+  /// above, which record their results for -ftemplate-stats.
+  TemplateDeductionResult
+  DeduceTemplateArgumentsImpl(ClassTemplatePartialSpecializationDecl *Partial,
+                              const TemplateArgumentList &TemplateArgs,
+                              sema::TemplateDeductionInfo &Info);
+  TemplateDeductionResult
+  DeduceTemplateArgumentsImpl(VarTemplatePartialSpecializationDecl *Partial,
+                              const TemplateArgumentList &TemplateArgs,
+                              sema::TemplateDeductionInfo &Info);
+  TemplateDeductionResult
+  DeduceTemplateArgumentsImpl(FunctionTemplateDecl *FunctionTemplate,
+                              TemplateArgumentListInfo *ExplicitTemplateArgs,
+                              ArrayRef<Expr *> Args,
+                              FunctionDecl *&Specialization,
+                              sema::TemplateDeductionInfo &Info,
+                              bool PartialOverloading);
+  TemplateDeductionResult
+  DeduceTemplateArgumentsImpl(FunctionTemplateDecl *FunctionTemplate,
+                              TemplateArgumentListInfo *ExplicitTemplateArgs,
+                              QualType ArgFunctionType,
+                              FunctionDecl *&Specialization,
+                              sema::TemplateDeductionInfo &Info,
+                              bool InOverloadResolution);
+  TemplateDeductionResult
+  DeduceTemplateArgumentsImpl(FunctionTemplateDecl *ConversionTemplate,
+                              QualType ToType,
+                              CXXConversionDecl *&Specialization,
+                              sema::TemplateDeductionInfo &Info);
+
+public:
+
   /// \brief Substitute Replacement for \p auto in \p TypeWithAuto
   QualType SubstAutoType(QualType TypeWithAuto, QualType Replacement);
   /// \brief Substitute Replacement for auto in TypeWithAuto
@@ -6635,6 +6755,10 @@ public:
   SmallVector<ActiveTemplateInstantiation, 16>
     ActiveTemplateInstantiations;
 
+  /// \brief The per-template instantiation statistics collected for
+  /// -ftemplate-stats, or null if they are not being collected.
+  std::unique_ptr<TemplateStats> TemplateStatistics;
+
   /// \brief Extra modules inspected when performing a lookup during a template
   /// instantiation. Computed lazily.
   SmallVector<Module*, 16> ActiveTemplateInstantiationLookupModules;
@@ -0,0 +1,146 @@
+//===--- TemplateStats.h - Per-template instantiation stats -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TemplateStats class, which collects the per-template
+/// statistics written by -ftemplate-stats.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATESTATS_H
+#define LLVM_CLANG_SEMA_TEMPLATESTATS_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include <chrono>
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+struct PrintingPolicy;
+
+/// \brief Collects, for every template, how often and at what cost it was
+/// instantiated, how often template argument deduction against it failed,
+/// and how often one of its specializations was requested and found to exist
+/// already.
+///
+/// The time and the bytes of AST allocated are recorded both inclusive and
+/// exclusive ("self") of the instantiations triggered while instantiating a
+/// specialization. The inclusive totals of a template only count its
+/// outermost instantiations, so that recursive templates are not counted more
+/// than once.
+class TemplateStats {
+public:
+  typedef std::chrono::steady_clock ClockType;
+  typedef std::chrono::microseconds DurationType;
+
+  /// \brief The cost of the instantiations of a template or specialization.
+  struct Cost {
+    unsigned Instantiations;
+    DurationType Time;
+    DurationType SelfTime;
+    uint64_t Bytes;
+    uint64_t SelfBytes;
+
+    Cost()
+        : Instantiations(0), Time(0), SelfTime(0), Bytes(0), SelfBytes(0) {}
+  };
+
+  /// \brief The statistics of a single template.
+  struct TemplateEntry {
+    Cost Total;
+    unsigned Deductions;
+    unsigned DeductionFailures;
+    unsigned Lookups;
+    unsigned LookupHits;
+    llvm::MapVector<const Decl *, Cost> Specializations;
+
+    TemplateEntry()
+        : Deductions(0), DeductionFailures(0), Lookups(0), LookupHits(0) {}
+  };
+
+private:
+  ASTContext &Context;
+
+  /// \brief An instantiation that has started but not finished yet.
+  struct Frame {
+    const Decl *Template;
+    const Decl *Specialization;
+    ClockType::time_point Start;
+    uint64_t StartBytes;
+    DurationType ChildTime;
+    uint64_t ChildBytes;
+  };
+
+  /// \brief The active instantiations, innermost last.
+  SmallVector<Frame, 16> Stack;
+
+  /// \brief The statistics by (canonical) template, in the order in which the
+  /// templates were first seen.
+  llvm::MapVector<const Decl *, TemplateEntry> Templates;
+
+  /// \brief Whether deductions are currently not recorded.
+  bool IgnoreDeductions;
+
+  TemplateStats(const TemplateStats &) = delete;
+  void operator=(const TemplateStats &) = delete;
+
+public:
+  explicit TemplateStats(ASTContext &Context)
+      : Context(Context), IgnoreDeductions(false) {}
+
+  /// \brief RAII object that stops template argument deduction from being
+  /// recorded, for a deduction that repeats one that was recorded already.
+  class RepeatedDeductionRAII {
+    TemplateStats *Stats;
+    bool OldIgnoreDeductions;
+
+  public:
+    explicit RepeatedDeductionRAII(TemplateStats *Stats) : Stats(Stats) {
+      if (Stats) {
+        OldIgnoreDeductions = Stats->IgnoreDeductions;
+        Stats->IgnoreDeductions = true;
+      }
+    }
+
+    ~RepeatedDeductionRAII() {
+      if (Stats)
+        Stats->IgnoreDeductions = OldIgnoreDeductions;
+    }
+  };
+
+  /// \brief Returns the template that \p D is a specialization or member
+  /// instantiation of, or \p D itself if it is neither.
+  static const Decl *getTemplate(const Decl *D);
+
+  /// \brief Note that the instantiation of \p Specialization has begun. Every
+  /// call must be matched by a call to finishInstantiation.
+  void startInstantiation(const Decl *Specialization);
+
+  /// \brief Note that the innermost active instantiation has finished.
+  void finishInstantiation();
+
+  /// \brief Note that template argument deduction against \p Template was
+  /// attempted, and whether it failed.
+  void noteDeduction(const Decl *Template, bool Failed);
+
+  /// \brief Note that a specialization of \p Template was requested, and
+  /// whether it existed already.
+  void noteSpecializationLookup(const Decl *Template, bool Found);
+
+  /// \brief Write the collected statistics to \p OS as a JSON object, the
+  /// most expensive templates first.
+  void write(raw_ostream &OS, const PrintingPolicy &Policy) const;
+};
+
+} // end namespace clang
+
+#endif
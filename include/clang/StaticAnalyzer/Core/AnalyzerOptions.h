@@ -121,6 +121,29 @@ enum IPAKind {
   IPAK_DynamicDispatchBifurcate = 5
 };
 
+/// \brief Describes the order in which the ExplodedGraph is explored.
+enum ExplorationStrategyKind {
+  ESK_NotSet = 0,
+
+  /// Depth-first search of the exploded graph.
+  ESK_DFS = 1,
+
+  /// Breadth-first search of the exploded graph.
+  ESK_BFS = 2,
+
+  /// Breadth-first search over CFG blocks, depth-first within each block.
+  ESK_BFSBlockDFSContents = 3,
+
+  /// Depth-first search that prefers nodes entering CFG blocks which have not
+  /// been reached yet in the current stack frame.
+  ESK_UnexploredFirst = 4,
+
+  /// Priority queue ordered by how often the entered CFG block has been
+  /// reached in the current stack frame, so that further loop iterations are
+  /// postponed in favor of code that has been explored less.
+  ESK_UnexploredFirstQueue = 5
+};
+
 class AnalyzerOptions : public RefCountedBase<AnalyzerOptions> {
 public:
   typedef llvm::StringMap<std::string> ConfigTable;
@@ -198,6 +221,9 @@ private:
   /// Controls the mode of inter-procedural analysis.
   IPAKind IPAMode;
 
+  /// Controls the order in which the ExplodedGraph is explored.
+  ExplorationStrategyKind ExplorationStrategy;
+
   /// Controls which C++ member functions will be considered for inlining.
   CXXInlineableMemberKind CXXMemberInliningMode;
   
@@ -265,6 +291,9 @@ private:
   /// \sa shouldWidenLoops
   Optional<bool> WidenLoops;
 
+  /// \sa getRegionStoreFlatClusterLimit
+  Optional<unsigned> RegionStoreFlatClusterLimit;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -370,6 +399,17 @@ public:
   /// \brief Returns the inter-procedural analysis mode.
   IPAKind getIPAMode();
 
+  /// \brief Returns the strategy used to pick the next node to explore.
+  ///
+  /// This is controlled by the 'exploration-strategy' config option, which
+  /// accepts "dfs" (the default), "bfs", "bfs-block-dfs-contents",
+  /// "unexplored-first" and "unexplored-first-queue".
+  ExplorationStrategyKind getExplorationStrategy();
+
+  /// \brief Returns true if \p Strategy is a valid value of the
+  /// 'exploration-strategy' config option.
+  static bool isValidExplorationStrategy(StringRef Strategy);
+
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
   ///
@@ -533,6 +573,13 @@ public:
   /// This is controlled by the 'widen-loops' config option.
   bool shouldWidenLoops();
 
+  /// Returns the largest number of bindings a RegionStore cluster can hold
+  /// and still be stored as a flat sorted array rather than a balanced tree.
+  ///
+  /// This is controlled by the 'region-store-flat-cluster-limit' config
+  /// option. To always use trees, set the option to "0".
+  unsigned getRegionStoreFlatClusterLimit();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
@@ -556,6 +603,7 @@ public:
     InliningMode(NoRedundancy),
     UserMode(UMK_NotSet),
     IPAMode(IPAK_NotSet),
+    ExplorationStrategy(ESK_NotSet),
     CXXMemberInliningMode() {}
 
 };
@@ -20,6 +20,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/Store.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Timer.h"
 #include <vector>
 
 namespace clang {
@@ -103,12 +104,14 @@ class CheckerManager {
   const LangOptions LangOpts;
   AnalyzerOptionsRef AOptions;
   CheckName CurrentCheckName;
+  bool ProfilingEnabled;
 
 public:
   CheckerManager(const LangOptions &langOpts,
                  AnalyzerOptionsRef AOptions)
     : LangOpts(langOpts),
-      AOptions(AOptions) {}
+      AOptions(AOptions), ProfilingEnabled(false),
+      ActiveProfileScope(nullptr) {}
 
   ~CheckerManager();
 
@@ -126,6 +129,93 @@ public:
   typedef const void *CheckerTag;
   typedef CheckerFn<void ()> CheckerDtor;
 
+//===----------------------------------------------------------------------===//
+// Profiling
+//===----------------------------------------------------------------------===//
+
+  /// \brief The kinds of checker callbacks that are profiled separately.
+  enum CallbackKind {
+    CK_ASTDecl,
+    CK_ASTCodeBody,
+    CK_EndOfTranslationUnit,
+    CK_EndAnalysis,
+    CK_PreStmt,
+    CK_PostStmt,
+    CK_PreObjCMessage,
+    CK_PostObjCMessage,
+    CK_ObjCMessageNil,
+    CK_PreCall,
+    CK_PostCall,
+    CK_Location,
+    CK_Bind,
+    CK_BeginFunction,
+    CK_EndFunction,
+    CK_BranchCondition,
+    CK_LiveSymbols,
+    CK_DeadSymbols,
+    CK_RegionChanges,
+    CK_PointerEscape,
+    CK_EvalAssume,
+    CK_EvalCall
+  };
+
+  /// \brief The accumulated cost of one callback of one checker. Times and
+  /// nodes are exclusive: when a callback triggers other checker callbacks,
+  /// for example by invalidating regions, the cost of those is charged to
+  /// them only, so that the costs of all callbacks add up to the total.
+  struct CallbackProfile {
+    llvm::TimeRecord Time;
+    unsigned NumCalls;
+    unsigned NumNodes;
+    CallbackProfile() : NumCalls(0), NumNodes(0) {}
+  };
+
+  typedef std::pair<const CheckerBase *, unsigned> ProfileKey;
+  typedef llvm::DenseMap<ProfileKey, CallbackProfile> ProfileMapTy;
+
+  /// \brief Attributes the time and memory spent while it is alive, and the
+  /// nodes added to the exploded graph meanwhile, to one callback of one
+  /// checker. Does nothing unless profiling is enabled.
+  class ProfileScope {
+    CheckerManager *Mgr;
+    const CheckerBase *Checker;
+    CallbackKind Kind;
+    const ExplodedGraph *G;
+    ProfileScope *Parent;
+    llvm::TimeRecord Start;
+    llvm::TimeRecord Nested;
+    unsigned StartNodes;
+    unsigned NestedNodes;
+
+    void start();
+    void finish();
+
+  public:
+    ProfileScope(CheckerManager &Mgr, const CheckerBase *Checker,
+                 CallbackKind Kind, const ExplodedGraph *G = nullptr)
+      : Mgr(Mgr.ProfilingEnabled ? &Mgr : nullptr), Checker(Checker),
+        Kind(Kind), G(G), Parent(nullptr), StartNodes(0), NestedNodes(0) {
+      if (this->Mgr)
+        start();
+    }
+    ~ProfileScope() {
+      if (Mgr)
+        finish();
+    }
+  };
+
+  /// \brief Start collecting the cost of every checker callback.
+  void enableProfiling() { ProfilingEnabled = true; }
+  bool isProfilingEnabled() const { return ProfilingEnabled; }
+  const ProfileMapTy &getProfiles() const { return Profiles; }
+
+  /// \brief Print the collected profile as a table in the style of
+  /// -ftime-report, costliest checker first.
+  void printProfile(raw_ostream &Out) const;
+
+  /// \brief Print the collected profile as a JSON object.
+  void printProfileAsJSON(raw_ostream &Out) const;
+
 //===----------------------------------------------------------------------===//
 // registerChecker
 //===----------------------------------------------------------------------===//
@@ -634,6 +724,10 @@ private:
   
   typedef llvm::DenseMap<EventTag, EventInfo> EventsTy;
   EventsTy Events;
+
+  ProfileMapTy Profiles;
+  /// The innermost callback being profiled, if any.
+  ProfileScope *ActiveProfileScope;
 };
 
 } // end ento namespace
@@ -441,8 +441,15 @@ public:
       AnalysisDeclContext *AD =
         getLocationContext()->getAnalysisDeclContext()->
         getManager()->getContext(FD);
-      if (AD->getBody())
+      if (AD->getBody()) {
+        // A definition injected from another translation unit is attached
+        // as a new redeclaration; inline that one so that its parameters
+        // match the body.
+        const FunctionDecl *Def = nullptr;
+        if (FD->hasBody(Def) && Def != AD->getDecl())
+          return RuntimeDefinition(Def);
         return RuntimeDefinition(AD->getDecl());
+      }
     }
 
     return RuntimeDefinition();
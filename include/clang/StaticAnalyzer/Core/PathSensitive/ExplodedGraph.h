@@ -392,6 +392,7 @@ public:
 private:
   bool shouldCollect(const ExplodedNode *node);
   void collectNode(ExplodedNode *node);
+  void updatePeakNodeStatistic() const;
 };
 
 class ExplodedNodeSet {
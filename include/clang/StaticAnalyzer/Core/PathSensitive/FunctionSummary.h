@@ -19,8 +19,12 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/StringMap.h"
 #include <deque>
+#include <string>
+#include <vector>
 
 namespace clang {
 
@@ -109,6 +113,13 @@ public:
     return 0;
   }
 
+  unsigned getNumBasicBlocks(const Decl* D) {
+    MapTy::const_iterator I = Map.find(D);
+    if (I != Map.end())
+      return I->second.TotalBasicBlocks;
+    return 0;
+  }
+
   unsigned getNumTimesInlined(const Decl* D) {
     MapTy::const_iterator I = Map.find(D);
     if (I != Map.end())
@@ -135,6 +146,76 @@ public:
 
 };
 
+/// \brief Summaries of top-level analyses that are kept across analyzer runs.
+///
+/// Each summary is keyed by the USR of the analyzed function and records the
+/// hash of the code it was computed from, so that an unchanged function does
+/// not have to be explored again by the next run over the same translation
+/// unit. The whole cache is tagged with a fingerprint of everything else that
+/// may influence the results (analyzer options, headers, global
+/// declarations); a cache whose fingerprint does not match is discarded.
+class PersistentFunctionSummaries {
+public:
+  struct Summary {
+    /// Hash of the function's code and the code of the functions it calls.
+    std::string BodyHash;
+
+    /// The number of path-sensitive issues reported while analyzing the
+    /// function as top level.
+    unsigned NumReports;
+
+    /// Basic block coverage of the top-level analysis. A run that skips the
+    /// function still counts it in the coverage statistics.
+    unsigned NumVisitedBlocks;
+    unsigned NumTotalBlocks;
+
+    /// USRs of the functions inlined while analyzing the function. They are
+    /// not analyzed as top level when the function is.
+    std::vector<std::string> InlinedCallees;
+
+    Summary() : NumReports(0), NumVisitedBlocks(0), NumTotalBlocks(0) {}
+  };
+
+private:
+  typedef llvm::StringMap<Summary> MapTy;
+  MapTy Map;
+  std::string Fingerprint;
+
+public:
+  explicit PersistentFunctionSummaries(StringRef Fingerprint)
+    : Fingerprint(Fingerprint) {}
+
+  /// \brief Read the summaries stored in \p Path. Returns false if the file
+  /// does not exist, cannot be parsed, or was written for a different
+  /// fingerprint; the cache is left empty in that case.
+  bool load(StringRef Path);
+
+  /// \brief Write the summaries to \p Path, replacing it atomically. The
+  /// parent directories of \p Path are created as needed. Returns false if
+  /// the cache could not be written.
+  bool save(StringRef Path) const;
+
+  /// \brief Return the summary recorded for the function with the given USR,
+  /// or null if there is none. The caller is responsible for checking that
+  /// the summary's hash matches the current code.
+  const Summary *lookup(StringRef USR) const {
+    MapTy::const_iterator I = Map.find(USR);
+    if (I == Map.end())
+      return nullptr;
+    return &I->second;
+  }
+
+  void update(StringRef USR, Summary S) {
+    Map[USR] = std::move(S);
+  }
+
+  /// \brief Remove the summaries of the functions whose USRs \p IsLive
+  /// rejects, such as functions that are no longer in the translation unit.
+  void prune(llvm::function_ref<bool(StringRef USR)> IsLive);
+
+  unsigned size() const { return Map.size(); }
+};
+
 }} // end clang ento namespaces
 
 #endif
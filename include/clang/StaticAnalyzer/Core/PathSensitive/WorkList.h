@@ -91,6 +91,8 @@ public:
   static WorkList *makeDFS();
   static WorkList *makeBFS();
   static WorkList *makeBFSBlockDFSContents();
+  static WorkList *makeUnexploredFirst();
+  static WorkList *makeUnexploredFirstPriorityQueue();
 };
 
 } // end GR namespace
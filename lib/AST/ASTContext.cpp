@@ -13,6 +13,7 @@
 
 #include "clang/AST/ASTContext.h"
 #include "CXXABI.h"
+#include "ConstexprBytecode.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
@@ -694,6 +695,12 @@ CXXABI *ASTContext::createCXXABI(const TargetInfo &T) {
   llvm_unreachable("Invalid CXXABI type!");
 }
 
+ConstexprBytecode &ASTContext::getConstexprBytecode() {
+  if (!ConstexprBytecodeCache)
+    ConstexprBytecodeCache.reset(new ConstexprBytecode(*this));
+  return *ConstexprBytecodeCache;
+}
+
 static const LangAS::Map *getAddressSpaceMap(const TargetInfo &T,
                                              const LangOptions &LOpts) {
   if (LOpts.FakeAddressSpaceMap) {
@@ -750,7 +757,8 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
       PrintingPolicy(LOpts), Idents(idents), Selectors(sels),
       BuiltinInfo(builtins), DeclarationNames(*this), ExternalSource(nullptr),
       Listener(nullptr), Comments(SM), CommentsLoaded(false),
-      CommentCommandTraits(BumpAlloc, LOpts.CommentOpts), LastSDM(nullptr, 0) {
+      CommentCommandTraits(BumpAlloc, LOpts.CommentOpts), LastSDM(nullptr, 0),
+      LastParentMapDecl(nullptr) {
   TUDecl = TranslationUnitDecl::Create(*this);
 }
 
@@ -8836,24 +8844,50 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
   /// FIXME: Currently only builds up the map using \c Stmt and \c Decl nodes.
   class ParentMapASTVisitor : public RecursiveASTVisitor<ParentMapASTVisitor> {
   public:
-    /// \brief Builds and returns the translation unit's parent map.
-    ///
-    ///  The caller takes ownership of the returned \c ParentMap.
-    static std::pair<ASTContext::ParentMapPointers *,
-                     ASTContext::ParentMapOtherNodes *>
-    buildMap(TranslationUnitDecl &TU) {
-      ParentMapASTVisitor Visitor(new ASTContext::ParentMapPointers,
-                                  new ASTContext::ParentMapOtherNodes);
-      Visitor.TraverseDecl(&TU);
-      return std::make_pair(Visitor.Parents, Visitor.OtherParents);
+    /// \brief Adds the parents of the nodes in the top-level declaration
+    /// \p D, whose parent is the translation unit \p TU, to the maps.
+    /// The nodes below templates and template instantiations are also
+    /// added to \p Shared.
+    static void addTopLevelDecl(TranslationUnitDecl &TU, Decl &D,
+                                ASTContext::ParentMapPointers &Parents,
+                                ASTContext::ParentMapOtherNodes &OtherParents,
+                                ASTContext::ParentMapSharedNodes &Shared) {
+      ParentMapASTVisitor Visitor(&Parents, &OtherParents, &Shared);
+      Visitor.ParentStack.push_back(ast_type_traits::DynTypedNode::create(TU));
+      Visitor.TraverseDecl(&D);
     }
 
   private:
     typedef RecursiveASTVisitor<ParentMapASTVisitor> VisitorBase;
 
     ParentMapASTVisitor(ASTContext::ParentMapPointers *Parents,
-                        ASTContext::ParentMapOtherNodes *OtherParents)
-        : Parents(Parents), OtherParents(OtherParents) {}
+                        ASTContext::ParentMapOtherNodes *OtherParents,
+                        ASTContext::ParentMapSharedNodes *Shared)
+        : Parents(Parents), OtherParents(OtherParents), Shared(Shared),
+          TemplateDepth(0) {}
+
+    /// \brief Whether the nodes below \p D may be shared with another
+    /// top-level declaration.
+    static bool mayShareNodes(const Decl *D) {
+      if (isa<TemplateDecl>(D) || isa<ClassTemplateSpecializationDecl>(D) ||
+          isa<VarTemplateSpecializationDecl>(D))
+        return true;
+      if (const auto *DC = dyn_cast<DeclContext>(D))
+        if (DC->isDependentContext())
+          return true;
+      if (const auto *FD = dyn_cast<FunctionDecl>(D))
+        return FD->getTemplatedKind() != FunctionDecl::TK_NonTemplate;
+      if (const auto *RD = dyn_cast<CXXRecordDecl>(D))
+        return RD->getTemplateSpecializationKind() != TSK_Undeclared;
+      if (const auto *VD = dyn_cast<VarDecl>(D))
+        return VD->getTemplateSpecializationKind() != TSK_Undeclared;
+      return false;
+    }
+
+    void markShared(const void *Node) { Shared->Pointers.insert(Node); }
+    void markShared(const ast_type_traits::DynTypedNode &Node) {
+      Shared->Others.insert(Node);
+    }
 
     bool shouldVisitTemplateInstantiations() const {
       return true;
@@ -8911,6 +8945,8 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
           if (!Found)
             Vector->push_back(ParentStack.back());
         }
+        if (TemplateDepth)
+          markShared(MapNode);
       }
       ParentStack.push_back(createDynTypedNode(Node));
       bool Result = BaseTraverse();
@@ -8919,9 +8955,14 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
     }
 
     bool TraverseDecl(Decl *DeclNode) {
-      return TraverseNode(DeclNode, DeclNode,
-                          [&] { return VisitorBase::TraverseDecl(DeclNode); },
-                          Parents);
+      bool MayShare = DeclNode && mayShareNodes(DeclNode);
+      TemplateDepth += MayShare;
+      bool Result =
+          TraverseNode(DeclNode, DeclNode,
+                       [&] { return VisitorBase::TraverseDecl(DeclNode); },
+                       Parents);
+      TemplateDepth -= MayShare;
+      return Result;
     }
 
     bool TraverseStmt(Stmt *StmtNode) {
@@ -8948,7 +8989,10 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
 
     ASTContext::ParentMapPointers *Parents;
     ASTContext::ParentMapOtherNodes *OtherParents;
+    ASTContext::ParentMapSharedNodes *Shared;
     llvm::SmallVector<ast_type_traits::DynTypedNode, 16> ParentStack;
+    /// The number of declarations being traversed whose nodes may be shared.
+    unsigned TemplateDepth;
 
     friend class RecursiveASTVisitor<ParentMapASTVisitor>;
   };
@@ -8968,18 +9012,106 @@ static ASTContext::DynTypedNodeList getDynNodeFromMap(const NodeTy &Node,
   return getSingleDynTypedNodeFromParentMap(I->second);
 }
 
+bool ASTContext::addParentMapDecl(Decl *D) {
+  // BlockDecls and CapturedDecls are traversed through BlockExprs and
+  // CapturedStmts respectively, as in RecursiveASTVisitor.
+  if (isa<BlockDecl>(D) || isa<CapturedDecl>(D))
+    return false;
+  if (!ParentMapDecls.insert(D).second)
+    return false;
+
+  if (!PointerParents) {
+    PointerParents.reset(new ParentMapPointers);
+    OtherParents.reset(new ParentMapOtherNodes);
+    SharedParentNodes.reset(new ParentMapSharedNodes);
+  }
+  ParentMapASTVisitor::addTopLevelDecl(*getTranslationUnitDecl(), *D,
+                                       *PointerParents, *OtherParents,
+                                       *SharedParentNodes);
+  return true;
+}
+
+/// \brief Returns an iterator to the first top-level declaration after
+/// \p Last, or to the first one if \p Last is null.
+static DeclContext::decl_iterator nextTopLevelDecl(TranslationUnitDecl *TU,
+                                                   Decl *Last) {
+  if (!Last)
+    return TU->decls_begin();
+  return ++DeclContext::decl_iterator(Last);
+}
+
 ASTContext::DynTypedNodeList
 ASTContext::getParents(const ast_type_traits::DynTypedNode &Node) {
-  if (!PointerParents) {
-    // We always need to run over the whole translation unit, as
-    // hasAncestor can escape any subtree.
-    auto Maps = ParentMapASTVisitor::buildMap(*getTranslationUnitDecl());
-    PointerParents.reset(Maps.first);
-    OtherParents.reset(Maps.second);
-  }
-  if (Node.getNodeKind().hasPointerIdentity())
-    return getDynNodeFromMap(Node.getMemoizationData(), *PointerParents);
-  return getDynNodeFromMap(Node, *OtherParents);
+  auto FindParents = [&]() -> DynTypedNodeList {
+    if (!PointerParents)
+      return llvm::ArrayRef<ast_type_traits::DynTypedNode>();
+    if (Node.getNodeKind().hasPointerIdentity())
+      return getDynNodeFromMap(Node.getMemoizationData(), *PointerParents);
+    return getDynNodeFromMap(Node, *OtherParents);
+  };
+
+  // A node that may be shared with other top-level declarations only has
+  // all of its parents once every top-level declaration has been visited.
+  auto CompleteParents = [&](DynTypedNodeList Parents) -> DynTypedNodeList {
+    bool IsShared =
+        Node.getNodeKind().hasPointerIdentity()
+            ? SharedParentNodes->Pointers.count(Node.getMemoizationData())
+            : SharedParentNodes->Others.count(Node);
+    if (!IsShared)
+      return Parents;
+    buildParentMap();
+    return FindParents();
+  };
+
+  // Every node in the maps has at least one parent.
+  DynTypedNodeList Parents = FindParents();
+  if (!Parents.empty())
+    return CompleteParents(Parents);
+
+  // A declaration is usually only reachable from the top-level declaration
+  // that lexically contains it, so try that one first.
+  TranslationUnitDecl *TU = getTranslationUnitDecl();
+  if (const Decl *D = Node.get<Decl>()) {
+    if (D == TU)
+      return Parents;
+    const Decl *TopLevel = D;
+    const DeclContext *DC = TopLevel->getLexicalDeclContext();
+    while (DC && !isa<TranslationUnitDecl>(DC)) {
+      TopLevel = cast<Decl>(DC);
+      DC = TopLevel->getLexicalDeclContext();
+    }
+    Decl *Candidate = const_cast<Decl *>(TopLevel);
+    if (DC == TU && TU->containsDecl(Candidate) &&
+        addParentMapDecl(Candidate)) {
+      Parents = FindParents();
+      if (!Parents.empty())
+        return CompleteParents(Parents);
+    }
+  }
+
+  // Otherwise visit the remaining top-level declarations in order until the
+  // node turns up.
+  for (DeclContext::decl_iterator I = nextTopLevelDecl(TU, LastParentMapDecl),
+                                  E = TU->decls_end();
+       I != E; ++I) {
+    LastParentMapDecl = *I;
+    if (addParentMapDecl(*I)) {
+      Parents = FindParents();
+      if (!Parents.empty())
+        return CompleteParents(Parents);
+    }
+  }
+  return Parents;
+}
+
+void ASTContext::buildParentMap() {
+  TranslationUnitDecl *TU = getTranslationUnitDecl();
+  for (DeclContext::decl_iterator I = nextTopLevelDecl(TU, LastParentMapDecl),
+                                  E = TU->decls_end();
+       I != E; ++I) {
+    LastParentMapDecl = *I;
+    addParentMapDecl(*I);
+  }
 }
 
 bool
@@ -2794,6 +2794,10 @@ Decl *ASTNodeImporter::VisitFunctionDecl(FunctionDecl *D) {
   if (ToD)
     return ToD;
 
+  // A declaration without a body that the imported definition should be
+  // attached to as a redeclaration.
+  FunctionDecl *FoundWithoutBody = nullptr;
+
   // Try to find a function in our own ("to") context with the same name, same
   // type, and in the same context as the function we're importing.
   if (!LexicalDC->isFunctionOrMethod()) {
@@ -2810,6 +2814,17 @@ Decl *ASTNodeImporter::VisitFunctionDecl(FunctionDecl *D) {
             D->hasExternalFormalLinkage()) {
           if (Importer.IsStructurallyEquivalent(D->getType(), 
                                                 FoundFunction->getType())) {
+            // When asked to, import the definition of a function that is
+            // only declared in the "to" context as a redeclaration, so that
+            // the body becomes available there.
+            const FunctionDecl *FromBodyDecl = nullptr;
+            if (Importer.importsDefinitionsAsRedecls() &&
+                D->hasBody(FromBodyDecl) && FromBodyDecl == D &&
+                !FoundFunction->hasBody() && !isa<CXXMethodDecl>(D)) {
+              FoundWithoutBody = FoundFunction;
+              break;
+            }
+
             // FIXME: Actually try to merge the body and other attributes.
             return Importer.Imported(D, FoundFunction);
           }
@@ -2833,7 +2848,7 @@ Decl *ASTNodeImporter::VisitFunctionDecl(FunctionDecl *D) {
       ConflictingDecls.push_back(FoundDecls[I]);
     }
     
-    if (!ConflictingDecls.empty()) {
+    if (!ConflictingDecls.empty() && !FoundWithoutBody) {
       Name = Importer.HandleNameConflict(Name, DC, IDNS,
                                          ConflictingDecls.data(), 
                                          ConflictingDecls.size());
@@ -2936,6 +2951,8 @@ Decl *ASTNodeImporter::VisitFunctionDecl(FunctionDecl *D) {
   ToFunction->setVirtualAsWritten(D->isVirtualAsWritten());
   ToFunction->setTrivial(D->isTrivial());
   ToFunction->setPure(D->isPure());
+  if (FoundWithoutBody)
+    ToFunction->setPreviousDecl(FoundWithoutBody->getMostRecentDecl());
   Importer.Imported(D, ToFunction);
 
   // Set the parameters.
@@ -5444,7 +5461,8 @@ ASTImporter::ASTImporter(ASTContext &ToContext, FileManager &ToFileManager,
                          bool MinimalImport)
   : ToContext(ToContext), FromContext(FromContext),
     ToFileManager(ToFileManager), FromFileManager(FromFileManager),
-    Minimal(MinimalImport), LastDiagFromFrom(false)
+    Minimal(MinimalImport), DefinitionsAsRedecls(false),
+    LastDiagFromFrom(false)
 {
   ImportedDecls[FromContext.getTranslationUnitDecl()]
     = ToContext.getTranslationUnitDecl();
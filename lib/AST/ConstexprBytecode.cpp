@@ -0,0 +1,1081 @@
+//===--- ConstexprBytecode.cpp - Bytecode for constexpr functions ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the compiler from constexpr function bodies to
+// bytecode, and the interpreter for it.
+//
+// The bytecode is for a stack machine. Every value is an integer of at most
+// 64 bits, held in a uint64_t sign- or zero-extended from its width, and
+// every operation whose result depends on the type of its operands carries a
+// type code giving their width and signedness.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprBytecode.h"
+#include "clang/AST/APValue.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/APSInt.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MathExtras.h"
+#include <algorithm>
+
+using namespace clang;
+using llvm::APInt;
+using llvm::APSInt;
+
+namespace {
+enum Opcode : uint32_t {
+  /// Push the constant with the given index.
+  OP_Const,
+  /// Push the value of the given slot.
+  OP_Load,
+  /// Pop a value and store it to the given slot.
+  OP_Store,
+  /// Pop a value and discard it.
+  OP_Pop,
+  /// Convert the value on top of the stack to the given type.
+  OP_Cast,
+  /// Convert the value on top of the stack to bool.
+  OP_ToBool,
+  // Unary operators, with the type of the operand.
+  OP_Neg,
+  OP_BitNot,
+  OP_LNot,
+  OP_Inc,
+  OP_Dec,
+  // Binary operators, with the type of the left operand, and for shifts the
+  // type of the right operand.
+  OP_Add,
+  OP_Sub,
+  OP_Mul,
+  OP_Div,
+  OP_Rem,
+  OP_Shl,
+  OP_Shr,
+  OP_And,
+  OP_Or,
+  OP_Xor,
+  OP_LT,
+  OP_GT,
+  OP_LE,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  /// Jump to the given code offset.
+  OP_Jump,
+  /// Pop a value and jump to the given code offset if it is zero.
+  OP_JumpIfFalse,
+  /// Pop a value and jump to the given code offset if it is not zero.
+  OP_JumpIfTrue,
+  /// Call the callee with the given index, popping the given number of
+  /// arguments and pushing the result.
+  OP_Call,
+  /// Pop a value and return it.
+  OP_Ret,
+  /// Count an evaluation step.
+  OP_Step,
+  /// Give up on the evaluation.
+  OP_Fail
+};
+} // end anonymous namespace
+
+/// The type code of an integer type: its width and whether it is signed.
+typedef uint32_t TypeCode;
+
+static TypeCode makeTypeCode(unsigned Width, bool IsSigned) {
+  return Width << 1 | IsSigned;
+}
+static unsigned getWidth(TypeCode TC) { return TC >> 1; }
+static bool isSigned(TypeCode TC) { return TC & 1; }
+
+/// Bring the low bits of \p V into the representation of the type \p TC.
+static uint64_t normalize(uint64_t V, TypeCode TC) {
+  unsigned Width = getWidth(TC);
+  if (Width == 64)
+    return V;
+  if (isSigned(TC))
+    return static_cast<uint64_t>(llvm::SignExtend64(V, Width));
+  return V & ((uint64_t(1) << Width) - 1);
+}
+
+static APInt toAPInt(uint64_t V, TypeCode TC) {
+  return APInt(getWidth(TC), V, isSigned(TC));
+}
+
+static uint64_t fromAPInt(const APInt &V, TypeCode TC) {
+  return isSigned(TC) ? static_cast<uint64_t>(V.getSExtValue())
+                      : V.getZExtValue();
+}
+
+namespace clang {
+namespace bytecode {
+/// The bytecode of a function.
+struct Function {
+  SmallVector<uint32_t, 64> Code;
+  SmallVector<uint64_t, 8> Constants;
+  SmallVector<const FunctionDecl *, 4> Callees;
+  SmallVector<TypeCode, 4> ParamTypes;
+  TypeCode ResultType;
+  unsigned NumSlots;
+};
+} // end namespace bytecode
+} // end namespace clang
+
+//===----------------------------------------------------------------------===//
+// Compiler
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// Compiles a function body to bytecode. Every compile function returns false
+/// if it runs into something that the bytecode cannot express.
+class Compiler {
+  ASTContext &Ctx;
+  bytecode::Function &F;
+
+  /// The slots of the parameters and of the local variables whose
+  /// initialization has been compiled.
+  llvm::DenseMap<const VarDecl *, unsigned> Slots;
+
+  /// The jumps to patch at the end of a loop.
+  struct Loop {
+    SmallVector<unsigned, 4> Breaks;
+    SmallVector<unsigned, 4> Continues;
+  };
+  SmallVector<Loop *, 4> Loops;
+
+public:
+  Compiler(ASTContext &Ctx, bytecode::Function &F) : Ctx(Ctx), F(F) {}
+
+  bool compileFunction(const FunctionDecl *FD);
+
+private:
+  bool getTypeCode(QualType T, TypeCode &TC);
+
+  void emit(Opcode Op) { F.Code.push_back(Op); }
+  void emit(Opcode Op, uint32_t Operand) {
+    F.Code.push_back(Op);
+    F.Code.push_back(Operand);
+  }
+  void emit(Opcode Op, uint32_t Operand1, uint32_t Operand2) {
+    F.Code.push_back(Op);
+    F.Code.push_back(Operand1);
+    F.Code.push_back(Operand2);
+  }
+  void emitConst(uint64_t V) {
+    F.Constants.push_back(V);
+    emit(OP_Const, F.Constants.size() - 1);
+  }
+
+  /// Emit a jump whose target is patched later, and return the position of
+  /// its target.
+  unsigned emitJump(Opcode Op) {
+    emit(Op, 0);
+    return F.Code.size() - 1;
+  }
+  void patchJump(unsigned Pos, unsigned Target) { F.Code[Pos] = Target; }
+  unsigned here() const { return F.Code.size(); }
+
+  bool compileStmt(const Stmt *S);
+  bool compileVarDecl(const VarDecl *VD);
+  bool compileLoopBody(const Stmt *Body, Loop &L);
+  void finishLoop(Loop &L, unsigned ContinueTarget, unsigned BreakTarget);
+
+  bool compileRValue(const Expr *E);
+  bool compileLValue(const Expr *E, unsigned &Slot);
+  bool compileDiscarded(const Expr *E);
+  bool compileCast(const CastExpr *E);
+  bool compileBinaryOperator(const BinaryOperator *E);
+  bool compileCompoundAssign(const CompoundAssignOperator *E, unsigned &Slot);
+  bool compileCall(const CallExpr *E);
+  bool compileConstantRead(const Expr *E);
+
+  static Opcode getBinaryOpcode(BinaryOperatorKind Opc);
+};
+} // end anonymous namespace
+
+bool Compiler::getTypeCode(QualType T, TypeCode &TC) {
+  if (T.isVolatileQualified() || !T->isIntegralOrEnumerationType() ||
+      T->isAtomicType())
+    return false;
+  unsigned Width = Ctx.getIntWidth(T);
+  if (Width == 0 || Width > 64)
+    return false;
+  TC = makeTypeCode(Width, !T->isUnsignedIntegerOrEnumerationType());
+  return true;
+}
+
+bool Compiler::compileFunction(const FunctionDecl *FD) {
+  const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD);
+  if ((MD && MD->isInstance()) || FD->isVariadic() ||
+      !getTypeCode(FD->getReturnType(), F.ResultType))
+    return false;
+
+  const CompoundStmt *Body = dyn_cast_or_null<CompoundStmt>(FD->getBody());
+  if (!Body)
+    return false;
+
+  for (const ParmVarDecl *Param : FD->parameters()) {
+    TypeCode TC;
+    if (!getTypeCode(Param->getType(), TC))
+      return false;
+    F.ParamTypes.push_back(TC);
+    unsigned Slot = Slots.size();
+    Slots[Param] = Slot;
+  }
+  F.NumSlots = Slots.size();
+
+  if (!compileStmt(Body))
+    return false;
+
+  // Flowing off the end of the function is left to the tree walker to
+  // diagnose.
+  emit(OP_Fail);
+  return true;
+}
+
+bool Compiler::compileStmt(const Stmt *S) {
+  // Mirror the steps counted by the tree walker, which counts every
+  // statement it evaluates.
+  emit(OP_Step);
+
+  switch (S->getStmtClass()) {
+  default:
+    if (const Expr *E = dyn_cast<Expr>(S))
+      return compileDiscarded(E);
+    return false;
+
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const Stmt *Child : cast<CompoundStmt>(S)->body())
+      if (!compileStmt(Child))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    // Declarations of anything but variables have no effect on evaluation.
+    for (const Decl *D : cast<DeclStmt>(S)->decls())
+      if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+        if (!compileVarDecl(VD))
+          return false;
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *RetExpr = cast<ReturnStmt>(S)->getRetValue();
+    TypeCode TC;
+    if (!RetExpr || !getTypeCode(RetExpr->getType(), TC) ||
+        TC != F.ResultType || !compileRValue(RetExpr))
+      return false;
+    emit(OP_Ret);
+    return true;
+  }
+
+  case Stmt::IfStmtClass: {
+    const IfStmt *IS = cast<IfStmt>(S);
+    if (IS->getConditionVariable() || !compileRValue(IS->getCond()))
+      return false;
+    unsigned ToElse = emitJump(OP_JumpIfFalse);
+    if (!compileStmt(IS->getThen()))
+      return false;
+    if (const Stmt *Else = IS->getElse()) {
+      unsigned ToEnd = emitJump(OP_Jump);
+      patchJump(ToElse, here());
+      if (!compileStmt(Else))
+        return false;
+      patchJump(ToEnd, here());
+    } else {
+      patchJump(ToElse, here());
+    }
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const WhileStmt *WS = cast<WhileStmt>(S);
+    if (WS->getConditionVariable())
+      return false;
+    Loop L;
+    unsigned Top = here();
+    if (!compileRValue(WS->getCond()))
+      return false;
+    L.Breaks.push_back(emitJump(OP_JumpIfFalse));
+    if (!compileLoopBody(WS->getBody(), L))
+      return false;
+    emit(OP_Jump, Top);
+    finishLoop(L, Top, here());
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const DoStmt *DS = cast<DoStmt>(S);
+    Loop L;
+    unsigned Top = here();
+    if (!compileLoopBody(DS->getBody(), L))
+      return false;
+    unsigned Cond = here();
+    if (!compileRValue(DS->getCond()))
+      return false;
+    emit(OP_JumpIfTrue, Top);
+    finishLoop(L, Cond, here());
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const ForStmt *FS = cast<ForStmt>(S);
+    if (FS->getConditionVariable())
+      return false;
+    if (FS->getInit() && !compileStmt(FS->getInit()))
+      return false;
+    Loop L;
+    unsigned Top = here();
+    if (const Expr *Cond = FS->getCond()) {
+      if (!compileRValue(Cond))
+        return false;
+      L.Breaks.push_back(emitJump(OP_JumpIfFalse));
+    }
+    if (!compileLoopBody(FS->getBody(), L))
+      return false;
+    unsigned Inc = here();
+    if (FS->getInc() && !compileDiscarded(FS->getInc()))
+      return false;
+    emit(OP_Jump, Top);
+    finishLoop(L, Inc, here());
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back()->Breaks.push_back(emitJump(OP_Jump));
+    return true;
+
+  case Stmt::ContinueStmtClass:
+    if (Loops.empty())
+      return false;
+    Loops.back()->Continues.push_back(emitJump(OP_Jump));
+    return true;
+  }
+}
+
+bool Compiler::compileVarDecl(const VarDecl *VD) {
+  TypeCode TC;
+  const Expr *Init = VD->getInit();
+  if (!VD->hasLocalStorage() || !getTypeCode(VD->getType(), TC) || !Init)
+    return false;
+
+  // The variable only gets its slot once its initializer has been compiled,
+  // so that reading it in its own initializer is not compiled.
+  if (!compileRValue(Init))
+    return false;
+  unsigned Slot = F.NumSlots++;
+  Slots[VD] = Slot;
+  emit(OP_Store, Slot);
+  return true;
+}
+
+bool Compiler::compileLoopBody(const Stmt *Body, Loop &L) {
+  Loops.push_back(&L);
+  bool Result = compileStmt(Body);
+  Loops.pop_back();
+  return Result;
+}
+
+void Compiler::finishLoop(Loop &L, unsigned ContinueTarget,
+                          unsigned BreakTarget) {
+  for (unsigned Pos : L.Continues)
+    patchJump(Pos, ContinueTarget);
+  for (unsigned Pos : L.Breaks)
+    patchJump(Pos, BreakTarget);
+}
+
+bool Compiler::compileRValue(const Expr *E) {
+  TypeCode TC;
+  if (E->isGLValue() || !getTypeCode(E->getType(), TC))
+    return false;
+
+  switch (E->getStmtClass()) {
+  default:
+    return false;
+
+  case Stmt::IntegerLiteralClass:
+    emitConst(fromAPInt(cast<IntegerLiteral>(E)->getValue(), TC));
+    return true;
+  case Stmt::CharacterLiteralClass:
+    emitConst(normalize(cast<CharacterLiteral>(E)->getValue(), TC));
+    return true;
+  case Stmt::CXXBoolLiteralExprClass:
+    emitConst(cast<CXXBoolLiteralExpr>(E)->getValue());
+    return true;
+  case Stmt::ImplicitValueInitExprClass:
+  case Stmt::CXXScalarValueInitExprClass:
+    emitConst(0);
+    return true;
+
+  case Stmt::DeclRefExprClass: {
+    const EnumConstantDecl *ECD =
+        dyn_cast<EnumConstantDecl>(cast<DeclRefExpr>(E)->getDecl());
+    if (!ECD)
+      return false;
+    APSInt Value = ECD->getInitVal();
+    emitConst(fromAPInt(Value.extOrTrunc(getWidth(TC)), TC));
+    return true;
+  }
+
+  case Stmt::ParenExprClass:
+    return compileRValue(cast<ParenExpr>(E)->getSubExpr());
+  case Stmt::CXXDefaultArgExprClass:
+    return compileRValue(cast<CXXDefaultArgExpr>(E)->getExpr());
+  case Stmt::SubstNonTypeTemplateParmExprClass:
+    return compileRValue(
+        cast<SubstNonTypeTemplateParmExpr>(E)->getReplacement());
+  case Stmt::ExprWithCleanupsClass:
+    if (cast<ExprWithCleanups>(E)->getNumObjects())
+      return false;
+    return compileRValue(cast<ExprWithCleanups>(E)->getSubExpr());
+
+  case Stmt::InitListExprClass: {
+    const InitListExpr *ILE = cast<InitListExpr>(E);
+    if (ILE->getNumInits() == 0) {
+      emitConst(0);
+      return true;
+    }
+    return ILE->getNumInits() == 1 && compileRValue(ILE->getInit(0));
+  }
+
+  case Stmt::ImplicitCastExprClass:
+  case Stmt::CStyleCastExprClass:
+  case Stmt::CXXFunctionalCastExprClass:
+  case Stmt::CXXStaticCastExprClass:
+    return compileCast(cast<CastExpr>(E));
+
+  case Stmt::UnaryOperatorClass: {
+    const UnaryOperator *UO = cast<UnaryOperator>(E);
+    const Expr *Sub = UO->getSubExpr();
+    unsigned Slot;
+    switch (UO->getOpcode()) {
+    default:
+      return false;
+    case UO_Plus:
+      return compileRValue(Sub);
+    case UO_Minus:
+      if (!compileRValue(Sub))
+        return false;
+      emit(OP_Neg, TC);
+      return true;
+    case UO_Not:
+      if (!compileRValue(Sub))
+        return false;
+      emit(OP_BitNot, TC);
+      return true;
+    case UO_LNot:
+      if (!compileRValue(Sub))
+        return false;
+      emit(OP_LNot);
+      return true;
+    case UO_PostInc:
+    case UO_PostDec:
+      if (!Ctx.getLangOpts().CPlusPlus14 || Sub->getType()->isBooleanType() ||
+          !compileLValue(Sub, Slot))
+        return false;
+      emit(OP_Load, Slot);
+      emit(OP_Load, Slot);
+      emit(UO->isIncrementOp() ? OP_Inc : OP_Dec, TC);
+      emit(OP_Store, Slot);
+      return true;
+    }
+    llvm_unreachable("unhandled unary operator");
+  }
+
+  case Stmt::BinaryOperatorClass:
+    return compileBinaryOperator(cast<BinaryOperator>(E));
+
+  case Stmt::ConditionalOperatorClass: {
+    const ConditionalOperator *CO = cast<ConditionalOperator>(E);
+    if (!compileRValue(CO->getCond()))
+      return false;
+    unsigned ToFalse = emitJump(OP_JumpIfFalse);
+    if (!compileRValue(CO->getTrueExpr()))
+      return false;
+    unsigned ToEnd = emitJump(OP_Jump);
+    patchJump(ToFalse, here());
+    if (!compileRValue(CO->getFalseExpr()))
+      return false;
+    patchJump(ToEnd, here());
+    return true;
+  }
+
+  case Stmt::CallExprClass:
+  case Stmt::CXXOperatorCallExprClass:
+    return compileCall(cast<CallExpr>(E));
+  }
+}
+
+bool Compiler::compileCast(const CastExpr *E) {
+  const Expr *Sub = E->getSubExpr();
+  TypeCode TC;
+  if (!getTypeCode(E->getType(), TC))
+    return false;
+
+  switch (E->getCastKind()) {
+  default:
+    return false;
+
+  case CK_LValueToRValue: {
+    if (Sub->getType().isVolatileQualified())
+      return false;
+    unsigned Slot;
+    if (compileLValue(Sub, Slot)) {
+      emit(OP_Load, Slot);
+      return true;
+    }
+    return compileConstantRead(Sub);
+  }
+
+  case CK_NoOp:
+    return compileRValue(Sub);
+
+  case CK_IntegralCast:
+    if (!compileRValue(Sub))
+      return false;
+    emit(OP_Cast, TC);
+    return true;
+
+  case CK_IntegralToBoolean:
+    if (!compileRValue(Sub))
+      return false;
+    emit(OP_ToBool);
+    return true;
+  }
+}
+
+bool Compiler::compileConstantRead(const Expr *E) {
+  // A variable outside the function can be read if it is usable in constant
+  // expressions, such as a constexpr variable at namespace scope.
+  const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens());
+  if (!DRE)
+    return false;
+  const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+  TypeCode TC;
+  if (!VD || VD->hasLocalStorage() || VD->isWeak() ||
+      !VD->isUsableInConstantExpressions(Ctx) ||
+      !getTypeCode(VD->getType(), TC))
+    return false;
+  // The initializer may be on another declaration, such as the out-of-line
+  // definition of a static data member, or nowhere; leave the latter to the
+  // tree walker, which diagnoses it.
+  const VarDecl *Def;
+  const Expr *Init = VD->getAnyInitializer(Def);
+  if (!Init || Init->isValueDependent())
+    return false;
+  // The tree walker notes initializers that are not integral constant
+  // expressions, even if they can be evaluated.
+  const APValue *Value = Def->evaluateValue();
+  if (!Value || !Value->isInt() || !Def->checkInitIsICE())
+    return false;
+  emitConst(fromAPInt(Value->getInt().extOrTrunc(getWidth(TC)), TC));
+  return true;
+}
+
+Opcode Compiler::getBinaryOpcode(BinaryOperatorKind Opc) {
+  switch (Opc) {
+  case BO_Mul: case BO_MulAssign: return OP_Mul;
+  case BO_Div: case BO_DivAssign: return OP_Div;
+  case BO_Rem: case BO_RemAssign: return OP_Rem;
+  case BO_Add: case BO_AddAssign: return OP_Add;
+  case BO_Sub: case BO_SubAssign: return OP_Sub;
+  case BO_Shl: case BO_ShlAssign: return OP_Shl;
+  case BO_Shr: case BO_ShrAssign: return OP_Shr;
+  case BO_And: case BO_AndAssign: return OP_And;
+  case BO_Xor: case BO_XorAssign: return OP_Xor;
+  case BO_Or:  case BO_OrAssign:  return OP_Or;
+  case BO_LT: return OP_LT;
+  case BO_GT: return OP_GT;
+  case BO_LE: return OP_LE;
+  case BO_GE: return OP_GE;
+  case BO_EQ: return OP_EQ;
+  case BO_NE: return OP_NE;
+  default: return OP_Fail;
+  }
+}
+
+bool Compiler::compileBinaryOperator(const BinaryOperator *E) {
+  const Expr *LHS = E->getLHS(), *RHS = E->getRHS();
+  BinaryOperatorKind Opc = E->getOpcode();
+
+  switch (Opc) {
+  case BO_Comma:
+    return compileDiscarded(LHS) && compileRValue(RHS);
+
+  case BO_LAnd:
+  case BO_LOr: {
+    if (!compileRValue(LHS))
+      return false;
+    unsigned ToShortCircuit =
+        emitJump(Opc == BO_LAnd ? OP_JumpIfFalse : OP_JumpIfTrue);
+    if (!compileRValue(RHS))
+      return false;
+    unsigned ToEnd = emitJump(OP_Jump);
+    patchJump(ToShortCircuit, here());
+    emitConst(Opc == BO_LOr);
+    patchJump(ToEnd, here());
+    return true;
+  }
+
+  default:
+    break;
+  }
+
+  Opcode Op = getBinaryOpcode(Opc);
+  TypeCode LHSType, RHSType;
+  if (Op == OP_Fail || !getTypeCode(LHS->getType(), LHSType) ||
+      !getTypeCode(RHS->getType(), RHSType))
+    return false;
+  // Apart from shifts, the usual arithmetic conversions have given both
+  // operands the same type.
+  if (Op != OP_Shl && Op != OP_Shr && LHSType != RHSType)
+    return false;
+  if (!compileRValue(LHS) || !compileRValue(RHS))
+    return false;
+  if (Op == OP_Shl || Op == OP_Shr)
+    emit(Op, LHSType, RHSType);
+  else
+    emit(Op, LHSType);
+  return true;
+}
+
+bool Compiler::compileCompoundAssign(const CompoundAssignOperator *E,
+                                     unsigned &Slot) {
+  Opcode Op = getBinaryOpcode(E->getOpcode());
+  TypeCode LHSType, CompType, RHSType;
+  if (Op == OP_Fail || !getTypeCode(E->getLHS()->getType(), LHSType) ||
+      !getTypeCode(E->getComputationResultType(), CompType) ||
+      !getTypeCode(E->getRHS()->getType(), RHSType))
+    return false;
+  TypeCode CompLHSType;
+  if (!getTypeCode(E->getComputationLHSType(), CompLHSType) ||
+      CompLHSType != CompType ||
+      (Op != OP_Shl && Op != OP_Shr && RHSType != CompType))
+    return false;
+
+  if (!compileLValue(E->getLHS(), Slot))
+    return false;
+  emit(OP_Load, Slot);
+  emit(OP_Cast, CompType);
+  if (!compileRValue(E->getRHS()))
+    return false;
+  if (Op == OP_Shl || Op == OP_Shr)
+    emit(Op, CompType, RHSType);
+  else
+    emit(Op, CompType);
+  emit(OP_Cast, LHSType);
+  emit(OP_Store, Slot);
+  return true;
+}
+
+bool Compiler::compileLValue(const Expr *E, unsigned &Slot) {
+  switch (E->getStmtClass()) {
+  default:
+    return false;
+
+  case Stmt::ParenExprClass:
+    return compileLValue(cast<ParenExpr>(E)->getSubExpr(), Slot);
+
+  case Stmt::DeclRefExprClass: {
+    const VarDecl *VD = dyn_cast<VarDecl>(cast<DeclRefExpr>(E)->getDecl());
+    if (!VD)
+      return false;
+    llvm::DenseMap<const VarDecl *, unsigned>::iterator Known =
+        Slots.find(VD);
+    if (Known == Slots.end())
+      return false;
+    Slot = Known->second;
+    return true;
+  }
+
+  case Stmt::ImplicitCastExprClass: {
+    const ImplicitCastExpr *ICE = cast<ImplicitCastExpr>(E);
+    return ICE->getCastKind() == CK_NoOp && ICE->isGLValue() &&
+           compileLValue(ICE->getSubExpr(), Slot);
+  }
+
+  case Stmt::UnaryOperatorClass: {
+    const UnaryOperator *UO = cast<UnaryOperator>(E);
+    TypeCode TC;
+    if (!UO->isPrefix() || !UO->isIncrementDecrementOp() ||
+        !Ctx.getLangOpts().CPlusPlus14 || E->getType()->isBooleanType() ||
+        !getTypeCode(E->getType(), TC) ||
+        !compileLValue(UO->getSubExpr(), Slot))
+      return false;
+    emit(OP_Load, Slot);
+    emit(UO->isIncrementOp() ? OP_Inc : OP_Dec, TC);
+    emit(OP_Store, Slot);
+    return true;
+  }
+
+  case Stmt::BinaryOperatorClass: {
+    const BinaryOperator *BO = cast<BinaryOperator>(E);
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) &&
+             compileLValue(BO->getRHS(), Slot);
+    TypeCode TC;
+    if (BO->getOpcode() != BO_Assign || !Ctx.getLangOpts().CPlusPlus14 ||
+        !getTypeCode(E->getType(), TC) || !compileLValue(BO->getLHS(), Slot) ||
+        !compileRValue(BO->getRHS()))
+      return false;
+    emit(OP_Store, Slot);
+    return true;
+  }
+
+  case Stmt::CompoundAssignOperatorClass:
+    return Ctx.getLangOpts().CPlusPlus14 &&
+           compileCompoundAssign(cast<CompoundAssignOperator>(E), Slot);
+  }
+}
+
+bool Compiler::compileDiscarded(const Expr *E) {
+  E = E->IgnoreParens();
+
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return compileDiscarded(CE->getSubExpr());
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) && compileDiscarded(BO->getRHS());
+
+  // A postfix increment or decrement whose value is unused is a prefix one.
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+    TypeCode TC;
+    unsigned Slot;
+    if (UO->isPostfix() && UO->isIncrementDecrementOp()) {
+      if (!Ctx.getLangOpts().CPlusPlus14 || E->getType()->isBooleanType() ||
+          !getTypeCode(E->getType(), TC) ||
+          !compileLValue(UO->getSubExpr(), Slot))
+        return false;
+      emit(OP_Load, Slot);
+      emit(UO->isIncrementOp() ? OP_Inc : OP_Dec, TC);
+      emit(OP_Store, Slot);
+      return true;
+    }
+  }
+
+  if (E->isGLValue()) {
+    unsigned Slot;
+    return compileLValue(E, Slot);
+  }
+
+  if (!compileRValue(E))
+    return false;
+  emit(OP_Pop);
+  return true;
+}
+
+bool Compiler::compileCall(const CallExpr *E) {
+  const FunctionDecl *Callee = E->getDirectCallee();
+  const CXXMethodDecl *MD = dyn_cast_or_null<CXXMethodDecl>(Callee);
+  if (!Callee || Callee->getBuiltinID() || (MD && MD->isInstance()))
+    return false;
+
+  // Only direct calls are compiled; calls through function pointers would
+  // need the pointer to be evaluated.
+  const ImplicitCastExpr *ICE =
+      dyn_cast<ImplicitCastExpr>(E->getCallee()->IgnoreParens());
+  if (!ICE || ICE->getCastKind() != CK_FunctionToPointerDecay ||
+      !isa<DeclRefExpr>(ICE->getSubExpr()->IgnoreParens()))
+    return false;
+
+  if (E->getNumArgs() != Callee->getNumParams())
+    return false;
+  for (const Expr *Arg : E->arguments())
+    if (!compileRValue(Arg))
+      return false;
+
+  F.Callees.push_back(Callee);
+  emit(OP_Call, F.Callees.size() - 1, E->getNumArgs());
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Interpreter
+//===----------------------------------------------------------------------===//
+
+namespace {
+class Interpreter {
+  ConstexprBytecode &Bytecode;
+  unsigned &StepsLeft;
+  unsigned MaxDepth;
+
+public:
+  Interpreter(ConstexprBytecode &Bytecode, unsigned &StepsLeft,
+              unsigned MaxDepth)
+      : Bytecode(Bytecode), StepsLeft(StepsLeft), MaxDepth(MaxDepth) {}
+
+  bool run(const bytecode::Function &F, ArrayRef<uint64_t> Args,
+           unsigned Depth, uint64_t &Result);
+
+private:
+  static bool binaryOp(Opcode Op, TypeCode TC, uint64_t L, uint64_t R,
+                       uint64_t &Result);
+  static bool shift(Opcode Op, TypeCode LHSType, TypeCode RHSType,
+                    uint64_t L, uint64_t R, uint64_t &Result);
+};
+} // end anonymous namespace
+
+/// Perform an arithmetic, bitwise or comparison operation. Fails on signed
+/// overflow and on division by zero, which the tree walker diagnoses.
+bool Interpreter::binaryOp(Opcode Op, TypeCode TC, uint64_t L, uint64_t R,
+                           uint64_t &Result) {
+  APInt LHS = toAPInt(L, TC), RHS = toAPInt(R, TC);
+  bool Signed = isSigned(TC);
+  bool Overflow = false;
+  APInt Value;
+  switch (Op) {
+  case OP_Add:
+    Value = Signed ? LHS.sadd_ov(RHS, Overflow) : LHS + RHS;
+    break;
+  case OP_Sub:
+    Value = Signed ? LHS.ssub_ov(RHS, Overflow) : LHS - RHS;
+    break;
+  case OP_Mul:
+    Value = Signed ? LHS.smul_ov(RHS, Overflow) : LHS * RHS;
+    break;
+  case OP_Div:
+    if (!RHS)
+      return false;
+    Value = Signed ? LHS.sdiv_ov(RHS, Overflow) : LHS.udiv(RHS);
+    break;
+  case OP_Rem:
+    if (!RHS || (Signed && LHS.isMinSignedValue() && RHS.isAllOnesValue()))
+      return false;
+    Value = Signed ? LHS.srem(RHS) : LHS.urem(RHS);
+    break;
+  case OP_And: Value = LHS & RHS; break;
+  case OP_Or:  Value = LHS | RHS; break;
+  case OP_Xor: Value = LHS ^ RHS; break;
+  case OP_LT: Result = Signed ? LHS.slt(RHS) : LHS.ult(RHS); return true;
+  case OP_GT: Result = Signed ? LHS.sgt(RHS) : LHS.ugt(RHS); return true;
+  case OP_LE: Result = Signed ? LHS.sle(RHS) : LHS.ule(RHS); return true;
+  case OP_GE: Result = Signed ? LHS.sge(RHS) : LHS.uge(RHS); return true;
+  case OP_EQ: Result = LHS == RHS; return true;
+  case OP_NE: Result = LHS != RHS; return true;
+  default:
+    llvm_unreachable("not a binary operator");
+  }
+  if (Overflow)
+    return false;
+  Result = fromAPInt(Value, TC);
+  return true;
+}
+
+/// Perform a shift. Fails on every shift that the tree walker notes as not
+/// being a constant expression: by a negative amount or by at least the
+/// width of the left operand, and left shifts of negative values or that
+/// discard bits of a signed value.
+bool Interpreter::shift(Opcode Op, TypeCode LHSType, TypeCode RHSType,
+                        uint64_t L, uint64_t R, uint64_t &Result) {
+  unsigned Width = getWidth(LHSType);
+  if ((isSigned(RHSType) && static_cast<int64_t>(R) < 0) || R >= Width)
+    return false;
+  unsigned Amount = static_cast<unsigned>(R);
+  APInt LHS = toAPInt(L, LHSType);
+  if (Op == OP_Shr) {
+    Result = fromAPInt(isSigned(LHSType) ? LHS.ashr(Amount)
+                                         : LHS.lshr(Amount),
+                       LHSType);
+    return true;
+  }
+  if (isSigned(LHSType) &&
+      (LHS.isNegative() || LHS.countLeadingZeros() < Amount))
+    return false;
+  Result = fromAPInt(LHS.shl(Amount), LHSType);
+  return true;
+}
+
+bool Interpreter::run(const bytecode::Function &F, ArrayRef<uint64_t> Args,
+                      unsigned Depth, uint64_t &Result) {
+  SmallVector<uint64_t, 16> Slots(F.NumSlots);
+  std::copy(Args.begin(), Args.end(), Slots.begin());
+  SmallVector<uint64_t, 16> Stack;
+
+  const uint32_t *Code = F.Code.data();
+  unsigned PC = 0;
+  while (true) {
+    Opcode Op = static_cast<Opcode>(Code[PC++]);
+    switch (Op) {
+    case OP_Const:
+      Stack.push_back(F.Constants[Code[PC++]]);
+      break;
+    case OP_Load:
+      Stack.push_back(Slots[Code[PC++]]);
+      break;
+    case OP_Store:
+      Slots[Code[PC++]] = Stack.pop_back_val();
+      break;
+    case OP_Pop:
+      Stack.pop_back();
+      break;
+    case OP_Cast:
+      Stack.back() = normalize(Stack.back(), Code[PC++]);
+      break;
+    case OP_ToBool:
+      Stack.back() = Stack.back() != 0;
+      break;
+
+    case OP_Neg: {
+      TypeCode TC = Code[PC++];
+      APInt V = toAPInt(Stack.back(), TC);
+      if (isSigned(TC) && V.isMinSignedValue())
+        return false;
+      Stack.back() = fromAPInt(-V, TC);
+      break;
+    }
+    case OP_BitNot: {
+      TypeCode TC = Code[PC++];
+      Stack.back() = fromAPInt(~toAPInt(Stack.back(), TC), TC);
+      break;
+    }
+    case OP_LNot:
+      Stack.back() = Stack.back() == 0;
+      break;
+    case OP_Inc:
+    case OP_Dec: {
+      TypeCode TC = Code[PC++];
+      uint64_t One = 1;
+      if (!binaryOp(Op == OP_Inc ? OP_Add : OP_Sub, TC, Stack.back(), One,
+                    Stack.back()))
+        return false;
+      break;
+    }
+
+    case OP_Add: case OP_Sub: case OP_Mul: case OP_Div: case OP_Rem:
+    case OP_And: case OP_Or: case OP_Xor:
+    case OP_LT: case OP_GT: case OP_LE: case OP_GE: case OP_EQ: case OP_NE: {
+      TypeCode TC = Code[PC++];
+      uint64_t R = Stack.pop_back_val();
+      if (!binaryOp(Op, TC, Stack.back(), R, Stack.back()))
+        return false;
+      break;
+    }
+    case OP_Shl:
+    case OP_Shr: {
+      TypeCode LHSType = Code[PC++];
+      TypeCode RHSType = Code[PC++];
+      uint64_t R = Stack.pop_back_val();
+      if (!shift(Op, LHSType, RHSType, Stack.back(), R, Stack.back()))
+        return false;
+      break;
+    }
+
+    case OP_Jump:
+      PC = Code[PC];
+      break;
+    case OP_JumpIfFalse:
+    case OP_JumpIfTrue: {
+      bool Cond = Stack.pop_back_val() != 0;
+      if (Cond == (Op == OP_JumpIfTrue))
+        PC = Code[PC];
+      else
+        ++PC;
+      break;
+    }
+
+    case OP_Call: {
+      const FunctionDecl *Callee = F.Callees[Code[PC++]];
+      unsigned NumArgs = Code[PC++];
+      const FunctionDecl *Definition = nullptr;
+      if (Depth >= MaxDepth || !Callee->getBody(Definition) ||
+          !Definition->isConstexpr() || Definition->isInvalidDecl())
+        return false;
+      const bytecode::Function *CalleeF = Bytecode.getFunction(Definition);
+      if (!CalleeF)
+        return false;
+      uint64_t CallResult;
+      ArrayRef<uint64_t> CallArgs(Stack.end() - NumArgs, Stack.end());
+      if (!run(*CalleeF, CallArgs, Depth + 1, CallResult))
+        return false;
+      Stack.resize(Stack.size() - NumArgs);
+      Stack.push_back(CallResult);
+      break;
+    }
+
+    case OP_Ret:
+      Result = Stack.pop_back_val();
+      return true;
+
+    case OP_Step:
+      if (!StepsLeft)
+        return false;
+      --StepsLeft;
+      break;
+
+    case OP_Fail:
+      return false;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// ConstexprBytecode
+//===----------------------------------------------------------------------===//
+
+ConstexprBytecode::ConstexprBytecode(ASTContext &Ctx) : Ctx(Ctx) {}
+
+ConstexprBytecode::~ConstexprBytecode() {}
+
+const bytecode::Function *
+ConstexprBytecode::getFunction(const FunctionDecl *Definition) {
+  auto Known = Functions.find(Definition);
+  if (Known != Functions.end())
+    return Known->second.get();
+
+  // Compiling may evaluate the initializers of constants, and so add other
+  // functions to the map; don't hold on to an entry across it.
+  std::unique_ptr<bytecode::Function> F(new bytecode::Function);
+  if (!Compiler(Ctx, *F).compileFunction(Definition))
+    F.reset();
+  const bytecode::Function *Result = F.get();
+  Functions[Definition] = std::move(F);
+  return Result;
+}
+
+bool ConstexprBytecode::evaluateCall(const FunctionDecl *Definition,
+                                     ArrayRef<APValue> Args,
+                                     unsigned &StepsLeft, unsigned Depth,
+                                     APValue &Result) {
+  const bytecode::Function *F = getFunction(Definition);
+  if (!F || Args.size() != F->ParamTypes.size())
+    return false;
+
+  SmallVector<uint64_t, 8> ArgValues;
+  for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+    if (!Args[I].isInt())
+      return false;
+    TypeCode TC = F->ParamTypes[I];
+    ArgValues.push_back(
+        fromAPInt(Args[I].getInt().extOrTrunc(getWidth(TC)), TC));
+  }
+
+  // Only commit the steps if the call is evaluated, so that the tree walker
+  // gets the same budget otherwise.
+  unsigned Steps = StepsLeft;
+  uint64_t Value;
+  if (!Interpreter(*this, Steps, Ctx.getLangOpts().ConstexprCallDepth)
+           .run(*F, ArgValues, Depth, Value))
+    return false;
+
+  StepsLeft = Steps;
+  Result = APValue(APSInt(toAPInt(Value, F->ResultType),
+                          !isSigned(F->ResultType)));
+  return true;
+}
@@ -0,0 +1,84 @@
+//===--- ConstexprBytecode.h - Bytecode for constexpr functions -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides a compact bytecode for the constexpr functions that only
+// compute with integers, and an interpreter for it, which the constant
+// evaluator uses in place of walking the function bodies when
+// -fexperimental-constexpr-bytecode is given.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRBYTECODE_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRBYTECODE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+
+namespace clang {
+
+class APValue;
+class ASTContext;
+class FunctionDecl;
+
+namespace bytecode {
+struct Function;
+}
+
+/// Compiles constexpr functions to bytecode on first use, and evaluates
+/// calls to them.
+///
+/// A function is compiled if its parameters, its local variables and its
+/// result are all of integral or enumeration type, and its body only uses
+/// structured control flow and integer arithmetic, comparisons, assignments
+/// and calls to other such functions. Values live in typed slots as plain
+/// 64-bit integers rather than as APValues.
+///
+/// The interpreter never diagnoses anything. Whenever a call cannot be
+/// evaluated, because a function cannot be compiled or because evaluation
+/// runs into anything that the tree-walking evaluator would diagnose or
+/// handle specially (overflow, division by zero, an out-of-range shift,
+/// exceeding the step or depth limit, flowing off the end of the function),
+/// it fails without any effect, and the call is left to the tree walker.
+class ConstexprBytecode {
+  ASTContext &Ctx;
+
+  /// The compiled functions, keyed by their definitions. A null entry
+  /// records that a function cannot be compiled.
+  llvm::DenseMap<const FunctionDecl *, std::unique_ptr<bytecode::Function>>
+      Functions;
+
+  ConstexprBytecode(const ConstexprBytecode &) = delete;
+  void operator=(const ConstexprBytecode &) = delete;
+
+public:
+  explicit ConstexprBytecode(ASTContext &Ctx);
+  ~ConstexprBytecode();
+
+  /// Retrieve the bytecode for the function definition \p Definition,
+  /// compiling it if it has not been compiled yet, or null if it cannot be
+  /// compiled.
+  const bytecode::Function *getFunction(const FunctionDecl *Definition);
+
+  /// Evaluate a call to the constexpr function definition \p Definition with
+  /// the arguments \p Args.
+  ///
+  /// \param StepsLeft The remaining number of evaluation steps. It is only
+  /// updated if the call is evaluated.
+  /// \param Depth The call depth of the call to \p Definition.
+  ///
+  /// \returns true and sets \p Result if the call was evaluated; false if it
+  /// has to be evaluated by the tree walker instead.
+  bool evaluateCall(const FunctionDecl *Definition, ArrayRef<APValue> Args,
+                    unsigned &StepsLeft, unsigned Depth, APValue &Result);
+};
+
+} // end namespace clang
+
+#endif
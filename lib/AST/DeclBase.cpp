@@ -1321,14 +1321,29 @@ StoredDeclsMap *DeclContext::buildLookup() {
 
   if (HasLazyExternalLexicalLookups) {
     HasLazyExternalLexicalLookups = false;
+    bool Loaded = false;
+    SmallVector<NamedDecl *, 64> LoadedDecls;
     for (auto *DC : Contexts) {
-      if (DC->hasExternalLexicalStorage())
-        HasLazyLocalLexicalLookups |=
-            DC->LoadLexicalDeclsFromExternalStorage();
+      if (!DC->hasExternalLexicalStorage())
+        continue;
+      Decl *OldFirst = DC->FirstDecl;
+      if (!DC->LoadLexicalDeclsFromExternalStorage())
+        continue;
+      Loaded = true;
+      // The loaded declarations have been spliced in before the existing ones.
+      if (!HasLazyLocalLexicalLookups)
+        collectLookupDecls(
+            decl_range(decl_iterator(DC->FirstDecl), decl_iterator(OldFirst)),
+            DC, LoadedDecls);
     }
 
-    if (!HasLazyLocalLexicalLookups)
-      return LookupPtr;
+    // If the existing declarations are all in the lookup table, we usually
+    // only need to add the loaded ones rather than walk every context again.
+    if (!HasLazyLocalLexicalLookups) {
+      if (!Loaded || addLoadedDeclsToLookup(LoadedDecls))
+        return LookupPtr;
+      HasLazyLocalLexicalLookups = true;
+    }
   }
 
   for (auto *DC : Contexts)
@@ -1339,25 +1354,33 @@ StoredDeclsMap *DeclContext::buildLookup() {
   return LookupPtr;
 }
 
+/// shouldAddToLookup - Determine whether buildLookupImpl adds the declaration
+/// \p ND, which is lexically within \p DCtx, to the lookup table of the
+/// primary context \p Primary.
+static bool shouldAddToLookup(const DeclContext *Primary, NamedDecl *ND,
+                              DeclContext *DCtx) {
+  // Insert this declaration into the lookup structure, but only if
+  // it's semantically within its decl context. Any other decls which
+  // should be found in this context are added eagerly.
+  //
+  // If it's from an AST file, don't add it now. It'll get handled by
+  // FindExternalVisibleDeclsByName if needed. Exception: if we're not
+  // in C++, we do not track external visible decls for the TU, so in
+  // that case we need to collect them all here.
+  return ND->getDeclContext() == DCtx && !shouldBeHidden(ND) &&
+         (!ND->isFromASTFile() ||
+          (Primary->isTranslationUnit() &&
+           !Primary->getParentASTContext().getLangOpts().CPlusPlus));
+}
+
 /// buildLookupImpl - Build part of the lookup data structure for the
 /// declarations contained within DCtx, which will either be this
 /// DeclContext, a DeclContext linked to it, or a transparent context
 /// nested within it.
 void DeclContext::buildLookupImpl(DeclContext *DCtx, bool Internal) {
   for (Decl *D : DCtx->noload_decls()) {
-    // Insert this declaration into the lookup structure, but only if
-    // it's semantically within its decl context. Any other decls which
-    // should be found in this context are added eagerly.
-    //
-    // If it's from an AST file, don't add it now. It'll get handled by
-    // FindExternalVisibleDeclsByName if needed. Exception: if we're not
-    // in C++, we do not track external visible decls for the TU, so in
-    // that case we need to collect them all here.
     if (NamedDecl *ND = dyn_cast<NamedDecl>(D))
-      if (ND->getDeclContext() == DCtx && !shouldBeHidden(ND) &&
-          (!ND->isFromASTFile() ||
-           (isTranslationUnit() &&
-            !getParentASTContext().getLangOpts().CPlusPlus)))
+      if (shouldAddToLookup(this, ND, DCtx))
         makeDeclVisibleInContextImpl(ND, Internal);
 
     // If this declaration is itself a transparent declaration context
@@ -1369,6 +1392,34 @@ void DeclContext::buildLookupImpl(DeclContext *DCtx, bool Internal) {
   }
 }
 
+void DeclContext::collectLookupDecls(decl_range Decls, DeclContext *DCtx,
+                                     SmallVectorImpl<NamedDecl *> &Result) {
+  for (Decl *D : Decls) {
+    if (NamedDecl *ND = dyn_cast<NamedDecl>(D))
+      if (shouldAddToLookup(this, ND, DCtx))
+        Result.push_back(ND);
+
+    if (DeclContext *InnerCtx = dyn_cast<DeclContext>(D))
+      if (InnerCtx->isTransparentContext() || InnerCtx->isInlineNamespace())
+        collectLookupDecls(InnerCtx->noload_decls(), InnerCtx, Result);
+  }
+}
+
+bool DeclContext::addLoadedDeclsToLookup(ArrayRef<NamedDecl *> Decls) {
+  // A rebuild adds the loaded declarations before the existing ones, so a
+  // loaded redeclaration of an existing declaration must not replace it.
+  // Leave such names to the rebuild.
+  if (StoredDeclsMap *Map = LookupPtr)
+    for (NamedDecl *ND : Decls)
+      if (Map->count(ND->getDeclName()))
+        return false;
+
+  bool Internal = hasExternalVisibleStorage();
+  for (NamedDecl *ND : Decls)
+    makeDeclVisibleInContextImpl(ND, Internal);
+  return true;
+}
+
 NamedDecl *const DeclContextLookupResult::SingleElementDummyList = nullptr;
 
 DeclContext::lookup_result
@@ -33,6 +33,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprBytecode.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
@@ -3816,6 +3817,15 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
+  // Calls to functions that only compute with integers can be evaluated by
+  // the bytecode interpreter. If it cannot evaluate the call, nothing has
+  // happened, and the call is evaluated below.
+  if (!This && Info.getLangOpts().ConstexprBytecode &&
+      !Info.checkingPotentialConstantExpression() &&
+      Info.Ctx.getConstexprBytecode().evaluateCall(
+          Callee, ArgValues, Info.StepsLeft, Info.CallStackDepth + 1, Result))
+    return true;
+
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -22,10 +22,12 @@
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include <deque>
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace clang {
 namespace ast_matchers {
@@ -34,6 +36,14 @@ namespace {
 
 typedef MatchFinder::MatchCallback MatchCallback;
 
+// A match found while traversing a shard of the translation unit in parallel,
+// whose callback is run once all shards have been traversed.
+typedef std::pair<MatchCallback *, BoundNodes> DeferredMatch;
+
+// Maps a canonical type to its TypedefDecls.
+typedef llvm::DenseMap<const Type *, std::set<const TypedefNameDecl *>>
+    TypeAliasMap;
+
 // The maximum number of memoization entries to store.
 // 10k has been experimentally found to give a good trade-off
 // of performance vs. memory consumption by running matcher
@@ -295,10 +305,11 @@ class MatchASTVisitor : public RecursiveASTVisitor<MatchASTVisitor>,
 public:
   MatchASTVisitor(const MatchFinder::MatchersByType *Matchers,
                   const MatchFinder::MatchFinderOptions &Options)
-      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr) {}
+      : Matchers(Matchers), Options(Options), ActiveASTContext(nullptr),
+        DeferredMatches(nullptr) {}
 
   ~MatchASTVisitor() override {
-    if (Options.CheckProfiling) {
+    if (Options.CheckProfiling && !DeferredMatches) {
       Options.CheckProfiling->Records = std::move(TimeByBucket);
     }
   }
@@ -327,6 +338,16 @@ public:
     ActiveASTContext = NewActiveASTContext;
   }
 
+  /// \brief Appends the matches to \p Matches instead of running their
+  /// callbacks.
+  void deferMatches(std::vector<DeferredMatch> *Matches) {
+    DeferredMatches = Matches;
+  }
+
+  /// \brief Traverses the translation unit, matching its top-level
+  /// declarations on \p NumThreads threads.
+  void traverseInParallel(unsigned NumThreads);
+
   // The following Visit*() and Traverse*() functions "override"
   // methods in RecursiveASTVisitor.
 
@@ -526,7 +547,7 @@ private:
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matches(Node, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second, DeferredMatches);
         Builder.visitMatches(&Visitor);
       }
     }
@@ -550,7 +571,7 @@ private:
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matchesNoKindCheck(DynNode, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second, DeferredMatches);
         Builder.visitMatches(&Visitor);
       }
     }
@@ -686,17 +707,23 @@ private:
   class MatchVisitor : public BoundNodesTreeBuilder::Visitor {
   public:
     MatchVisitor(ASTContext* Context,
-                 MatchFinder::MatchCallback* Callback)
+                 MatchFinder::MatchCallback* Callback,
+                 std::vector<DeferredMatch> *Deferred)
       : Context(Context),
-        Callback(Callback) {}
+        Callback(Callback),
+        Deferred(Deferred) {}
 
     void visitMatch(const BoundNodes& BoundNodesView) override {
-      Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
+      if (Deferred)
+        Deferred->push_back(std::make_pair(Callback, BoundNodesView));
+      else
+        Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
     }
 
   private:
     ASTContext* Context;
     MatchFinder::MatchCallback* Callback;
+    std::vector<DeferredMatch> *Deferred;
   };
 
   // Returns true if 'TypeNode' has an alias that matches the given matcher.
@@ -737,7 +764,10 @@ private:
   ASTContext *ActiveASTContext;
 
   // Maps a canonical type to its TypedefDecls.
-  llvm::DenseMap<const Type*, std::set<const TypedefNameDecl*> > TypeAliases;
+  TypeAliasMap TypeAliases;
+
+  // If set, the matches found, whose callbacks have not been run yet.
+  std::vector<DeferredMatch> *DeferredMatches;
 
   // Maps (matcher, node) -> the match result for memoization.
   typedef std::map<MatchKey, MemoizedMatchResult> MemoizationMap;
@@ -871,6 +901,98 @@ bool MatchASTVisitor::TraverseNestedNameSpecifierLoc(
       RecursiveASTVisitor<MatchASTVisitor>::TraverseNestedNameSpecifierLoc(NNS);
 }
 
+// Collects the typedefs that MatchASTVisitor::VisitTypedefNameDecl sees when
+// traversing the same declarations.
+class TypedefCollector : public RecursiveASTVisitor<TypedefCollector> {
+public:
+  TypedefCollector(ASTContext &Context, TypeAliasMap &Aliases)
+      : Context(Context), Aliases(Aliases) {}
+
+  bool VisitTypedefNameDecl(TypedefNameDecl *DeclNode) {
+    const Type *TypeNode = DeclNode->getUnderlyingType().getTypePtr();
+    Aliases[Context.getCanonicalType(TypeNode)].insert(DeclNode);
+    return true;
+  }
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+private:
+  ASTContext &Context;
+  TypeAliasMap &Aliases;
+};
+
+void MatchASTVisitor::traverseInParallel(unsigned NumThreads) {
+  TranslationUnitDecl *TU = ActiveASTContext->getTranslationUnitDecl();
+
+  // Collect the declarations that RecursiveASTVisitor would traverse below
+  // the translation unit.
+  SmallVector<Decl *, 64> TopLevelDecls;
+  for (Decl *Child : TU->decls())
+    if (!isa<BlockDecl>(Child) && !isa<CapturedDecl>(Child))
+      TopLevelDecls.push_back(Child);
+
+  struct Shard {
+    size_t Begin, End;
+    std::unique_ptr<MatchASTVisitor> Visitor;
+    std::vector<DeferredMatch> Matches;
+    TypeAliasMap DeclaredAliases;
+  };
+
+  // Use a few shards per thread so that the threads stay busy when the
+  // declarations differ in size.
+  size_t NumShards = std::min<size_t>(TopLevelDecls.size(), NumThreads * 4);
+  std::vector<Shard> Shards(NumShards);
+  for (size_t I = 0; I != NumShards; ++I) {
+    Shards[I].Begin = TopLevelDecls.size() * I / NumShards;
+    Shards[I].End = TopLevelDecls.size() * (I + 1) / NumShards;
+  }
+
+  llvm::ThreadPool Pool(NumThreads);
+
+  // The parent map is built on demand; build all of it now rather than
+  // letting the shards race to build it. Meanwhile, collect the typedefs that
+  // each shard declares.
+  Pool.async([this] { ActiveASTContext->buildParentMap(); });
+  for (size_t I = 0; I + 1 < NumShards; ++I) {
+    Shard &S = Shards[I];
+    Pool.async([this, &S, &TopLevelDecls] {
+      TypedefCollector Collector(*ActiveASTContext, S.DeclaredAliases);
+      for (size_t J = S.Begin; J != S.End; ++J)
+        Collector.TraverseDecl(TopLevelDecls[J]);
+    });
+  }
+  Pool.wait();
+
+  match(*TU);
+
+  // Every shard starts out knowing the typedefs declared before it, as it
+  // would when traversing the translation unit in order.
+  TypeAliasMap Aliases = TypeAliases;
+  for (Shard &S : Shards) {
+    S.Visitor = llvm::make_unique<MatchASTVisitor>(Matchers, Options);
+    S.Visitor->set_active_ast_context(ActiveASTContext);
+    S.Visitor->deferMatches(&S.Matches);
+    S.Visitor->TypeAliases = Aliases;
+    for (const auto &Entry : S.DeclaredAliases)
+      Aliases[Entry.first].insert(Entry.second.begin(), Entry.second.end());
+  }
+
+  for (Shard &S : Shards) {
+    Pool.async([&S, &TopLevelDecls] {
+      for (size_t I = S.Begin; I != S.End; ++I)
+        S.Visitor->TraverseDecl(TopLevelDecls[I]);
+    });
+  }
+  Pool.wait();
+
+  // Run the callbacks in the order in which a single traversal would have.
+  for (const Shard &S : Shards)
+    for (const DeferredMatch &Match : S.Matches)
+      Match.first->run(MatchFinder::MatchResult(Match.second,
+                                                ActiveASTContext));
+}
+
 class MatchASTConsumer : public ASTConsumer {
 public:
   MatchASTConsumer(MatchFinder *Finder,
@@ -980,7 +1102,11 @@ void MatchFinder::matchAST(ASTContext &Context) {
   internal::MatchASTVisitor Visitor(&Matchers, Options);
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
-  Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+  if (Options.NumThreads > 1 && !Options.CheckProfiling &&
+      !Context.getExternalSource())
+    Visitor.traverseInParallel(Options.NumThreads);
+  else
+    Visitor.TraverseDecl(Context.getTranslationUnitDecl());
   Visitor.onEndOfTranslationUnit();
 }
 
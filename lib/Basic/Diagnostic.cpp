@@ -16,6 +16,7 @@
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/PartialDiagnostic.h"
+#include "clang/Basic/SourceManager.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CrashRecoveryContext.h"
@@ -130,6 +131,7 @@ void DiagnosticsEngine::Reset() {
   // Clear state related to #pragma diagnostic.
   DiagStates.clear();
   DiagStatePoints.clear();
+  DiagStatePositions.clear();
   DiagStateOnPushStack.clear();
 
   // Create a DiagState and DiagStatePoint representing diagnostic changes
@@ -168,6 +170,29 @@ DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
   if (Loc.isInvalid())
     return DiagStatePoints.end() - 1;
 
+  // Without any pragmas, there is only the command-line state.
+  if (DiagStatePoints.size() == 1)
+    return DiagStatePoints.begin();
+
+  // Find the offset of the location in the file it is in, or that the macro
+  // expansion it is in is expanded in, and look that up among the positions
+  // of the points relative to the file. Points at exactly that offset are
+  // ordered relative to the location by the way they were included or
+  // expanded, so leave those to the general case.
+  std::pair<FileID, unsigned> Decomp = SourceMgr->getDecomposedLoc(L);
+  while (Decomp.first.isValid() &&
+         !SourceMgr->getSLocEntry(Decomp.first).isFile())
+    Decomp = SourceMgr->getDecomposedIncludedLoc(Decomp.first);
+  if (Decomp.first.isValid()) {
+    const FileDiagStatePositions &File = getDiagStatePositions(Decomp.first);
+    ArrayRef<unsigned> Positions = File.Positions;
+    const unsigned *I =
+        std::lower_bound(Positions.begin(), Positions.end(), Decomp.second);
+    if (I == Positions.end() || *I != Decomp.second)
+      return DiagStatePoints.begin() + File.First + (I - Positions.begin()) -
+             1;
+  }
+
   DiagStatePointsTy::iterator Pos = DiagStatePoints.end();
   FullSourceLoc LastStateChangePos = DiagStatePoints.back().Loc;
   if (LastStateChangePos.isValid() &&
@@ -178,6 +203,40 @@ DiagnosticsEngine::GetDiagStatePointForLoc(SourceLocation L) const {
   return Pos;
 }
 
+const DiagnosticsEngine::FileDiagStatePositions &
+DiagnosticsEngine::getDiagStatePositions(FileID FID) const {
+  std::pair<llvm::DenseMap<FileID, FileDiagStatePositions>::iterator, bool>
+      Inserted = DiagStatePositions.insert(
+          std::make_pair(FID, FileDiagStatePositions()));
+  FileDiagStatePositions &File = Inserted.first->second;
+  if (Inserted.second) {
+    // The command-line point comes before every file, so First is at least 1.
+    FullSourceLoc Start(SourceMgr->getLocForStartOfFile(FID), *SourceMgr);
+    File.First = std::lower_bound(DiagStatePoints.begin(),
+                                  DiagStatePoints.end(),
+                                  DiagStatePoint(nullptr, Start)) -
+                 DiagStatePoints.begin();
+    File.Complete = false;
+  }
+
+  // Classify the points added since the table was last extended. Each is
+  // either within the file, possibly in something that it includes, or after
+  // it, and so are all the points that follow it.
+  for (unsigned I = File.First + File.Positions.size(),
+                N = DiagStatePoints.size();
+       !File.Complete && I != N; ++I) {
+    std::pair<FileID, unsigned> Decomp =
+        SourceMgr->getDecomposedLoc(DiagStatePoints[I].Loc);
+    while (Decomp.first.isValid() && Decomp.first != FID)
+      Decomp = SourceMgr->getDecomposedIncludedLoc(Decomp.first);
+    if (Decomp.first.isValid())
+      File.Positions.push_back(Decomp.second);
+    else
+      File.Complete = true;
+  }
+  return File;
+}
+
 void DiagnosticsEngine::setSeverity(diag::kind Diag, diag::Severity Map,
                                     SourceLocation L) {
   assert(Diag < diag::DIAG_UPPER_LIMIT &&
@@ -244,6 +303,7 @@ void DiagnosticsEngine::setSeverity(diag::kind Diag, diag::Severity Map,
   NewState->setMapping(Diag, Mapping);
   DiagStatePoints.insert(Pos+1, DiagStatePoint(NewState,
                                                FullSourceLoc(Loc, *SourceMgr)));
+  DiagStatePositions.clear();
 }
 
 bool DiagnosticsEngine::setSeverityForGroup(diag::Flavor Flavor,
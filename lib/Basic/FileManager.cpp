@@ -26,6 +26,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <map>
 #include <set>
 #include <string>
@@ -51,6 +52,7 @@ FileManager::FileManager(const FileSystemOptions &FSO,
     SeenDirEntries(64), SeenFileEntries(64), NextFileUID(0) {
   NumDirLookups = NumFileLookups = 0;
   NumDirCacheMisses = NumFileCacheMisses = 0;
+  NumDirListings = 0;
 
   // If the caller doesn't provide a virtual file system, just grab the real
   // file system.
@@ -384,6 +386,75 @@ FileManager::getVirtualFile(StringRef Filename, off_t Size,
   return UFE;
 }
 
+const llvm::StringSet<> *
+FileManager::getDirectoryListing(const DirectoryEntry *Dir) {
+  auto Known = DirectoryListings.find(Dir);
+  if (Known != DirectoryListings.end())
+    return Known->second.get();
+
+  ++NumDirListings;
+  auto Names = llvm::make_unique<llvm::StringSet<>>();
+  std::error_code EC;
+  bool Remapped = false;
+  for (vfs::directory_iterator I = FS->dir_begin(Dir->getName(), EC), E;
+       !EC && I != E; I.increment(EC)) {
+    // A redirecting overlay (-ivfsoverlay) that uses external names reports
+    // its files under the paths they are mapped to, whose names need not be
+    // the ones they are included by. Leave such directories to a real lookup.
+    if (llvm::sys::path::parent_path(I->getName()) != Dir->getName()) {
+      Remapped = true;
+      break;
+    }
+    Names->insert(llvm::sys::path::filename(I->getName()).lower());
+  }
+  if (EC || Remapped)
+    Names.reset();
+
+  const llvm::StringSet<> *Result = Names.get();
+  DirectoryListings[Dir] = std::move(Names);
+  return Result;
+}
+
+bool FileManager::directoryMayContain(const DirectoryEntry *Dir,
+                                      StringRef Filename) {
+  // Virtual files do not show up in directory listings.
+  SmallString<128> Path(Dir->getName());
+  llvm::sys::path::append(Path, Filename);
+  auto Seen = SeenFileEntries.find(Path);
+  if (Seen != SeenFileEntries.end() && Seen->second &&
+      Seen->second != NON_EXISTENT_FILE)
+    return true;
+
+  Path = Dir->getName();
+  for (llvm::sys::path::const_iterator I = llvm::sys::path::begin(Filename),
+                                       E = llvm::sys::path::end(Filename);
+       I != E; ++I) {
+    StringRef Name = *I;
+
+    // Leave "." and "..", and names that the file system might compare in a
+    // different Unicode normalization form, to a real lookup.
+    if (Name == "." || Name == ".." ||
+        std::any_of(Name.begin(), Name.end(),
+                    [](char C) { return (unsigned char)C >= 0x80; }))
+      return true;
+
+    const llvm::StringSet<> *Names = getDirectoryListing(Dir);
+    if (!Names)
+      return true;
+    if (!Names->count(Name.lower()))
+      return false;
+
+    // Descend into the subdirectory, unless this is the file itself.
+    if (std::next(I) == E)
+      break;
+    llvm::sys::path::append(Path, Name);
+    Dir = getDirectory(Path);
+    if (!Dir)
+      return false;
+  }
+  return true;
+}
+
 bool FileManager::FixupRelativePath(SmallVectorImpl<char> &path) const {
   StringRef pathRef(path.data(), path.size());
 
@@ -560,6 +631,7 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  llvm::errs() << NumDirListings << " dirs listed.\n";
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
@@ -20,6 +20,7 @@
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/Compiler.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
@@ -362,8 +363,8 @@ SourceManager::SourceManager(DiagnosticsEngine &Diag, FileManager &FileMgr,
                              bool UserFilesAreVolatile)
   : Diag(Diag), FileMgr(FileMgr), OverridenFilesKeepOriginalName(true),
     UserFilesAreVolatile(UserFilesAreVolatile), FilesAreTransient(false),
-    ExternalSLocEntries(nullptr), LineTable(nullptr), NumLinearScans(0),
-    NumBinaryProbes(0) {
+    ExternalSLocEntries(nullptr), LastFileIDLookup(0), LineTable(nullptr),
+    NumLinearScans(0), NumBinaryProbes(0) {
   clearIDTables();
   Diag.setSourceManager(this);
 }
@@ -398,7 +399,10 @@ void SourceManager::clearIDTables() {
   SLocEntryLoaded.clear();
   LastLineNoFileIDQuery = FileID();
   LastLineNoContentCache = nullptr;
-  LastFileIDLookup = FileID();
+  for (unsigned I = 0; I != NumRecentLineNoQueries; ++I)
+    RecentLineNoQueries[I] = LineNoCacheEntry();
+  NextRecentLineNoVictim = 0;
+  setLastFileIDLookup(FileID());
 
   if (LineTable)
     LineTable->clear();
@@ -480,8 +484,10 @@ std::pair<int, unsigned>
 SourceManager::AllocateLoadedSLocEntries(unsigned NumSLocEntries,
                                          unsigned TotalSize) {
   assert(ExternalSLocEntries && "Don't have an external sloc source");
-  // Make sure we're not about to run out of source locations.
-  if (CurrentLoadedOffset - TotalSize < NextLocalOffset)
+  // Make sure we're not about to run out of source locations. Compare against
+  // the remaining space rather than subtracting from CurrentLoadedOffset, which
+  // would wrap around for very large modules.
+  if (TotalSize > CurrentLoadedOffset - NextLocalOffset)
     return std::make_pair(0, 0);
   LoadedSLocEntryTable.resize(LoadedSLocEntryTable.size() + NumSLocEntries);
   SLocEntryLoaded.resize(LoadedSLocEntryTable.size());
@@ -570,13 +576,12 @@ FileID SourceManager::createFileID(const ContentCache *File,
     SLocEntryLoaded[Index] = true;
     return FileID::get(LoadedID);
   }
+  unsigned FileSize = File->getSize();
+  if (!hasLocalSLocSpaceFor(FileSize))
+    reportSLocSpaceExhausted(IncludePos);
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset,
                                                FileInfo::get(IncludePos, File,
                                                              FileCharacter)));
-  unsigned FileSize = File->getSize();
-  assert(NextLocalOffset + FileSize + 1 > NextLocalOffset &&
-         NextLocalOffset + FileSize + 1 <= CurrentLoadedOffset &&
-         "Ran out of source locations!");
   // We do a +1 here because we want a SourceLocation that means "the end of the
   // file", e.g. for the "no newline at the end of the file" diagnostic.
   NextLocalOffset += FileSize + 1;
@@ -584,7 +589,8 @@ FileID SourceManager::createFileID(const ContentCache *File,
   // Set LastFileIDLookup to the newly created file.  The next getFileID call is
   // almost guaranteed to be from that file.
   FileID FID = FileID::get(LocalSLocEntryTable.size()-1);
-  return LastFileIDLookup = FID;
+  setLastFileIDLookup(FID);
+  return FID;
 }
 
 SourceLocation
@@ -622,15 +628,33 @@ SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
     SLocEntryLoaded[Index] = true;
     return SourceLocation::getMacroLoc(LoadedOffset);
   }
+  if (!hasLocalSLocSpaceFor(TokLength))
+    reportSLocSpaceExhausted(Info.getExpansionLocStart());
   LocalSLocEntryTable.push_back(SLocEntry::get(NextLocalOffset, Info));
-  assert(NextLocalOffset + TokLength + 1 > NextLocalOffset &&
-         NextLocalOffset + TokLength + 1 <= CurrentLoadedOffset &&
-         "Ran out of source locations!");
   // See createFileID for that +1.
   NextLocalOffset += TokLength + 1;
   return SourceLocation::getMacroLoc(NextLocalOffset - (TokLength + 1));
 }
 
+/// \brief Report that the local source location address space has been
+/// exhausted.
+///
+/// Every SourceLocation handed out so far encodes a 31-bit offset, so there is
+/// no way to continue once the local and loaded ranges meet; fail with an
+/// explanation instead of silently wrapping around in builds without asserts.
+void SourceManager::reportSLocSpaceExhausted(SourceLocation Loc) const {
+  std::string Message;
+  llvm::raw_string_ostream OS(Message);
+  if (Loc.isValid()) {
+    Loc.print(OS, *this);
+    OS << ": ";
+  }
+  OS << "ran out of source locations: the translation unit, including its "
+        "included files, macro expansions and imported modules, exceeds "
+     << MaxLoadedOffset << " bytes of source location address space";
+  llvm::report_fatal_error(OS.str(), /*gen_crash_diag=*/false);
+}
+
 llvm::MemoryBuffer *SourceManager::getMemoryBufferForFile(const FileEntry *File,
                                                           bool *Invalid) {
   const SrcMgr::ContentCache *IR = getOrCreateContentCache(File);
@@ -739,13 +763,13 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
   // most newly created FileID.
   const SrcMgr::SLocEntry *I;
 
-  if (LastFileIDLookup.ID < 0 ||
-      LocalSLocEntryTable[LastFileIDLookup.ID].getOffset() < SLocOffset) {
+  int LastID = getLastFileIDLookup().ID;
+  if (LastID < 0 || LocalSLocEntryTable[LastID].getOffset() < SLocOffset) {
     // Neither loc prunes our search.
     I = LocalSLocEntryTable.end();
   } else {
     // Perhaps it is near the file point.
-    I = LocalSLocEntryTable.begin()+LastFileIDLookup.ID;
+    I = LocalSLocEntryTable.begin()+LastID;
   }
 
   // Find the FileID that contains this.  "I" is an iterator that points to a
@@ -759,8 +783,8 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
       // If this isn't an expansion, remember it.  We have good locality across
       // FileID lookups.
       if (!I->isExpansion())
-        LastFileIDLookup = Res;
-      NumLinearScans += NumProbes+1;
+        setLastFileIDLookup(Res);
+      NumLinearScans.fetch_add(NumProbes + 1, std::memory_order_relaxed);
       return Res;
     }
     if (++NumProbes == 8)
@@ -791,17 +815,21 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
       continue;
     }
 
-    // If the middle index contains the value, succeed and return.
-    // FIXME: This could be made faster by using a function that's aware of
-    // being in the local area.
-    if (isOffsetInFileID(FileID::get(MiddleIndex), SLocOffset)) {
+    // If the middle index contains the value, succeed and return. We know
+    // that MidOffset <= SLocOffset, so only the end of the entry needs to be
+    // checked, and that is either the start of the next local entry or
+    // NextLocalOffset.
+    unsigned MidEnd = MiddleIndex + 1 == LocalSLocEntryTable.size()
+                          ? NextLocalOffset
+                          : LocalSLocEntryTable[MiddleIndex + 1].getOffset();
+    if (SLocOffset < MidEnd) {
       FileID Res = FileID::get(MiddleIndex);
 
       // If this isn't a macro expansion, remember it.  We have good locality
       // across FileID lookups.
       if (!LocalSLocEntryTable[MiddleIndex].isExpansion())
-        LastFileIDLookup = Res;
-      NumBinaryProbes += NumProbes;
+        setLastFileIDLookup(Res);
+      NumBinaryProbes.fetch_add(NumProbes, std::memory_order_relaxed);
       return Res;
     }
 
@@ -826,7 +854,7 @@ FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
 
   // First do a linear scan from the last lookup position, if possible.
   unsigned I;
-  int LastID = LastFileIDLookup.ID;
+  int LastID = getLastFileIDLookup().ID;
   if (LastID >= 0 || getLoadedSLocEntryByID(LastID).getOffset() < SLocOffset)
     I = 0;
   else
@@ -840,8 +868,8 @@ FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
       FileID Res = FileID::get(-int(I) - 2);
 
       if (!E.isExpansion())
-        LastFileIDLookup = Res;
-      NumLinearScans += NumProbes + 1;
+        setLastFileIDLookup(Res);
+      NumLinearScans.fetch_add(NumProbes + 1, std::memory_order_relaxed);
       return Res;
     }
   }
@@ -874,8 +902,8 @@ FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
     if (isOffsetInFileID(FileID::get(-int(MiddleIndex) - 2), SLocOffset)) {
       FileID Res = FileID::get(-int(MiddleIndex) - 2);
       if (!E.isExpansion())
-        LastFileIDLookup = Res;
-      NumBinaryProbes += NumProbes;
+        setLastFileIDLookup(Res);
+      NumBinaryProbes.fetch_add(NumProbes, std::memory_order_relaxed);
       return Res;
     }
 
@@ -1276,6 +1304,41 @@ FoundSpecialChar:
   std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
 }
 
+/// \brief Make the getLineNumber cache refer to \p FID if it was one of the
+/// recently queried files, saving the state for the current file so that
+/// switching back to it later is cheap.
+void SourceManager::switchLineNoCacheTo(FileID FID) const {
+  // Prefer the slot holding FID, so its state can be swapped back in, and then
+  // the slot already holding the current file, to avoid duplicate entries.
+  unsigned Slot = NumRecentLineNoQueries;
+  for (unsigned I = 0; I != NumRecentLineNoQueries; ++I) {
+    if (RecentLineNoQueries[I].FID == FID) {
+      Slot = I;
+      break;
+    }
+    if (RecentLineNoQueries[I].FID == LastLineNoFileIDQuery)
+      Slot = I;
+  }
+  if (Slot == NumRecentLineNoQueries) {
+    Slot = NextRecentLineNoVictim;
+    NextRecentLineNoVictim = (Slot + 1) % NumRecentLineNoQueries;
+  }
+
+  LineNoCacheEntry &Entry = RecentLineNoQueries[Slot];
+  LineNoCacheEntry Saved = Entry;
+  Entry.FID = LastLineNoFileIDQuery;
+  Entry.ContentCache = LastLineNoContentCache;
+  Entry.FilePos = LastLineNoFilePos;
+  Entry.Result = LastLineNoResult;
+
+  if (Saved.FID == FID) {
+    LastLineNoFileIDQuery = Saved.FID;
+    LastLineNoContentCache = Saved.ContentCache;
+    LastLineNoFilePos = Saved.FilePos;
+    LastLineNoResult = Saved.Result;
+  }
+}
+
 /// getLineNumber - Given a SourceLocation, return the spelling line number
 /// for the position indicated.  This requires building and caching a table of
 /// line offsets for the MemoryBuffer, so this is not cheap: use only when
@@ -1288,6 +1351,9 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos,
     return 1;
   }
 
+  if (LastLineNoFileIDQuery != FID)
+    switchLineNoCacheTo(FID);
+
   ContentCache *Content;
   if (LastLineNoFileIDQuery == FID)
     Content = LastLineNoContentCache;
@@ -2125,6 +2191,12 @@ void SourceManager::PrintStats() const {
                << " loaded SLocEntries allocated, "
                << MaxLoadedOffset - CurrentLoadedOffset
                << "B of Sloc address space used.\n";
+  llvm::errs() << CurrentLoadedOffset - NextLocalOffset
+               << "B of Sloc address space remaining ("
+               << (uint64_t(NextLocalOffset) +
+                   (MaxLoadedOffset - CurrentLoadedOffset)) * 100 /
+                      MaxLoadedOffset
+               << "% used).\n";
   
   unsigned NumLineNumsComputed = 0;
   unsigned NumFileBytesMapped = 0;
@@ -2137,8 +2209,8 @@ void SourceManager::PrintStats() const {
   llvm::errs() << NumFileBytesMapped << " bytes of files mapped, "
                << NumLineNumsComputed << " files with line #'s computed, "
                << NumMacroArgsComputed << " files with macro args computed.\n";
-  llvm::errs() << "FileID scans: " << NumLinearScans << " linear, "
-               << NumBinaryProbes << " binary.\n";
+  llvm::errs() << "FileID scans: " << NumLinearScans.load() << " linear, "
+               << NumBinaryProbes.load() << " binary.\n";
 }
 
 LLVM_DUMP_METHOD void SourceManager::dump() const {
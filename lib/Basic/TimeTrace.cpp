@@ -0,0 +1,166 @@
+//===--- TimeTrace.cpp - Hierarchical compilation time profiler -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the time-trace profiler behind -ftime-trace.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/TimeTrace.h"
+#include "clang/Basic/JsonSupport.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace clang;
+
+typedef std::chrono::steady_clock ClockType;
+typedef std::chrono::microseconds DurationType;
+
+TimeTraceProfiler *clang::TimeTraceProfilerInstance = nullptr;
+
+namespace {
+struct TimeTraceEvent {
+  ClockType::time_point Start;
+  DurationType Duration;
+  std::string Name;
+  std::string Detail;
+
+  TimeTraceEvent(std::string Name, std::string Detail)
+      : Start(ClockType::now()), Duration(0), Name(std::move(Name)),
+        Detail(std::move(Detail)) {}
+};
+}
+
+namespace clang {
+class TimeTraceProfiler {
+  /// The events that have begun but not ended yet, innermost last.
+  std::vector<TimeTraceEvent> Stack;
+
+  /// The events that have ended and are long enough to be written.
+  std::vector<TimeTraceEvent> Entries;
+
+  /// The number of events and the time spent in them, by event name.
+  llvm::StringMap<std::pair<unsigned, DurationType>> Totals;
+
+  ClockType::time_point StartTime;
+  DurationType Granularity;
+
+public:
+  explicit TimeTraceProfiler(unsigned GranularityUS)
+      : StartTime(ClockType::now()), Granularity(GranularityUS) {}
+
+  void begin(std::string Name, std::string Detail) {
+    Stack.push_back(TimeTraceEvent(std::move(Name), std::move(Detail)));
+  }
+
+  void end() {
+    if (Stack.empty())
+      return;
+
+    TimeTraceEvent &E = Stack.back();
+    E.Duration =
+        std::chrono::duration_cast<DurationType>(ClockType::now() - E.Start);
+
+    // Only the outermost of several nested events with the same name counts
+    // towards the total, so that recursive instantiations are not counted
+    // more than once.
+    std::vector<TimeTraceEvent>::iterator Outer =
+        std::find_if(Stack.begin(), Stack.end() - 1,
+                     [&](const TimeTraceEvent &Other) {
+                       return Other.Name == E.Name;
+                     });
+    if (Outer == Stack.end() - 1) {
+      std::pair<unsigned, DurationType> &Total = Totals[E.Name];
+      ++Total.first;
+      Total.second += E.Duration;
+    }
+
+    if (E.Duration >= Granularity)
+      Entries.push_back(std::move(E));
+    Stack.pop_back();
+  }
+
+  void write(raw_ostream &OS) const;
+};
+}
+
+static void writeCompleteEvent(raw_ostream &OS, StringRef Name,
+                               long long Start, long long Duration) {
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":" << Start
+     << ",\"dur\":" << Duration << ",\"name\":";
+  writeJSONString(OS, Name);
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) const {
+  OS << "{\"traceEvents\":[\n";
+
+  for (const TimeTraceEvent &E : Entries) {
+    long long Start =
+        std::chrono::duration_cast<DurationType>(E.Start - StartTime).count();
+    writeCompleteEvent(OS, E.Name, Start, E.Duration.count());
+    OS << ",\"args\":{\"detail\":";
+    writeJSONString(OS, E.Detail);
+    OS << "}},\n";
+  }
+
+  // Summarize each kind of event on a track of its own, longest first.
+  typedef std::pair<StringRef, std::pair<unsigned, DurationType>> NamedTotal;
+  std::vector<NamedTotal> SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.push_back(NamedTotal(Total.getKey(), Total.getValue()));
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const NamedTotal &A, const NamedTotal &B) {
+              if (A.second.second != B.second.second)
+                return A.second.second > B.second.second;
+              return A.first < B.first;
+            });
+
+  unsigned Track = 1;
+  for (const auto &Total : SortedTotals) {
+    long long Duration = Total.second.second.count();
+    unsigned Count = Total.second.first;
+    OS << "{\"pid\":1,\"tid\":" << Track++ << ",\"ph\":\"X\",\"ts\":0"
+       << ",\"dur\":" << Duration << ",\"name\":";
+    writeJSONString(OS, "Total " + Total.first.str());
+    OS << ",\"args\":{\"count\":" << Count << ",\"avg ms\":"
+       << llvm::format("%.3f", Duration / 1000.0 / Count) << "}},\n";
+  }
+
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"ts\":0,\"name\":\"process_name\","
+        "\"args\":{\"name\":\"clang\"}}\n";
+  OS << "]}\n";
+}
+
+void clang::initializeTimeTrace(unsigned GranularityUS) {
+  assert(!TimeTraceProfilerInstance && "Time trace already initialized");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(GranularityUS);
+}
+
+void clang::cleanupTimeTrace() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void clang::writeTimeTrace(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "Time trace not initialized");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+void clang::beginTimeTraceEvent(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->begin(Name, Detail);
+}
+
+void clang::endTimeTraceEvent() {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->end();
+}
@@ -11,27 +11,37 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Bitcode/BitcodeWriterPass.h"
+#include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/CodeGen/SchedulerRegistry.h"
 #include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/ModuleSummaryIndex.h"
 #include "llvm/IR/IRPrintingPasses.h"
+#include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/MC/SubtargetFeature.h"
 #include "llvm/Object/ModuleSummaryIndexObjectFile.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
@@ -42,6 +52,8 @@
 #include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/ObjCARC.h"
 #include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
 #include "llvm/Transforms/Utils/SymbolRewriter.h"
 #include <memory>
 using namespace clang;
@@ -114,6 +126,11 @@ private:
   /// \return True on success.
   bool AddEmitPasses(BackendAction Action, raw_pwrite_stream &OS);
 
+  /// Generate code for the module in parts on separate threads, writing the
+  /// object file of the first part to \p OS and those of the others to the
+  /// files in CodeGenOpts.CodeGenPartitionOutputs.
+  void EmitPartitionedObject(raw_pwrite_stream &OS);
+
 public:
   EmitAssemblyHelper(DiagnosticsEngine &_Diags, const CodeGenOptions &CGOpts,
                      const clang::TargetOptions &TOpts,
@@ -627,6 +644,138 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
   return true;
 }
 
+namespace {
+/// Passes the diagnostics of the module parts, which are generated on
+/// separate threads, to the handlers of the context of the whole module one
+/// at a time.
+struct PartDiagnosticForwarder {
+  LLVMContext &ModuleCtx;
+  sys::Mutex Lock;
+
+  explicit PartDiagnosticForwarder(LLVMContext &ModuleCtx)
+      : ModuleCtx(ModuleCtx) {}
+
+  void install(LLVMContext &PartCtx) {
+    PartCtx.setDiagnosticHandler(handleDiagnostic, this);
+    if (ModuleCtx.getInlineAsmDiagnosticHandler())
+      PartCtx.setInlineAsmDiagnosticHandler(handleInlineAsmDiagnostic, this);
+  }
+
+  static void handleDiagnostic(const DiagnosticInfo &DI, void *Context) {
+    auto *Forwarder = static_cast<PartDiagnosticForwarder *>(Context);
+    MutexGuard Guard(Forwarder->Lock);
+    Forwarder->ModuleCtx.diagnose(DI);
+  }
+
+  static void handleInlineAsmDiagnostic(const SMDiagnostic &D, void *Context,
+                                        unsigned LocCookie) {
+    auto *Forwarder = static_cast<PartDiagnosticForwarder *>(Context);
+    MutexGuard Guard(Forwarder->Lock);
+    Forwarder->ModuleCtx.getInlineAsmDiagnosticHandler()(
+        D, Forwarder->ModuleCtx.getInlineAsmDiagnosticContext(), LocCookie);
+  }
+};
+} // end anonymous namespace
+
+void EmitAssemblyHelper::EmitPartitionedObject(raw_pwrite_stream &OS) {
+  std::vector<std::unique_ptr<raw_fd_ostream>> PartitionOSs;
+  for (const std::string &Path : CodeGenOpts.CodeGenPartitionOutputs) {
+    std::error_code EC;
+    PartitionOSs.emplace_back(new raw_fd_ostream(Path, EC, sys::fs::F_None));
+    if (EC) {
+      Diags.Report(diag::err_fe_unable_to_open_output) << Path << EC.message();
+      return;
+    }
+  }
+  SmallVector<raw_pwrite_stream *, 8> OSs;
+  OSs.push_back(&OS);
+  for (const auto &PartitionOS : PartitionOSs)
+    OSs.push_back(PartitionOS.get());
+  unsigned NumParts = OSs.size();
+
+  // Each part is moved into a context of its own through bitcode, so that
+  // code generation for the parts shares no IR. Local symbols keep their
+  // names, and the ones that refer to each other stay in the same part.
+  std::vector<SmallString<0>> Bitcode(NumParts);
+  unsigned NextPart = 0;
+  auto WritePart = [&](std::unique_ptr<Module> MPart) {
+    raw_svector_ostream BCOS(Bitcode[NextPart++]);
+    WriteBitcodeToFile(MPart.get(), BCOS);
+  };
+  if (TheModule->getModuleInlineAsm().empty()) {
+    SplitModule(CloneModule(TheModule), NumParts, WritePart,
+                /*PreserveLocals=*/true);
+  } else {
+    // Every part would get a copy of the module-level inline assembly and of
+    // the symbols that it defines, so keep the module whole. The linker is
+    // still given an object file for each part.
+    raw_svector_ostream BCOS(Bitcode[NextPart++]);
+    WriteBitcodeToFile(TheModule, BCOS);
+    while (NextPart != NumParts) {
+      std::unique_ptr<Module> Empty(new Module(
+          TheModule->getModuleIdentifier(), TheModule->getContext()));
+      Empty->setTargetTriple(TheModule->getTargetTriple());
+      Empty->setDataLayout(TheModule->getDataLayout());
+      WritePart(std::move(Empty));
+    }
+  }
+  assert(NextPart == NumParts && "missing module parts");
+
+  // Target machines are not thread-safe; create one for each part up front.
+  std::vector<std::unique_ptr<TargetMachine>> PartTMs;
+  for (unsigned I = 1; I != NumParts; ++I)
+    PartTMs.emplace_back(TM->getTarget().createTargetMachine(
+        TM->getTargetTriple().str(), TM->getTargetCPU(),
+        TM->getTargetFeatureString(), TM->Options, TM->getRelocationModel(),
+        TM->getCodeModel(), TM->getOptLevel()));
+
+  llvm::Triple TargetTriple(TheModule->getTargetTriple());
+  std::unique_ptr<TargetLibraryInfoImpl> TLII(
+      createTLII(TargetTriple, CodeGenOpts));
+
+  // Diagnostics from code generation of a part go through the handlers of
+  // the module, so that they are reported like those of a whole module. The
+  // lock also serializes the other uses of Diags on the threads.
+  PartDiagnosticForwarder Forwarder(TheModule->getContext());
+  std::vector<char> Failed(NumParts, false);
+  {
+    ThreadPool Pool(NumParts);
+    for (unsigned I = 0; I != NumParts; ++I) {
+      Pool.async([&, I] {
+        TargetMachine *PartTM = I ? PartTMs[I - 1].get() : TM.get();
+        LLVMContext Ctx;
+        Forwarder.install(Ctx);
+        ErrorOr<std::unique_ptr<Module>> MPart = parseBitcodeFile(
+            MemoryBufferRef(Bitcode[I].str(), "<module part>"), Ctx);
+        if (std::error_code EC = MPart.getError()) {
+          MutexGuard Guard(Forwarder.Lock);
+          Diags.Report(diag::err_fe_unable_to_read_module_part)
+              << I << EC.message();
+          return;
+        }
+
+        legacy::PassManager PM;
+        PM.add(createTargetTransformInfoWrapperPass(
+            PartTM->getTargetIRAnalysis()));
+        PM.add(new TargetLibraryInfoWrapperPass(*TLII));
+        if (CodeGenOpts.OptimizationLevel > 0)
+          PM.add(createObjCARCContractPass());
+        if (PartTM->addPassesToEmitFile(
+                PM, *OSs[I], TargetMachine::CGFT_ObjectFile,
+                /*DisableVerify=*/!CodeGenOpts.VerifyModule)) {
+          Failed[I] = true;
+          return;
+        }
+        PM.run(**MPart);
+      });
+    }
+    Pool.wait();
+  }
+
+  if (std::find(Failed.begin(), Failed.end(), true) != Failed.end())
+    Diags.Report(diag::err_fe_unable_to_interface_with_target);
+}
+
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       raw_pwrite_stream *OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
@@ -664,6 +813,9 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   CreatePasses(ModuleSummary.get());
 
+  bool Partitioned = Action == Backend_EmitObj &&
+                     !CodeGenOpts.CodeGenPartitionOutputs.empty();
+
   switch (Action) {
   case Backend_EmitNothing:
     break;
@@ -680,7 +832,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
     break;
 
   default:
-    if (!AddEmitPasses(Action, *OS))
+    if (!Partitioned && !AddEmitPasses(Action, *OS))
       return;
   }
 
@@ -692,6 +844,7 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    TimeTraceScope TimeScope("PerFunctionPasses");
 
     PerFunctionPasses->doInitialization();
     for (Function &F : *TheModule)
@@ -702,13 +855,21 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    TimeTraceScope TimeScope("PerModulePasses");
     PerModulePasses->run(*TheModule);
   }
 
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeTraceScope TimeScope("CodeGenPasses");
     CodeGenPasses->run(*TheModule);
   }
+
+  if (Partitioned) {
+    PrettyStackTraceString CrashInfo("Partitioned code generation");
+    TimeTraceScope TimeScope("CodeGenPartitions");
+    EmitPartitionedObject(*OS);
+  }
 }
 
 void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
@@ -717,6 +878,7 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const LangOptions &LOpts, StringRef TDesc,
                               Module *M, BackendAction Action,
                               raw_pwrite_stream *OS) {
+  TimeTraceScope TimeScope("Backend", M->getModuleIdentifier());
   EmitAssemblyHelper AsmHelper(Diags, CGOpts, TOpts, LOpts, M);
 
   AsmHelper.EmitAssembly(Action, OS);
@@ -16,6 +16,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Config/config.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
@@ -32,6 +33,7 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateStats.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
 #include "llvm/ADT/Statistic.h"
@@ -536,6 +538,8 @@ void CompilerInstance::createSema(TranslationUnitKind TUKind,
                                   CodeCompleteConsumer *CompletionConsumer) {
   TheSema.reset(new Sema(getPreprocessor(), getASTContext(), getASTConsumer(),
                          TUKind, CompletionConsumer));
+  if (getFrontendOpts().TemplateStats)
+    TheSema->TemplateStatistics.reset(new TemplateStats(getASTContext()));
 
   // If we're building a module, notify the API notes manager.
   StringRef currentModuleName = getLangOpts().CurrentModule;
@@ -608,6 +612,29 @@ llvm::raw_null_ostream *CompilerInstance::createNullOutputFile() {
   return Ret;
 }
 
+std::unique_ptr<llvm::raw_fd_ostream>
+CompilerInstance::createReportFile(StringRef Extension, StringRef DefaultName) {
+  const FrontendOptions &Opts = getFrontendOpts();
+  SmallString<128> Path;
+  if (!Opts.OutputFile.empty() && Opts.OutputFile != "-")
+    Path = Opts.OutputFile;
+  else if (!Opts.Inputs.empty() && Opts.Inputs[0].isFile())
+    Path = llvm::sys::path::filename(Opts.Inputs[0].getFile());
+  else
+    Path = DefaultName;
+  llvm::sys::path::replace_extension(Path, Extension);
+
+  std::error_code EC;
+  auto OS = llvm::make_unique<llvm::raw_fd_ostream>(Path, EC,
+                                                    llvm::sys::fs::F_Text);
+  if (EC) {
+    getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Path << EC.message();
+    return nullptr;
+  }
+  return OS;
+}
+
 raw_pwrite_stream *
 CompilerInstance::createOutputFile(StringRef OutputPath, bool Binary,
                                    bool RemoveFileOnSignal, StringRef InFile,
@@ -911,6 +938,8 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
                               SourceLocation ImportLoc,
                               Module *Module,
                               StringRef ModuleFileName) {
+  TimeTraceScope TimeScope("CompileModule",
+                           [&]() { return Module->getFullModuleName(); });
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
     
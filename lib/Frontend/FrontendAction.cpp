@@ -11,6 +11,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclGroup.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
@@ -21,12 +22,16 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateStats.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <system_error>
@@ -438,6 +443,7 @@ bool FrontendAction::BeginSourceFile(CompilerInstance &CI,
 
 bool FrontendAction::Execute() {
   CompilerInstance &CI = getCompilerInstance();
+  TimeTraceScope TimeScope("Frontend", getCurrentFile());
 
   if (CI.hasFrontendTimer()) {
     llvm::TimeRegion Timer(CI.getFrontendTimer());
@@ -459,6 +465,17 @@ bool FrontendAction::Execute() {
   return true;
 }
 
+/// Write the -ftemplate-stats report next to the output file, or to the
+/// current directory when writing to stdout.
+static void writeTemplateStatsFile(CompilerInstance &CI) {
+  std::unique_ptr<llvm::raw_fd_ostream> OS =
+      CI.createReportFile("template-stats.json", "template-stats");
+  if (!OS)
+    return;
+  Sema &S = CI.getSema();
+  S.TemplateStatistics->write(*OS, S.getPrintingPolicy());
+}
+
 void FrontendAction::EndSourceFile() {
   CompilerInstance &CI = getCompilerInstance();
 
@@ -472,6 +489,9 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.hasSema() && CI.getSema().TemplateStatistics)
+    writeTemplateStatsFile(CI);
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
@@ -291,9 +291,12 @@ bool GenerateModuleAction::BeginSourceFileAction(CompilerInstance &CI,
   if (CI.getFrontendOpts().ModulesEmbedAllFiles)
     CI.getSourceManager().setAllFilesAreTransient(true);
 
-  // Parse the module map file.
+  // Parse the module map file, or the parts of it that declare the module.
   HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
-  if (HS.loadModuleMapFile(ModuleMap, IsSystem))
+  if (CI.getLangOpts().CurrentModule.empty()
+          ? HS.loadModuleMapFile(ModuleMap, IsSystem)
+          : HS.loadModuleMapFileForModule(ModuleMap, IsSystem,
+                                          CI.getLangOpts().CurrentModule))
     return false;
   
   if (CI.getLangOpts().CurrentModule.empty()) {
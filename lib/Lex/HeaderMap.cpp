@@ -18,11 +18,15 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/DataTypes.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/SwapByteOrder.h"
 #include "llvm/Support/Debug.h"
 #include <cstring>
+#include <map>
 #include <memory>
 using namespace clang;
 
@@ -38,6 +42,37 @@ static inline unsigned HashHMapKey(StringRef Str) {
   return Result;
 }
 
+/// getHashV2 - The hash function of version 2 header maps: FNV-1a of the
+/// lowercased key. Unlike HashHMapKey, it distinguishes keys that are
+/// permutations of each other, which are common among header names.
+uint32_t HeaderMapImpl::getHashV2(StringRef Key) {
+  uint32_t Result = 2166136261u;
+  for (char C : Key) {
+    Result ^= static_cast<unsigned char>(toLowercase(C));
+    Result *= 16777619u;
+  }
+  return Result;
+}
+
+namespace {
+/// The header maps that are in use by any compilation in this process. The
+/// buffers are only referenced weakly, so that they are freed along with the
+/// last HeaderMap that uses them.
+struct SharedHeaderMaps {
+  struct Entry {
+    std::string Name;
+    off_t Size;
+    time_t ModTime;
+    std::weak_ptr<const llvm::MemoryBuffer> Buffer;
+    bool NeedsByteSwap;
+  };
+
+  llvm::sys::Mutex Lock;
+  std::map<llvm::sys::fs::UniqueID, Entry> Maps;
+};
+} // end anonymous namespace
+
+static llvm::ManagedStatic<SharedHeaderMaps> SharedMaps;
 
 
 //===----------------------------------------------------------------------===//
@@ -53,13 +88,48 @@ const HeaderMap *HeaderMap::Create(const FileEntry *FE, FileManager &FM) {
   unsigned FileSize = FE->getSize();
   if (FileSize <= sizeof(HMapHeader)) return nullptr;
 
+  // If another compilation has already read this header map, and it has not
+  // changed since, use its contents. Virtual files have no unique ID, and are
+  // never shared.
+  bool Shareable = FE->getUniqueID() != llvm::sys::fs::UniqueID(0, 0);
+  if (Shareable) {
+    llvm::MutexGuard Guard(SharedMaps->Lock);
+    auto Known = SharedMaps->Maps.find(FE->getUniqueID());
+    if (Known != SharedMaps->Maps.end() &&
+        Known->second.Name == FE->getName() &&
+        Known->second.Size == FE->getSize() &&
+        Known->second.ModTime == FE->getModificationTime())
+      if (auto Buffer = Known->second.Buffer.lock())
+        return new HeaderMap(std::move(Buffer), Known->second.NeedsByteSwap);
+  }
+
   auto FileBuffer = FM.getBufferForFile(FE);
   if (!FileBuffer || !*FileBuffer)
     return nullptr;
   bool NeedsByteSwap;
   if (!checkHeader(**FileBuffer, NeedsByteSwap))
     return nullptr;
-  return new HeaderMap(std::move(*FileBuffer), NeedsByteSwap);
+  std::shared_ptr<const llvm::MemoryBuffer> Buffer(std::move(*FileBuffer));
+
+  if (Shareable) {
+    llvm::MutexGuard Guard(SharedMaps->Lock);
+    // Forget the header maps that are no longer in use, so that the table
+    // does not grow without bound in long-lived processes.
+    for (auto I = SharedMaps->Maps.begin(), E = SharedMaps->Maps.end();
+         I != E;) {
+      if (I->second.Buffer.expired())
+        I = SharedMaps->Maps.erase(I);
+      else
+        ++I;
+    }
+    SharedHeaderMaps::Entry &Shared = SharedMaps->Maps[FE->getUniqueID()];
+    Shared.Name = FE->getName();
+    Shared.Size = FE->getSize();
+    Shared.ModTime = FE->getModificationTime();
+    Shared.Buffer = Buffer;
+    Shared.NeedsByteSwap = NeedsByteSwap;
+  }
+  return new HeaderMap(std::move(Buffer), NeedsByteSwap);
 }
 
 bool HeaderMapImpl::checkHeader(const llvm::MemoryBuffer &File,
@@ -73,14 +143,18 @@ bool HeaderMapImpl::checkHeader(const llvm::MemoryBuffer &File,
 
   // Sniff it to see if it's a headermap by checking the magic number and
   // version.
-  if (Header->Magic == HMAP_HeaderMagicNumber &&
-      Header->Version == HMAP_HeaderVersion)
+  uint16_t Version;
+  if (Header->Magic == HMAP_HeaderMagicNumber) {
     NeedsByteSwap = false;
-  else if (Header->Magic == llvm::ByteSwap_32(HMAP_HeaderMagicNumber) &&
-           Header->Version == llvm::ByteSwap_16(HMAP_HeaderVersion))
+    Version = Header->Version;
+  } else if (Header->Magic == llvm::ByteSwap_32(HMAP_HeaderMagicNumber)) {
     NeedsByteSwap = true;  // Mixed endianness headermap.
-  else
+    Version = llvm::ByteSwap_16(Header->Version);
+  } else {
     return false;  // Not a header map.
+  }
+  if (Version != HMAP_HeaderVersion && Version != HMAP_HeaderVersion2)
+    return false;
 
   if (Header->Reserved != 0)
     return false;
@@ -92,8 +166,9 @@ bool HeaderMapImpl::checkHeader(const llvm::MemoryBuffer &File,
                             : Header->NumBuckets;
   if (!llvm::isPowerOf2_32(NumBuckets))
     return false;
-  if (File.getBufferSize() <
-      sizeof(HMapHeader) + sizeof(HMapBucket) * NumBuckets)
+  size_t BucketSize = Version == HMAP_HeaderVersion2 ? sizeof(HMapBucketV2)
+                                                     : sizeof(HMapBucket);
+  if (File.getBufferSize() < sizeof(HMapHeader) + BucketSize * NumBuckets)
     return false;
 
   // Okay, everything looks good.
@@ -122,21 +197,42 @@ const HMapHeader &HeaderMapImpl::getHeader() const {
   return *reinterpret_cast<const HMapHeader*>(FileBuffer->getBufferStart());
 }
 
+/// isVersion2 - Return true if this is a version 2 header map, which stores
+/// the hashes of its keys.
+bool HeaderMapImpl::isVersion2() const {
+  uint16_t Version = getHeader().Version;
+  if (NeedsBSwap)
+    Version = llvm::ByteSwap_16(Version);
+  return Version == HMAP_HeaderVersion2;
+}
+
 /// getBucket - Return the specified hash table bucket from the header map,
 /// bswap'ing its fields as appropriate.  If the bucket number is not valid,
 /// this return a bucket with an empty key (0).
-HMapBucket HeaderMapImpl::getBucket(unsigned BucketNo) const {
+HMapBucketV2 HeaderMapImpl::getBucket(unsigned BucketNo) const {
+  HMapBucketV2 Result;
+  Result.Key = HMAP_EmptyBucketKey;
+  Result.Hash = 0;
+
+  const char *BucketArray = FileBuffer->getBufferStart() + sizeof(HMapHeader);
+  if (isVersion2()) {
+    assert(FileBuffer->getBufferSize() >=
+               sizeof(HMapHeader) + sizeof(HMapBucketV2) * BucketNo &&
+           "Expected bucket to be in range");
+    const HMapBucketV2 *BucketPtr =
+        reinterpret_cast<const HMapBucketV2 *>(BucketArray) + BucketNo;
+    Result.Key    = getEndianAdjustedWord(BucketPtr->Key);
+    Result.Prefix = getEndianAdjustedWord(BucketPtr->Prefix);
+    Result.Suffix = getEndianAdjustedWord(BucketPtr->Suffix);
+    Result.Hash   = getEndianAdjustedWord(BucketPtr->Hash);
+    return Result;
+  }
+
   assert(FileBuffer->getBufferSize() >=
              sizeof(HMapHeader) + sizeof(HMapBucket) * BucketNo &&
          "Expected bucket to be in range");
-
-  HMapBucket Result;
-  Result.Key = HMAP_EmptyBucketKey;
-
-  const HMapBucket *BucketArray =
-    reinterpret_cast<const HMapBucket*>(FileBuffer->getBufferStart() +
-                                        sizeof(HMapHeader));
-  const HMapBucket *BucketPtr = BucketArray+BucketNo;
+  const HMapBucket *BucketPtr =
+      reinterpret_cast<const HMapBucket *>(BucketArray) + BucketNo;
 
   // Load the values, bswapping as needed.
   Result.Key    = getEndianAdjustedWord(BucketPtr->Key);
@@ -183,7 +279,7 @@ LLVM_DUMP_METHOD void HeaderMapImpl::dump() const {
   };
 
   for (unsigned i = 0; i != NumBuckets; ++i) {
-    HMapBucket B = getBucket(i);
+    HMapBucketV2 B = getBucket(i);
     if (B.Key == HMAP_EmptyBucketKey) continue;
 
     StringRef Key = getStringOrInvalid(B.Key);
@@ -215,10 +311,17 @@ StringRef HeaderMapImpl::lookupFilename(StringRef Filename,
   // Don't probe infinitely.  This should be checked before constructing.
   assert(llvm::isPowerOf2_32(NumBuckets) && "Expected power of 2");
 
-  // Linearly probe the hash table.
-  for (unsigned Bucket = HashHMapKey(Filename);; ++Bucket) {
-    HMapBucket B = getBucket(Bucket & (NumBuckets-1));
+  // Linearly probe the hash table, at most once around it. In a version 2
+  // header map, the stored hashes rule out most of the keys that do not
+  // match without comparing strings.
+  bool HasHashes = isVersion2();
+  uint32_t Hash = HasHashes ? getHashV2(Filename) : HashHMapKey(Filename);
+  for (unsigned Bucket = Hash, End = Hash + NumBuckets; Bucket != End;
+       ++Bucket) {
+    HMapBucketV2 B = getBucket(Bucket & (NumBuckets-1));
     if (B.Key == HMAP_EmptyBucketKey) return StringRef(); // Hash miss.
+    if (HasHashes && B.Hash != Hash)
+      continue;
 
     // See if the key matches.  If not, probe on.
     Optional<StringRef> Key = getString(B.Key);
@@ -239,4 +342,7 @@ StringRef HeaderMapImpl::lookupFilename(StringRef Filename,
     }
     return StringRef(DestPath.begin(), DestPath.size());
   }
+
+  // The table is full, and does not contain the key.
+  return StringRef();
 }
@@ -17,6 +17,7 @@
 #include "clang/Frontend/PCHContainerOperations.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Lex/HeaderMap.h"
+#include "clang/Lex/HeaderSearchCache.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/Lexer.h"
@@ -62,6 +63,7 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   AngledDirIdx = 0;
   SystemDirIdx = 0;
   NoCurDirSearch = false;
+  PersistentLookupCacheOpened = false;
 
   ExternalLookup = nullptr;
   ExternalSource = nullptr;
@@ -164,7 +166,7 @@ std::string HeaderSearch::getModuleFileName(StringRef ModuleName,
 
 Module *HeaderSearch::lookupModule(StringRef ModuleName, bool AllowSearch) {
   // Look in the module map to determine if there is a module by this name.
-  Module *Module = ModMap.findModule(ModuleName);
+  Module *Module = ModMap.findOrLoadModule(ModuleName);
   if (Module || !AllowSearch || !HSOpts->ImplicitModuleMaps)
     return Module;
   
@@ -193,9 +195,12 @@ Module *HeaderSearch::lookupModule(StringRef ModuleName, bool AllowSearch) {
       continue;
 
     bool IsSystem = SearchDirs[Idx].isSystemHeaderDirectory();
-    // Search for a module map file in this directory.
-    if (loadModuleMapFile(SearchDirs[Idx].getDir(), IsSystem,
-                          /*IsFramework*/false) == LMM_NewlyLoaded) {
+    // Search for a module map file in this directory. Only the declarations
+    // of this module need to be parsed.
+    LoadModuleMapResult Result =
+        loadModuleMapFileLazily(SearchDirs[Idx].getDir(), IsSystem,
+                                /*IsFramework*/false, ModuleName, StringRef());
+    if (Result == LMM_NewlyLoaded || Result == LMM_PartiallyLoaded) {
       // We just loaded a module map file; check whether the module is
       // available now.
       Module = ModMap.findModule(ModuleName);
@@ -249,6 +254,12 @@ const char *DirectoryLookup::getName() const {
   return getHeaderMap()->getFileName();
 }
 
+bool HeaderSearch::directoryMayContain(const DirectoryEntry *Dir,
+                                       StringRef Filename) {
+  return !HSOpts->ListSearchDirectories ||
+         FileMgr.directoryMayContain(Dir, Filename);
+}
+
 const FileEntry *HeaderSearch::getFileAndSuggestModule(
     StringRef FileName, const DirectoryEntry *Dir, bool IsSystemHeaderDir,
     Module *RequestingModule, ModuleMap::KnownHeader *SuggestedModule) {
@@ -297,6 +308,9 @@ const FileEntry *DirectoryLookup::LookupFile(
       RelativePath->append(Filename.begin(), Filename.end());
     }
 
+    if (!HS.directoryMayContain(getDir(), Filename))
+      return nullptr;
+
     return HS.getFileAndSuggestModule(TmpDir, getDir(),
                                       isSystemHeaderDirectory(),
                                       RequestingModule, SuggestedModule);
@@ -620,9 +634,12 @@ const FileEntry *HeaderSearch::LookupFile(
       // building a [system] module.
       bool IncluderIsSystemHeader =
           Includer && getFileInfo(Includer).DirInfo != SrcMgr::C_User;
-      if (const FileEntry *FE = getFileAndSuggestModule(
-              TmpDir, IncluderAndDir.second, IncluderIsSystemHeader,
-              RequestingModule, SuggestedModule)) {
+      const FileEntry *FE = nullptr;
+      if (directoryMayContain(IncluderAndDir.second, Filename))
+        FE = getFileAndSuggestModule(TmpDir, IncluderAndDir.second,
+                                     IncluderIsSystemHeader, RequestingModule,
+                                     SuggestedModule);
+      if (FE) {
         if (!Includer) {
           assert(First && "only first includer can have no file");
           return FE;
@@ -683,6 +700,9 @@ const FileEntry *HeaderSearch::LookupFile(
   // file was found in.
   if (FromDir)
     i = FromDir-&SearchDirs[0];
+  unsigned StartIdx = i;
+  StringRef LookupFilename = Filename;
+  bool NotePersistentLookup = false;
 
   // Cache all of the lookups performed by this method.  Many headers are
   // multiply included, and the "pragma once" optimization prevents them from
@@ -703,6 +723,18 @@ const FileEntry *HeaderSearch::LookupFile(
     // our search start.  We will fill in our found location below, so prime the
     // start point value.
     CacheLookup.reset(/*StartIdx=*/i+1);
+
+    // Skip the directories that earlier compilations found not to contain
+    // the file, and record what this lookup finds for later ones.
+    if (!SkipCache) {
+      if (HeaderSearchCache *Cache = getPersistentLookupCache()) {
+        unsigned FirstCandidate = Cache->getFirstCandidate(Filename, i);
+        // Only record lookups that the cache did not already know about;
+        // finding the guards costs as much as the lookup itself.
+        NotePersistentLookup = FirstCandidate == i;
+        i = FirstCandidate;
+      }
+    }
   }
 
   SmallString<64> MappedName;
@@ -762,9 +794,14 @@ const FileEntry *HeaderSearch::LookupFile(
 
     // Remember this location for the next lookup we do.
     CacheLookup.HitIdx = i;
+    if (NotePersistentLookup)
+      notePersistentLookup(LookupFilename, StartIdx, i);
     return FE;
   }
 
+  if (NotePersistentLookup)
+    notePersistentLookup(LookupFilename, StartIdx, SearchDirs.size());
+
   // If we are including a file with a quoted include "foo.h" from inside
   // a header in a framework that is currently being built, and we couldn't
   // resolve "foo.h" any other way, change the include to <Foo/foo.h>, where
@@ -807,6 +844,66 @@ const FileEntry *HeaderSearch::LookupFile(
   return nullptr;
 }
 
+HeaderSearchCache *HeaderSearch::getPersistentLookupCache() {
+  if (!PersistentLookupCacheOpened) {
+    PersistentLookupCacheOpened = true;
+    PersistentLookupCache.reset();
+    if (!HSOpts->HeaderSearchCachePath.empty()) {
+      // Describe each search directory by its kind and its path; the saved
+      // results are only valid for the same search directories.
+      std::vector<std::string> Dirs;
+      for (const DirectoryLookup &DL : SearchDirs) {
+        std::string Dir = DL.isNormalDir() ? "dir " :
+                          DL.isFramework() ? "framework " : "headermap ";
+        Dir += DL.getName();
+        Dirs.push_back(Dir);
+      }
+      PersistentLookupCache =
+          HeaderSearchCache::open(FileMgr.getVirtualFileSystem(),
+                                  HSOpts->HeaderSearchCachePath, Dirs);
+    }
+  }
+  return PersistentLookupCache.get();
+}
+
+void HeaderSearch::notePersistentLookup(StringRef Filename, unsigned StartIdx,
+                                        unsigned HitIdx) {
+  HeaderSearchCache *Cache = getPersistentLookupCache();
+  if (!Cache)
+    return;
+
+  // Only normal directories are skipped; header maps and frameworks do not
+  // map file names to paths directly, and are always searched. For each
+  // directory that is skipped, find the deepest existing directory on the way
+  // to the file, which has to be modified for the file to appear.
+  StringRef Parent = llvm::sys::path::parent_path(Filename);
+  std::vector<std::string> GuardPaths;
+  unsigned i = StartIdx;
+  for (; i != HitIdx && SearchDirs[i].isNormalDir(); ++i) {
+    SmallString<128> Guard(SearchDirs[i].getDir()->getName());
+    for (llvm::sys::path::const_iterator P = llvm::sys::path::begin(Parent),
+                                         PE = llvm::sys::path::end(Parent);
+         P != PE; ++P) {
+      size_t Length = Guard.size();
+      llvm::sys::path::append(Guard, *P);
+      if (!FileMgr.getDirectory(Guard)) {
+        Guard.resize(Length);
+        break;
+      }
+    }
+    GuardPaths.push_back(Guard.str());
+  }
+
+  if (i != StartIdx)
+    Cache->addLookup(Filename, StartIdx, i, GuardPaths);
+}
+
+void HeaderSearch::writeLookupCache() {
+  if (PersistentLookupCache && PersistentLookupCache->write())
+    Diags.Report(diag::warn_header_search_cache_write_failed)
+        << PersistentLookupCache->getCacheFile();
+}
+
 /// LookupSubframeworkHeader - Look up a subframework for the specified
 /// \#include file.  For example, if \#include'ing <HIToolbox/HIToolbox.h> from
 /// within ".../Carbon.framework/Headers/Carbon.h", check to see if HIToolbox
@@ -1108,10 +1205,17 @@ bool HeaderSearch::hasModuleMap(StringRef FileName,
     if (!Dir)
       return false;
 
-    // Try to load the module map file in this directory.
-    switch (loadModuleMapFile(Dir, IsSystem,
-                              llvm::sys::path::extension(Dir->getName()) ==
-                                  ".framework")) {
+    // Try to load the module map file in this directory, or the parts of it
+    // that may declare this header.
+    switch (loadModuleMapFileLazily(
+        Dir, IsSystem,
+        llvm::sys::path::extension(Dir->getName()) == ".framework",
+        StringRef(), llvm::sys::path::filename(FileName))) {
+    case LMM_PartiallyLoaded:
+      // The directories we stepped through may contain headers that other
+      // parts of the module map file declare, so they do not inherit it.
+      return true;
+
     case LMM_NewlyLoaded:
     case LMM_AlreadyLoaded:
       // Success. All of the directories we stepped through inherit this module
@@ -1195,7 +1299,8 @@ static const FileEntry *getPrivateModuleMap(const FileEntry *File,
   return FileMgr.getFile(PrivateFilename);
 }
 
-bool HeaderSearch::loadModuleMapFile(const FileEntry *File, bool IsSystem) {
+const DirectoryEntry *
+HeaderSearch::getModuleMapFileHomeDir(const FileEntry *File) {
   // Find the directory for the module. For frameworks, that may require going
   // up from the 'Modules' directory.
   const DirectoryEntry *Dir = nullptr;
@@ -1213,10 +1318,15 @@ bool HeaderSearch::loadModuleMapFile(const FileEntry *File, bool IsSystem) {
       assert(Dir && "parent must exist");
     }
   }
+  return Dir;
+}
 
-  switch (loadModuleMapFileImpl(File, IsSystem, Dir)) {
+bool HeaderSearch::loadModuleMapFile(const FileEntry *File, bool IsSystem) {
+  switch (loadModuleMapFileImpl(File, IsSystem,
+                                getModuleMapFileHomeDir(File))) {
   case LMM_AlreadyLoaded:
   case LMM_NewlyLoaded:
+  case LMM_PartiallyLoaded:
     return false;
   case LMM_NoDirectory:
   case LMM_InvalidModuleMap:
@@ -1225,6 +1335,17 @@ bool HeaderSearch::loadModuleMapFile(const FileEntry *File, bool IsSystem) {
   llvm_unreachable("Unknown load module map result");
 }
 
+bool HeaderSearch::loadModuleMapFileForModule(const FileEntry *File,
+                                              bool IsSystem,
+                                              StringRef ModuleName) {
+  if (HSOpts->ModuleMapIndexPath.empty() || LoadedModuleMaps.count(File))
+    return loadModuleMapFile(File, IsSystem);
+
+  return parseModuleMapFileLazily(File, IsSystem,
+                                  getModuleMapFileHomeDir(File), ModuleName,
+                                  StringRef());
+}
+
 HeaderSearch::LoadModuleMapResult
 HeaderSearch::loadModuleMapFileImpl(const FileEntry *File, bool IsSystem,
                                     const DirectoryEntry *Dir) {
@@ -1253,6 +1374,52 @@ HeaderSearch::loadModuleMapFileImpl(const FileEntry *File, bool IsSystem,
   return LMM_NewlyLoaded;
 }
 
+bool HeaderSearch::parseModuleMapFileLazily(const FileEntry *File,
+                                            bool IsSystem,
+                                            const DirectoryEntry *Dir,
+                                            StringRef ModuleName,
+                                            StringRef HeaderFilename) {
+  const FileEntry *PMMFile = getPrivateModuleMap(File, FileMgr);
+  for (const FileEntry *F : {File, PMMFile}) {
+    if (!F)
+      continue;
+    bool Failed =
+        HeaderFilename.empty()
+            ? ModMap.parseModuleMapFileForModule(F, IsSystem, Dir, ModuleName)
+            : ModMap.parseModuleMapFileForHeader(F, IsSystem, Dir,
+                                                 HeaderFilename);
+    if (Failed)
+      return true;
+  }
+  return false;
+}
+
+HeaderSearch::LoadModuleMapResult
+HeaderSearch::loadModuleMapFileLazily(const DirectoryEntry *Dir, bool IsSystem,
+                                      bool IsFramework, StringRef ModuleName,
+                                      StringRef HeaderFilename) {
+  if (HSOpts->ModuleMapIndexPath.empty() || DirectoryHasModuleMap.count(Dir))
+    return loadModuleMapFile(Dir, IsSystem, IsFramework);
+
+  const FileEntry *ModuleMapFile = lookupModuleMapFile(Dir, IsFramework);
+  if (!ModuleMapFile) {
+    // Remember that there is nothing to load here, so that the directories
+    // that every include walks through are only looked at once.
+    DirectoryHasModuleMap[Dir] = false;
+    return LMM_InvalidModuleMap;
+  }
+
+  // A module map file that has been loaded in full has nothing left to parse.
+  auto Known = LoadedModuleMaps.find(ModuleMapFile);
+  if (Known != LoadedModuleMaps.end())
+    return Known->second ? LMM_AlreadyLoaded : LMM_InvalidModuleMap;
+
+  if (parseModuleMapFileLazily(ModuleMapFile, IsSystem, Dir, ModuleName,
+                               HeaderFilename))
+    return LMM_InvalidModuleMap;
+  return LMM_PartiallyLoaded;
+}
+
 const FileEntry *
 HeaderSearch::lookupModuleMapFile(const DirectoryEntry *Dir, bool IsFramework) {
   if (!HSOpts->ImplicitModuleMaps)
@@ -1291,6 +1458,7 @@ Module *HeaderSearch::loadFrameworkModule(StringRef Name,
     return nullptr;
 
   case LMM_NewlyLoaded:
+  case LMM_PartiallyLoaded:
     break;
   }
 
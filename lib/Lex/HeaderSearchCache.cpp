@@ -0,0 +1,299 @@
+//===--- HeaderSearchCache.cpp - Header search results on disk ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the HeaderSearchCache interface.
+//
+// The cache file is a list of lines:
+//
+//   header-search-cache 1
+//   search <search directory>             (one for each search directory)
+//   guard <modification time> <path>      (guard IDs are numbered from 0)
+//   lookup <start> <first candidate> <number of guards> <guard IDs> <name>
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderSearchCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+using namespace clang;
+
+static const char CacheFileSignature[] = "header-search-cache 1";
+
+HeaderSearchCache::HeaderSearchCache(IntrusiveRefCntPtr<vfs::FileSystem> FS,
+                                     StringRef CacheFile,
+                                     ArrayRef<std::string> SearchDirs)
+    : FS(FS), CacheFile(CacheFile), SearchDirs(SearchDirs.begin(),
+                                               SearchDirs.end()),
+      StartTime(time(nullptr)), Modified(false) {}
+
+std::unique_ptr<HeaderSearchCache>
+HeaderSearchCache::open(IntrusiveRefCntPtr<vfs::FileSystem> FS,
+                        StringRef CacheDir, ArrayRef<std::string> SearchDirs) {
+  for (const std::string &Dir : SearchDirs)
+    if (Dir.find('\n') != std::string::npos)
+      return nullptr;
+
+  // Each set of search directories gets its own cache file, so that
+  // compilations with different sets do not overwrite each other's entries.
+  llvm::hash_code Hash =
+      llvm::hash_combine_range(SearchDirs.begin(), SearchDirs.end());
+  SmallString<128> CacheFile(CacheDir);
+  llvm::sys::path::append(CacheFile, llvm::utohexstr(size_t(Hash)) + ".hsc");
+
+  std::unique_ptr<HeaderSearchCache> Cache(
+      new HeaderSearchCache(FS, CacheFile, SearchDirs));
+  Cache->read();
+  return Cache;
+}
+
+/// \brief Remove the number at the start of \p Line and the space after it.
+///
+/// \returns true if there is no number.
+static bool consumeNumber(StringRef &Line, unsigned &Result) {
+  StringRef Number;
+  std::tie(Number, Line) = Line.split(' ');
+  return Number.getAsInteger(10, Result);
+}
+
+void HeaderSearchCache::read() {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(CacheFile);
+  if (!Buffer)
+    return;
+
+  // Read everything before using any of it; a cache file that cannot be read
+  // completely is ignored, and overwritten when the cache is written.
+  std::vector<Guard> NewGuards;
+  llvm::StringMap<SmallVector<Entry, 1>> NewEntries;
+  unsigned NumSearchDirs = 0;
+  StringRef Line, Rest = (*Buffer)->getBuffer();
+  std::tie(Line, Rest) = Rest.split('\n');
+  if (Line != CacheFileSignature)
+    return;
+  while (!Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    StringRef Kind;
+    std::tie(Kind, Line) = Line.split(' ');
+    if (Kind == "search") {
+      if (NumSearchDirs == SearchDirs.size() ||
+          Line != SearchDirs[NumSearchDirs])
+        return;
+      ++NumSearchDirs;
+    } else if (Kind == "guard") {
+      StringRef ModTime;
+      std::tie(ModTime, Line) = Line.split(' ');
+      uint64_t Time;
+      if (ModTime.getAsInteger(10, Time) || Line.empty())
+        return;
+      Guard G = {Line.str(), time_t(Time), Guard::Unchecked};
+      NewGuards.push_back(G);
+    } else if (Kind == "lookup") {
+      Entry E;
+      unsigned NumGuards;
+      if (consumeNumber(Line, E.StartIdx) ||
+          consumeNumber(Line, E.FirstCandidateIdx) ||
+          consumeNumber(Line, NumGuards))
+        return;
+      for (unsigned I = 0; I != NumGuards; ++I) {
+        unsigned ID;
+        if (consumeNumber(Line, ID) || ID >= NewGuards.size())
+          return;
+        E.Guards.push_back(ID);
+      }
+      if (E.StartIdx >= E.FirstCandidateIdx ||
+          E.FirstCandidateIdx > SearchDirs.size() || Line.empty())
+        return;
+      E.Invalid = false;
+      NewEntries[Line].push_back(E);
+    } else {
+      return;
+    }
+  }
+  if (NumSearchDirs != SearchDirs.size())
+    return;
+
+  Guards = std::move(NewGuards);
+  for (unsigned ID = 0, N = Guards.size(); ID != N; ++ID)
+    GuardIDs[Guards[ID].Path] = ID;
+  Entries = std::move(NewEntries);
+}
+
+bool HeaderSearchCache::isUnchanged(unsigned ID) {
+  Guard &G = Guards[ID];
+  if (G.State == Guard::Unchecked) {
+    llvm::ErrorOr<vfs::Status> Status = FS->status(G.Path);
+    if (Status && Status->getLastModificationTime().toEpochTime() == G.ModTime)
+      G.State = Guard::Unchanged;
+    else
+      G.State = Guard::Changed;
+  }
+  return G.State == Guard::Unchanged;
+}
+
+int HeaderSearchCache::getGuard(StringRef Path) {
+  llvm::StringMap<unsigned>::iterator Known = GuardIDs.find(Path);
+  if (Known != GuardIDs.end() && isUnchanged(Known->second))
+    return Known->second;
+
+  llvm::ErrorOr<vfs::Status> Status = FS->status(Path);
+  if (!Status)
+    return -1;
+
+  // A directory that was modified in the same second as this compilation
+  // started could be modified again without its modification time changing.
+  time_t ModTime = Status->getLastModificationTime().toEpochTime();
+  if (ModTime >= StartTime)
+    return -1;
+
+  Guard G = {Path.str(), ModTime, Guard::Unchanged};
+  Guards.push_back(G);
+  return GuardIDs[Path] = Guards.size() - 1;
+}
+
+unsigned HeaderSearchCache::getFirstCandidate(StringRef Filename,
+                                              unsigned StartIdx) {
+  llvm::StringMap<SmallVector<Entry, 1>>::iterator Known =
+      Entries.find(Filename);
+  if (Known == Entries.end())
+    return StartIdx;
+
+  for (Entry &E : Known->second) {
+    if (E.StartIdx != StartIdx || E.Invalid)
+      continue;
+    for (unsigned ID : E.Guards) {
+      if (!isUnchanged(ID)) {
+        E.Invalid = true;
+        Modified = true;
+        return StartIdx;
+      }
+    }
+    return E.FirstCandidateIdx;
+  }
+  return StartIdx;
+}
+
+void HeaderSearchCache::addLookup(StringRef Filename, unsigned StartIdx,
+                                  unsigned FirstCandidateIdx,
+                                  ArrayRef<std::string> GuardPaths) {
+  assert(StartIdx < FirstCandidateIdx &&
+         FirstCandidateIdx <= SearchDirs.size() && "Invalid lookup result");
+  assert(GuardPaths.size() == FirstCandidateIdx - StartIdx &&
+         "Need one guard for each search directory");
+  if (Filename.find('\n') != StringRef::npos)
+    return;
+
+  Entry NewEntry;
+  NewEntry.StartIdx = StartIdx;
+  NewEntry.FirstCandidateIdx = FirstCandidateIdx;
+  NewEntry.Invalid = false;
+  for (const std::string &Path : GuardPaths) {
+    if (Path.find('\n') != std::string::npos)
+      return;
+    int ID = getGuard(Path);
+    if (ID < 0)
+      return;
+    if (std::find(NewEntry.Guards.begin(), NewEntry.Guards.end(),
+                  unsigned(ID)) == NewEntry.Guards.end())
+      NewEntry.Guards.push_back(ID);
+  }
+
+  SmallVector<Entry, 1> &Known = Entries[Filename];
+  for (Entry &E : Known) {
+    if (E.StartIdx == StartIdx) {
+      if (E.Invalid || E.FirstCandidateIdx != FirstCandidateIdx ||
+          E.Guards != NewEntry.Guards) {
+        E = NewEntry;
+        Modified = true;
+      }
+      return;
+    }
+  }
+  Known.push_back(NewEntry);
+  Modified = true;
+}
+
+bool HeaderSearchCache::write() {
+  if (!Modified)
+    return false;
+
+  auto IsLive = [&](const Entry &E) {
+    if (E.Invalid)
+      return false;
+    for (unsigned ID : E.Guards)
+      if (Guards[ID].State == Guard::Changed)
+        return false;
+    return true;
+  };
+
+  // Only write the guards that the remaining entries depend on, numbered in
+  // the order in which they are first used.
+  std::vector<int> NewIDs(Guards.size(), -1);
+  std::vector<unsigned> LiveGuards;
+  for (const auto &Name : Entries)
+    for (const Entry &E : Name.second)
+      if (IsLive(E))
+        for (unsigned ID : E.Guards)
+          if (NewIDs[ID] < 0) {
+            NewIDs[ID] = LiveGuards.size();
+            LiveGuards.push_back(ID);
+          }
+
+  SmallString<4096> Buffer;
+  llvm::raw_svector_ostream OS(Buffer);
+  OS << CacheFileSignature << '\n';
+  for (const std::string &Dir : SearchDirs)
+    OS << "search " << Dir << '\n';
+  for (unsigned ID : LiveGuards)
+    OS << "guard " << uint64_t(Guards[ID].ModTime) << ' ' << Guards[ID].Path
+       << '\n';
+  for (const auto &Name : Entries) {
+    for (const Entry &E : Name.second) {
+      if (!IsLive(E))
+        continue;
+      OS << "lookup " << E.StartIdx << ' ' << E.FirstCandidateIdx << ' '
+         << E.Guards.size();
+      for (unsigned ID : E.Guards)
+        OS << ' ' << NewIDs[ID];
+      OS << ' ' << Name.first() << '\n';
+    }
+  }
+
+  // Write to a temporary file and rename it over the cache file, so that
+  // concurrent compilations never see a partially written cache.
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(CacheFile)))
+    return true;
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (llvm::sys::fs::createUniqueFile(CacheFile + "-%%%%%%%%", TmpFD, TmpPath))
+    return true;
+  {
+    llvm::raw_fd_ostream Out(TmpFD, /*shouldClose=*/true);
+    Out << OS.str();
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TmpPath);
+      return true;
+    }
+  }
+  if (llvm::sys::fs::rename(TmpPath, CacheFile)) {
+    llvm::sys::fs::remove(TmpPath);
+    return true;
+  }
+
+  Modified = false;
+  return false;
+}
@@ -1475,11 +1475,18 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  // Hash the identifier as we go, so that looking it up does not have to.
+  unsigned Hash = 0;
+  for (const char *Ptr = BufferPtr; Ptr != CurPtr; ++Ptr)
+    Hash = IdentifierTable::updateHash(Hash, *Ptr);
   unsigned char C = *CurPtr++;
-  while (isIdentifierBody(C))
+  while (isIdentifierBody(C)) {
+    Hash = IdentifierTable::updateHash(Hash, C);
     C = *CurPtr++;
+  }
 
   --CurPtr;   // Back up over the skipped character.
+  const char *HashEnd = CurPtr;
 
   // Fast path, no $,\,? in identifier found.  '\' might be an escaped newline
   // or UCN, and ? might be a trigraph for '\', an escaped newline or UCN.
@@ -1499,8 +1506,11 @@ FinishIdentifier:
       return true;
 
     // Fill in Result.IdentifierInfo and update the token kind,
-    // looking up the identifier in the identifier table.
-    IdentifierInfo *II = PP->LookUpIdentifierInfo(Result);
+    // looking up the identifier in the identifier table. The hash only
+    // covers the identifier if the slow path below did not extend it.
+    IdentifierInfo *II = CurPtr == HashEnd
+                             ? PP->LookUpIdentifierInfo(Result, Hash)
+                             : PP->LookUpIdentifierInfo(Result);
 
     // Finally, now that we know we have an identifier, pass this off to the
     // preprocessor, which may macro expand it or something.
@@ -23,6 +23,7 @@
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/LiteralSupport.h"
+#include "clang/Lex/ModuleMapIndex.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/Allocator.h"
@@ -30,16 +31,48 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <stdlib.h>
 #if defined(LLVM_ON_UNIX)
 #include <limits.h>
 #endif
 using namespace clang;
 
+struct ModuleMap::LazyModuleMapFile {
+  /// \brief The file ID of the module map file, which all of its
+  /// declarations are parsed from.
+  FileID ID;
+
+  const DirectoryEntry *HomeDir;
+  bool IsSystem;
+
+  /// \brief The index of the file, or null if it has to be parsed in full.
+  std::unique_ptr<ModuleMapIndex> Index;
+
+  /// \brief Whether each of the declarations in the index has been parsed.
+  std::vector<bool> Parsed;
+
+  /// \brief For each module name, the positions in the index of the
+  /// declarations of that module.
+  llvm::StringMap<SmallVector<unsigned, 1>> ModuleEntries;
+
+  /// \brief For each lowercased header file name, the positions in the index
+  /// of the declarations that name a header with that file name.
+  llvm::StringMap<SmallVector<unsigned, 1>> HeaderEntries;
+
+  /// \brief The positions in the index of the declarations that may declare
+  /// any header.
+  SmallVector<unsigned, 4> AnyHeaderEntries;
+
+  /// \brief Whether an error occurred in any of the declarations parsed so
+  /// far.
+  bool HadError;
+};
+
 Module::ExportDecl 
 ModuleMap::resolveExport(Module *Mod, 
                          const Module::UnresolvedExportDecl &Unresolved,
-                         bool Complain) const {
+                         bool Complain) {
   // We may have just a wildcard.
   if (Unresolved.Id.empty()) {
     assert(Unresolved.Wildcard && "Invalid unresolved export");
@@ -55,9 +88,12 @@ ModuleMap::resolveExport(Module *Mod,
 }
 
 Module *ModuleMap::resolveModuleId(const ModuleId &Id, Module *Mod,
-                                   bool Complain) const {
-  // Find the starting module.
+                                   bool Complain) {
+  // Find the starting module. It may be declared in a module map file that
+  // has only been parsed in part.
   Module *Context = lookupModuleUnqualified(Id[0].first, Mod);
+  if (!Context)
+    Context = findOrLoadModule(Id[0].first);
   if (!Context) {
     if (Complain)
       Diags.Report(Id[0].second, diag::err_mmap_missing_module_unqualified)
@@ -530,6 +566,20 @@ Module *ModuleMap::findModule(StringRef Name) const {
   return nullptr;
 }
 
+Module *ModuleMap::findOrLoadModule(StringRef Name) {
+  if (Module *M = findModule(Name))
+    return M;
+
+  auto Pending = PendingModules.find(Name);
+  if (Pending == PendingModules.end())
+    return nullptr;
+  SmallVector<const FileEntry *, 1> Files = std::move(Pending->second);
+  PendingModules.erase(Pending);
+  for (const FileEntry *File : Files)
+    parseLazyModuleMapFile(File, *LazyModuleMaps[File], Name, StringRef());
+  return findModule(Name);
+}
+
 Module *ModuleMap::lookupModuleUnqualified(StringRef Name,
                                            Module *Context) const {
   for(; Context; Context = Context->Parent) {
@@ -1123,6 +1173,7 @@ namespace clang {
     }
     
     bool parseModuleMapFile();
+    bool parseTopLevelModuleDecl();
   };
 }
 
@@ -2480,6 +2531,24 @@ bool ModuleMapParser::parseModuleMapFile() {
   } while (true);
 }
 
+/// \brief Parse a single top-level module declaration.
+bool ModuleMapParser::parseTopLevelModuleDecl() {
+  switch (Tok.Kind) {
+  case MMToken::ExplicitKeyword:
+  case MMToken::ExternKeyword:
+  case MMToken::ModuleKeyword:
+  case MMToken::FrameworkKeyword:
+    parseModuleDecl();
+    break;
+
+  default:
+    Diags.Report(Tok.getLocation(), diag::err_mmap_expected_module);
+    HadError = true;
+    break;
+  }
+  return HadError;
+}
+
 bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem,
                                    const DirectoryEntry *Dir,
                                    SourceLocation ExternModuleLoc) {
@@ -2488,9 +2557,20 @@ bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem,
   if (Known != ParsedModuleMap.end())
     return Known->second;
 
+  // If the file has been parsed in part, parse the rest of it.
+  auto Lazy = LazyModuleMaps.find(File);
+  if (Lazy != LazyModuleMaps.end() && Lazy->second->Index) {
+    bool Result = parseLazyModuleMapFile(File, *Lazy->second, StringRef(),
+                                         StringRef());
+    return ParsedModuleMap[File] = Result;
+  }
+
   assert(Target && "Missing target information");
   auto FileCharacter = IsSystem ? SrcMgr::C_System : SrcMgr::C_User;
-  FileID ID = SourceMgr.createFileID(File, ExternModuleLoc, FileCharacter);
+  FileID ID = Lazy != LazyModuleMaps.end()
+                  ? Lazy->second->ID
+                  : SourceMgr.createFileID(File, ExternModuleLoc,
+                                           FileCharacter);
   const llvm::MemoryBuffer *Buffer = SourceMgr.getBuffer(ID);
   if (!Buffer)
     return ParsedModuleMap[File] = true;
@@ -2503,8 +2583,158 @@ bool ModuleMap::parseModuleMapFile(const FileEntry *File, bool IsSystem,
   bool Result = Parser.parseModuleMapFile();
   ParsedModuleMap[File] = Result;
 
-  // Notify callbacks that we parsed it.
+  // Notify callbacks that we parsed it, unless they were notified when the
+  // file was first considered for parsing in part.
+  if (Lazy == LazyModuleMaps.end())
+    for (const auto &Cb : Callbacks)
+      Cb->moduleMapFileRead(Start, *File, IsSystem);
+  return Result;
+}
+
+ModuleMap::LazyModuleMapFile *
+ModuleMap::getLazyModuleMapFile(const FileEntry *File, bool IsSystem,
+                                const DirectoryEntry *HomeDir) {
+  auto Known = LazyModuleMaps.find(File);
+  if (Known != LazyModuleMaps.end())
+    return Known->second.get();
+
+  StringRef IndexDir = HeaderInfo.getHeaderSearchOpts().ModuleMapIndexPath;
+  if (IndexDir.empty())
+    return nullptr;
+
+  assert(Target && "Missing target information");
+  auto FileCharacter = IsSystem ? SrcMgr::C_System : SrcMgr::C_User;
+  std::unique_ptr<LazyModuleMapFile> Lazy(new LazyModuleMapFile);
+  Lazy->ID = SourceMgr.createFileID(File, SourceLocation(), FileCharacter);
+  Lazy->HomeDir = HomeDir;
+  Lazy->IsSystem = IsSystem;
+  Lazy->HadError = false;
+
+  // Use the saved index of the file if it is still valid; otherwise, index
+  // the file and save the index for later compilations.
+  Lazy->Index = ModuleMapIndex::read(IndexDir, File);
+  if (!Lazy->Index) {
+    Lazy->Index = ModuleMapIndex::create(Lazy->ID, SourceMgr, MMapLangOpts);
+    if (Lazy->Index)
+      Lazy->Index->write(IndexDir, File);
+  }
+
+  if (Lazy->Index) {
+    ArrayRef<ModuleMapIndex::Entry> Entries = Lazy->Index->entries();
+    Lazy->Parsed.resize(Entries.size());
+    for (unsigned I = 0, N = Entries.size(); I != N; ++I) {
+      const ModuleMapIndex::Entry &E = Entries[I];
+      SmallVectorImpl<const FileEntry *> &Files = PendingModules[E.Name];
+      if (Files.empty() || Files.back() != File)
+        Files.push_back(File);
+
+      // Map the names to the declarations up front, so that looking up a
+      // header does not have to go through the whole index every time.
+      Lazy->ModuleEntries[E.Name].push_back(I);
+      if (E.AnyHeader)
+        Lazy->AnyHeaderEntries.push_back(I);
+      for (const std::string &Header : E.Headers) {
+        SmallVectorImpl<unsigned> &Decls =
+            Lazy->HeaderEntries[StringRef(Header).lower()];
+        if (Decls.empty() || Decls.back() != I)
+          Decls.push_back(I);
+      }
+    }
+  }
+
+  // Notify callbacks that we read it; the declarations parsed later do not
+  // read it again.
+  SourceLocation Start = SourceMgr.getLocForStartOfFile(Lazy->ID);
   for (const auto &Cb : Callbacks)
     Cb->moduleMapFileRead(Start, *File, IsSystem);
+
+  LazyModuleMapFile *Result = Lazy.get();
+  LazyModuleMaps[File] = std::move(Lazy);
   return Result;
 }
+
+bool ModuleMap::parseLazyModuleMapFile(const FileEntry *File,
+                                       LazyModuleMapFile &Lazy,
+                                       StringRef ModuleName,
+                                       StringRef HeaderFilename) {
+  ArrayRef<ModuleMapIndex::Entry> Entries = Lazy.Index->entries();
+
+  // Find the declarations that may be relevant, in the order in which they
+  // appear in the file.
+  SmallVector<unsigned, 8> Candidates;
+  if (!ModuleName.empty()) {
+    auto Known = Lazy.ModuleEntries.find(ModuleName);
+    if (Known != Lazy.ModuleEntries.end())
+      for (unsigned I : Known->second)
+        if (HeaderFilename.empty() ||
+            Entries[I].mayDeclareHeader(HeaderFilename))
+          Candidates.push_back(I);
+  } else if (!HeaderFilename.empty()) {
+    Candidates.append(Lazy.AnyHeaderEntries.begin(),
+                      Lazy.AnyHeaderEntries.end());
+    auto Known = Lazy.HeaderEntries.find(HeaderFilename.lower());
+    if (Known != Lazy.HeaderEntries.end())
+      Candidates.append(Known->second.begin(), Known->second.end());
+    std::sort(Candidates.begin(), Candidates.end());
+    Candidates.erase(std::unique(Candidates.begin(), Candidates.end()),
+                     Candidates.end());
+  } else {
+    for (unsigned I = 0, N = Entries.size(); I != N; ++I)
+      Candidates.push_back(I);
+  }
+
+  const llvm::MemoryBuffer *Buffer = SourceMgr.getBuffer(Lazy.ID);
+  SourceLocation Start = SourceMgr.getLocForStartOfFile(Lazy.ID);
+  for (unsigned I : Candidates) {
+    const ModuleMapIndex::Entry &E = Entries[I];
+    if (Lazy.Parsed[I])
+      continue;
+
+    // Mark the declaration as parsed first, in case parsing it leads back to
+    // this file.
+    Lazy.Parsed[I] = true;
+
+    // A submodule declared on its own, as in 'module Foo.Private', can only
+    // be parsed once its top-level module has been, which may be declared
+    // earlier in this file or in another module map file.
+    if (E.IsSubmodule)
+      findOrLoadModule(E.Name);
+    Lexer L(Start, MMapLangOpts, Buffer->getBufferStart(),
+            Buffer->getBufferStart() + E.Offset, Buffer->getBufferEnd());
+    ModuleMapParser Parser(L, SourceMgr, Target, Diags, *this, File,
+                           Lazy.HomeDir, BuiltinIncludeDir, Lazy.IsSystem);
+    if (Parser.parseTopLevelModuleDecl())
+      Lazy.HadError = true;
+  }
+  return Lazy.HadError;
+}
+
+bool ModuleMap::parseModuleMapFileForModule(const FileEntry *File,
+                                            bool IsSystem,
+                                            const DirectoryEntry *HomeDir,
+                                            StringRef ModuleName) {
+  llvm::DenseMap<const FileEntry *, bool>::iterator Known
+    = ParsedModuleMap.find(File);
+  if (Known != ParsedModuleMap.end())
+    return Known->second;
+
+  LazyModuleMapFile *Lazy = getLazyModuleMapFile(File, IsSystem, HomeDir);
+  if (!Lazy || !Lazy->Index)
+    return parseModuleMapFile(File, IsSystem, HomeDir);
+  return parseLazyModuleMapFile(File, *Lazy, ModuleName, StringRef());
+}
+
+bool ModuleMap::parseModuleMapFileForHeader(const FileEntry *File,
+                                            bool IsSystem,
+                                            const DirectoryEntry *HomeDir,
+                                            StringRef HeaderFilename) {
+  llvm::DenseMap<const FileEntry *, bool>::iterator Known
+    = ParsedModuleMap.find(File);
+  if (Known != ParsedModuleMap.end())
+    return Known->second;
+
+  LazyModuleMapFile *Lazy = getLazyModuleMapFile(File, IsSystem, HomeDir);
+  if (!Lazy || !Lazy->Index)
+    return parseModuleMapFile(File, IsSystem, HomeDir);
+  return parseLazyModuleMapFile(File, *Lazy, StringRef(), HeaderFilename);
+}
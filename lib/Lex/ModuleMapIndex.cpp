@@ -0,0 +1,257 @@
+//===--- ModuleMapIndex.cpp - Index of a module map file ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ModuleMapIndex interface.
+//
+// A saved index is a list of lines:
+//
+//   module-map-index 1
+//   file <size> <modification time> <path of the module map file>
+//   decl <offset> <any header: 0 or 1> <submodule: 0 or 1> <module name>
+//   header <file name>                  (for the preceding declaration)
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/ModuleMapIndex.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Lex/Lexer.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <ctime>
+using namespace clang;
+
+static const char IndexFileSignature[] = "module-map-index 2";
+
+bool ModuleMapIndex::Entry::mayDeclareHeader(StringRef Filename) const {
+  if (AnyHeader)
+    return true;
+  for (const std::string &Header : Headers)
+    if (Filename.equals_lower(Header))
+      return true;
+  return false;
+}
+
+static bool isIdentifier(const Token &Tok, StringRef Name) {
+  return Tok.is(tok::raw_identifier) && Tok.getRawIdentifier() == Name;
+}
+
+std::unique_ptr<ModuleMapIndex>
+ModuleMapIndex::create(FileID FID, SourceManager &SourceMgr,
+                       const LangOptions &LangOpts) {
+  const llvm::MemoryBuffer *Buffer = SourceMgr.getBuffer(FID);
+  if (!Buffer)
+    return nullptr;
+
+  std::unique_ptr<ModuleMapIndex> Index(new ModuleMapIndex);
+  Lexer L(FID, Buffer, SourceMgr, LangOpts);
+  Token Tok;
+  L.LexFromRawLexer(Tok);
+  while (Tok.isNot(tok::eof)) {
+    Entry D;
+    D.Offset = SourceMgr.getFileOffset(Tok.getLocation());
+    D.IsSubmodule = false;
+    D.AnyHeader = false;
+
+    //   ['explicit'] ['framework'] 'module' module-id ... '{' ... '}'
+    //   'extern' 'module' module-id string-literal
+    bool Extern = false;
+    while (isIdentifier(Tok, "explicit") || isIdentifier(Tok, "framework") ||
+           isIdentifier(Tok, "extern")) {
+      Extern |= isIdentifier(Tok, "extern");
+      L.LexFromRawLexer(Tok);
+    }
+    if (!isIdentifier(Tok, "module"))
+      return nullptr;
+    L.LexFromRawLexer(Tok);
+    if (Tok.isNot(tok::raw_identifier))
+      return nullptr;
+    D.Name = Tok.getRawIdentifier().str();
+    L.LexFromRawLexer(Tok);
+    D.IsSubmodule = Tok.is(tok::period);
+
+    // Any header can belong to the modules in another module map file.
+    if (Extern) {
+      while (Tok.isOneOf(tok::period, tok::raw_identifier))
+        L.LexFromRawLexer(Tok);
+      if (Tok.isNot(tok::string_literal))
+        return nullptr;
+      L.LexFromRawLexer(Tok);
+      D.AnyHeader = true;
+      Index->Entries.push_back(std::move(D));
+      continue;
+    }
+
+    while (Tok.isNot(tok::l_brace)) {
+      if (Tok.isOneOf(tok::r_brace, tok::eof))
+        return nullptr;
+      L.LexFromRawLexer(Tok);
+    }
+
+    // Collect the headers named in the body.
+    unsigned Depth = 0;
+    Token Prev;
+    Prev.startToken();
+    do {
+      if (Tok.is(tok::l_brace)) {
+        ++Depth;
+      } else if (Tok.is(tok::r_brace)) {
+        --Depth;
+      } else if (Tok.is(tok::eof)) {
+        return nullptr;
+      } else if (isIdentifier(Tok, "umbrella") ||
+                 (Tok.is(tok::star) && isIdentifier(Prev, "module"))) {
+        D.AnyHeader = true;
+      } else if (Tok.is(tok::string_literal) && isIdentifier(Prev, "header")) {
+        StringRef Spelling(Tok.getLiteralData(), Tok.getLength());
+        Spelling = Spelling.drop_front().drop_back();
+        if (Spelling.find('\\') != StringRef::npos)
+          D.AnyHeader = true;
+        else
+          D.Headers.push_back(llvm::sys::path::filename(Spelling).str());
+      }
+      Prev = Tok;
+      L.LexFromRawLexer(Tok);
+    } while (Depth);
+
+    Index->Entries.push_back(std::move(D));
+  }
+
+  return Index;
+}
+
+/// \brief The file in \p IndexDir that holds the index of \p File.
+static void getIndexFileName(StringRef IndexDir, const FileEntry *File,
+                             SmallVectorImpl<char> &Result) {
+  Result.assign(IndexDir.begin(), IndexDir.end());
+  llvm::hash_code Hash = llvm::hash_value(StringRef(File->getName()));
+  llvm::sys::path::append(Result, llvm::utohexstr(size_t(Hash)) + ".mmi");
+}
+
+/// \brief Remove the number at the start of \p Line and the space after it.
+///
+/// \returns true if there is no number.
+static bool consumeNumber(StringRef &Line, uint64_t &Result) {
+  StringRef Number;
+  std::tie(Number, Line) = Line.split(' ');
+  return Number.getAsInteger(10, Result);
+}
+
+std::unique_ptr<ModuleMapIndex>
+ModuleMapIndex::read(StringRef IndexDir, const FileEntry *File) {
+  SmallString<128> IndexFile;
+  getIndexFileName(IndexDir, File, IndexFile);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(IndexFile);
+  if (!Buffer)
+    return nullptr;
+
+  StringRef Line, Rest = (*Buffer)->getBuffer();
+  std::tie(Line, Rest) = Rest.split('\n');
+  if (Line != IndexFileSignature)
+    return nullptr;
+
+  // The index is only valid for the contents of the file that it was built
+  // from.
+  uint64_t Size, ModTime;
+  std::tie(Line, Rest) = Rest.split('\n');
+  if (!Line.startswith("file "))
+    return nullptr;
+  Line = Line.substr(5);
+  if (consumeNumber(Line, Size) || consumeNumber(Line, ModTime) ||
+      Line != File->getName() || Size != uint64_t(File->getSize()) ||
+      ModTime != uint64_t(File->getModificationTime()))
+    return nullptr;
+
+  std::unique_ptr<ModuleMapIndex> Index(new ModuleMapIndex);
+  while (!Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    StringRef Kind;
+    std::tie(Kind, Line) = Line.split(' ');
+    if (Kind == "decl") {
+      uint64_t Offset, AnyHeader, IsSubmodule;
+      if (consumeNumber(Line, Offset) || consumeNumber(Line, AnyHeader) ||
+          consumeNumber(Line, IsSubmodule) ||
+          Offset >= uint64_t(File->getSize()) || AnyHeader > 1 ||
+          IsSubmodule > 1 || Line.empty())
+        return nullptr;
+      Entry D;
+      D.Name = Line.str();
+      D.Offset = Offset;
+      D.IsSubmodule = IsSubmodule;
+      D.AnyHeader = AnyHeader;
+      Index->Entries.push_back(std::move(D));
+    } else if (Kind == "header") {
+      if (Index->Entries.empty() || Line.empty())
+        return nullptr;
+      Index->Entries.back().Headers.push_back(Line.str());
+    } else {
+      return nullptr;
+    }
+  }
+  return Index;
+}
+
+bool ModuleMapIndex::write(StringRef IndexDir, const FileEntry *File) const {
+  // A file that was modified in the same second as it was indexed could be
+  // modified again without its modification time changing.
+  if (File->getModificationTime() >= time(nullptr))
+    return true;
+  if (StringRef(File->getName()).find('\n') != StringRef::npos)
+    return true;
+  for (const Entry &D : Entries)
+    for (const std::string &Header : D.Headers)
+      if (Header.find('\n') != std::string::npos)
+        return true;
+
+  SmallString<4096> Buffer;
+  llvm::raw_svector_ostream OS(Buffer);
+  OS << IndexFileSignature << '\n';
+  OS << "file " << uint64_t(File->getSize()) << ' '
+     << uint64_t(File->getModificationTime()) << ' ' << File->getName()
+     << '\n';
+  for (const Entry &D : Entries) {
+    OS << "decl " << D.Offset << ' ' << unsigned(D.AnyHeader) << ' '
+       << unsigned(D.IsSubmodule) << ' ' << D.Name << '\n';
+    for (const std::string &Header : D.Headers)
+      OS << "header " << Header << '\n';
+  }
+
+  // Write to a temporary file and rename it over the index file, so that
+  // concurrent compilations never see a partially written index.
+  SmallString<128> IndexFile;
+  getIndexFileName(IndexDir, File, IndexFile);
+  if (llvm::sys::fs::create_directories(IndexDir))
+    return true;
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (llvm::sys::fs::createUniqueFile(Twine(IndexFile) + "-%%%%%%%%", TmpFD,
+                                      TmpPath))
+    return true;
+  {
+    llvm::raw_fd_ostream Out(TmpFD, /*shouldClose=*/true);
+    Out << OS.str();
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TmpPath);
+      return true;
+    }
+  }
+  if (llvm::sys::fs::rename(TmpPath, IndexFile)) {
+    llvm::sys::fs::remove(TmpPath);
+    return true;
+  }
+  return false;
+}
@@ -531,6 +531,8 @@ void Preprocessor::EndSourceFile() {
   // Notify the client that we reached the end of the source file.
   if (Callbacks)
     Callbacks->EndOfMainFile();
+
+  HeaderInfo.writeLookupCache();
 }
 
 //===----------------------------------------------------------------------===//
@@ -569,6 +571,20 @@ IdentifierInfo *Preprocessor::LookUpIdentifierInfo(Token &Identifier) const {
   return II;
 }
 
+IdentifierInfo *Preprocessor::LookUpIdentifierInfo(Token &Identifier,
+                                                   unsigned Hash) const {
+  // The hash is of the characters in the buffer, so it is no use if they
+  // have to be cleaned.
+  if (Identifier.needsCleaning() || Identifier.hasUCN())
+    return LookUpIdentifierInfo(Identifier);
+
+  IdentifierInfo *II =
+      &Identifiers.getWithHash(Identifier.getRawIdentifier(), Hash);
+  Identifier.setIdentifierInfo(II);
+  Identifier.setKind(II->getTokenID());
+  return II;
+}
+
 void Preprocessor::SetPoisonReason(IdentifierInfo *II, unsigned DiagID) {
   PoisonReasons[II] = DiagID;
 }
@@ -19,6 +19,7 @@
 #include "clang/Basic/CharInfo.h"
 #include "clang/Basic/OperatorKinds.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Parse/ParseDiagnostic.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/ParsedTemplate.h"
@@ -2930,6 +2931,11 @@ void Parser::ParseCXXMemberSpecification(SourceLocation RecordLoc,
 
   PrettyDeclStackTraceEntry CrashInfo(Actions, TagDecl, RecordLoc,
                                       "parsing struct/union/class body");
+  TimeTraceScope TimeScope("ParseClass", [&]() -> std::string {
+    if (const NamedDecl *ND = dyn_cast_or_null<NamedDecl>(TagDecl))
+      return ND->getQualifiedNameAsString();
+    return "<anonymous>";
+  });
 
   // Determine whether this is a non-nested class. Note that local
   // classes are *not* considered to be nested classes.
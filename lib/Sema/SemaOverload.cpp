@@ -28,6 +28,7 @@
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateStats.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallPtrSet.h"
@@ -6304,6 +6305,35 @@ Sema::AddTemplateOverloadCandidate(FunctionTemplateDecl *FunctionTemplate,
   if (!CandidateSet.isNewCandidate(FunctionTemplate))
     return;
 
+  // Large overload sets, such as those of operator<<, mostly consist of
+  // function templates that are rejected by template argument deduction
+  // because of the number of arguments or the kind of an argument type. Check
+  // for these first, with a summary of the parameters that is computed once
+  // per template; the reason for a failure is only worked out if the
+  // candidate is diagnosed (see CompleteNonViableCandidate).
+  TemplateDeductionInfo Info(CandidateSet.getLocation());
+  if (!ExplicitTemplateArgs && !PartialOverloading) {
+    if (TemplateDeductionResult Result
+          = CheckTemplateCallShape(FunctionTemplate, Args)) {
+      OverloadCandidate &Candidate = CandidateSet.addCandidate();
+      Candidate.FoundDecl = FoundDecl;
+      Candidate.Function = FunctionTemplate->getTemplatedDecl();
+      Candidate.Viable = false;
+      Candidate.IsSurrogate = false;
+      Candidate.IgnoreObjectArgument = false;
+      Candidate.ExplicitCallArguments = Args.size();
+      if (Result == TDK_NonDeducedMismatch) {
+        Candidate.FailureKind = ovl_fail_deduction_not_performed;
+        Result = TDK_MiscellaneousDeductionFailure;
+      } else {
+        Candidate.FailureKind = ovl_fail_bad_deduction;
+      }
+      Candidate.DeductionFailure = MakeDeductionFailureInfo(Context, Result,
+                                                            Info);
+      return;
+    }
+  }
+
   // C++ [over.match.funcs]p7:
   //   In each case where a candidate is a function template, candidate
   //   function template specializations are generated using template argument
@@ -6313,7 +6343,6 @@ Sema::AddTemplateOverloadCandidate(FunctionTemplateDecl *FunctionTemplate,
   //   functions. In such a case, the candidate functions generated from each
   //   function template are combined with the set of non-template candidate
   //   functions.
-  TemplateDeductionInfo Info(CandidateSet.getLocation());
   FunctionDecl *Specialization = nullptr;
   if (TemplateDeductionResult Result
         = DeduceTemplateArguments(FunctionTemplate, ExplicitTemplateArgs, Args,
@@ -9629,6 +9658,7 @@ static void NoteFunctionCandidate(Sema &S, OverloadCandidate *Cand,
     return DiagnoseArityMismatch(S, Cand, NumArgs);
 
   case ovl_fail_bad_deduction:
+  case ovl_fail_deduction_not_performed:
     return DiagnoseBadDeduction(S, Cand, NumArgs, TakingCandidateAddress);
 
   case ovl_fail_illegal_constructor: {
@@ -9903,9 +9933,32 @@ struct CompareOverloadCandidatesForDisplay {
 /// CompleteNonViableCandidate - Normally, overload resolution only
 /// computes up to the first. Produces the FixIt set if possible.
 static void CompleteNonViableCandidate(Sema &S, OverloadCandidate *Cand,
-                                       ArrayRef<Expr *> Args) {
+                                       ArrayRef<Expr *> Args,
+                                       SourceLocation Loc) {
   assert(!Cand->Viable);
 
+  // Perform the template argument deduction that was skipped when the
+  // candidate was added, to find out why it fails. The failure was already
+  // recorded in the template statistics when the candidate was rejected.
+  if (Cand->FailureKind == ovl_fail_deduction_not_performed) {
+    Sema::TemplateDeductionResult Result =
+        Sema::TDK_MiscellaneousDeductionFailure;
+    TemplateDeductionInfo Info(Loc);
+    if (Args.size() == Cand->ExplicitCallArguments) {
+      TemplateStats::RepeatedDeductionRAII NotCounted(
+          S.TemplateStatistics.get());
+      FunctionDecl *Specialization = nullptr;
+      Result = S.DeduceTemplateArguments(
+          Cand->Function->getDescribedFunctionTemplate(),
+          /*ExplicitTemplateArgs=*/nullptr, Args, Specialization, Info);
+      assert(Result != Sema::TDK_Success &&
+             "candidate rejected by its call shape was deduced successfully");
+    }
+    Cand->FailureKind = ovl_fail_bad_deduction;
+    Cand->DeductionFailure = MakeDeductionFailureInfo(S.Context, Result, Info);
+    return;
+  }
+
   // Don't do anything on failures other than bad conversion.
   if (Cand->FailureKind != ovl_fail_bad_conversion) return;
 
@@ -9999,7 +10052,7 @@ void OverloadCandidateSet::NoteCandidates(Sema &S,
     if (Cand->Viable)
       Cands.push_back(Cand);
     else if (OCD == OCD_AllCandidates) {
-      CompleteNonViableCandidate(S, Cand, Args);
+      CompleteNonViableCandidate(S, Cand, Args, Loc);
       if (Cand->Function || Cand->IsSurrogate)
         Cands.push_back(Cand);
       // Otherwise, this a non-viable builtin candidate.  We do not, in general,
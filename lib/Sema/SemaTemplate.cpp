@@ -29,6 +29,7 @@
 #include "clang/Sema/SemaInternal.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateStats.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringExtras.h"
@@ -2217,6 +2218,8 @@ QualType Sema::CheckTemplateIdType(TemplateName Name,
     void *InsertPos = nullptr;
     ClassTemplateSpecializationDecl *Decl
       = ClassTemplate->findSpecialization(Converted, InsertPos);
+    if (TemplateStatistics)
+      TemplateStatistics->noteSpecializationLookup(ClassTemplate, Decl);
     if (!Decl) {
       // This is the first time we have referenced this class template
       // specialization. Create the canonical declaration and add it to
@@ -2746,9 +2749,12 @@ Sema::CheckVarTemplateId(VarTemplateDecl *Template, SourceLocation TemplateLoc,
   // Find the variable template specialization declaration that
   // corresponds to these arguments.
   void *InsertPos = nullptr;
-  if (VarTemplateSpecializationDecl *Spec = Template->findSpecialization(
-          Converted, InsertPos))
-    // If we already have a variable template specialization, return it.
+  VarTemplateSpecializationDecl *Spec =
+      Template->findSpecialization(Converted, InsertPos);
+  if (TemplateStatistics)
+    TemplateStatistics->noteSpecializationLookup(Template, Spec);
+  // If we already have a variable template specialization, return it.
+  if (Spec)
     return Spec;
 
   // This is the first time we have referenced this variable template
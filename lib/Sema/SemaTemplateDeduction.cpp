@@ -22,8 +22,10 @@
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Sema.h"
 #include "clang/Sema/Template.h"
+#include "clang/Sema/TemplateStats.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include <algorithm>
+#include <memory>
 
 namespace clang {
   using namespace sema;
@@ -2244,10 +2246,9 @@ FinishTemplateArgumentDeduction(Sema &S,
 /// \brief Perform template argument deduction to determine whether
 /// the given template arguments match the given class template
 /// partial specialization per C++ [temp.class.spec.match].
-Sema::TemplateDeductionResult
-Sema::DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
-                              const TemplateArgumentList &TemplateArgs,
-                              TemplateDeductionInfo &Info) {
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsImpl(
+    ClassTemplatePartialSpecializationDecl *Partial,
+    const TemplateArgumentList &TemplateArgs, TemplateDeductionInfo &Info) {
   if (Partial->isInvalidDecl())
     return TDK_Invalid;
 
@@ -2410,10 +2411,9 @@ static Sema::TemplateDeductionResult FinishTemplateArgumentDeduction(
 ///        VarTemplate(Partial)SpecializationDecl with a new data
 ///        structure Template(Partial)SpecializationDecl, and
 ///        using Template(Partial)SpecializationDecl as input type.
-Sema::TemplateDeductionResult
-Sema::DeduceTemplateArguments(VarTemplatePartialSpecializationDecl *Partial,
-                              const TemplateArgumentList &TemplateArgs,
-                              TemplateDeductionInfo &Info) {
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsImpl(
+    VarTemplatePartialSpecializationDecl *Partial,
+    const TemplateArgumentList &TemplateArgs, TemplateDeductionInfo &Info) {
   if (Partial->isInvalidDecl())
     return TDK_Invalid;
 
@@ -3345,7 +3345,7 @@ DeduceTemplateArgumentByListElement(Sema &S,
 /// about template argument deduction.
 ///
 /// \returns the result of template argument deduction.
-Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsImpl(
     FunctionTemplateDecl *FunctionTemplate,
     TemplateArgumentListInfo *ExplicitTemplateArgs, ArrayRef<Expr *> Args,
     FunctionDecl *&Specialization, TemplateDeductionInfo &Info,
@@ -3536,6 +3536,105 @@ Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
                                          PartialOverloading);
 }
 
+/// \brief Determine the kind of argument type from which template arguments
+/// can possibly be deduced for a function parameter of type \p ParamType.
+static Sema::CallArgKind
+getCallArgKind(Sema &S, FunctionTemplateDecl *FunctionTemplate,
+               QualType ParamType) {
+  // A parameter that has nothing to deduce accepts any argument that can be
+  // converted to it, which is for overload resolution to check.
+  if (!hasDeducibleTemplateParameters(S, FunctionTemplate, ParamType))
+    return Sema::CAK_Any;
+
+  // C++ [temp.deduct.call]p2-3: references and top-level cv-qualifiers of P
+  // are ignored for type deduction.
+  QualType T = S.Context.getCanonicalType(ParamType.getNonReferenceType());
+  if (isa<TemplateSpecializationType>(T))
+    return Sema::CAK_Class;
+  if (isa<PointerType>(T))
+    return Sema::CAK_Pointer;
+  if (isa<MemberPointerType>(T))
+    return Sema::CAK_MemberPointer;
+  return Sema::CAK_Any;
+}
+
+/// \brief Determine whether a template argument can possibly be deduced from
+/// the call argument \p Arg for a function parameter of the kind \p Kind.
+static bool isCompatibleCallArg(Sema::CallArgKind Kind, Expr *Arg) {
+  // Initializer lists and overload sets are deduced from by special rules.
+  QualType ArgType = Arg->getType();
+  if (isa<InitListExpr>(Arg) || ArgType->isPlaceholderType() ||
+      ArgType->isDependentType())
+    return true;
+
+  switch (Kind) {
+  case Sema::CAK_Any:
+    return true;
+  case Sema::CAK_Class:
+    // The argument may be of a class derived from the simple-template-id.
+    return ArgType->isRecordType();
+  case Sema::CAK_Pointer:
+    return !ArgType->isRecordType() && !ArgType->isArithmeticType() &&
+           !ArgType->isEnumeralType() && !ArgType->isMemberPointerType();
+  case Sema::CAK_MemberPointer:
+    return ArgType->isMemberPointerType();
+  }
+  llvm_unreachable("Invalid CallArgKind!");
+}
+
+Sema::TemplateDeductionResult
+Sema::CheckTemplateCallShape(FunctionTemplateDecl *FunctionTemplate,
+                             ArrayRef<Expr *> Args) {
+  if (FunctionTemplate->isInvalidDecl())
+    return TDK_Success;
+
+  llvm::DenseMap<FunctionTemplateDecl *, FunctionTemplateCallShape>::iterator
+    Known = FunctionTemplateCallShapes.find(FunctionTemplate);
+  if (Known == FunctionTemplateCallShapes.end()) {
+    FunctionDecl *Function = FunctionTemplate->getTemplatedDecl();
+    const FunctionProtoType *Proto
+      = Function->getType()->getAs<FunctionProtoType>();
+
+    FunctionTemplateCallShape Shape;
+    Shape.MinArgs = Function->getMinRequiredArguments();
+    Shape.MaxArgs = Function->getNumParams();
+    if (Proto->isTemplateVariadic() || Proto->isVariadic())
+      Shape.MaxArgs = UINT_MAX;
+    for (ParmVarDecl *Param : Function->parameters()) {
+      // Arguments past a function parameter pack cannot be matched with
+      // their parameters without deduction.
+      if (isa<PackExpansionType>(Param->getType()))
+        break;
+      Shape.ParamKinds.push_back(
+          getCallArgKind(*this, FunctionTemplate, Param->getType()));
+    }
+    Known = FunctionTemplateCallShapes.insert(
+        std::make_pair(FunctionTemplate, std::move(Shape))).first;
+  }
+
+  // These are the checks that DeduceTemplateArguments starts with.
+  const FunctionTemplateCallShape &Shape = Known->second;
+  TemplateDeductionResult Result = TDK_Success;
+  if (Args.size() < Shape.MinArgs)
+    Result = TDK_TooFewArguments;
+  else if (Args.size() > Shape.MaxArgs)
+    Result = TDK_TooManyArguments;
+  else {
+    for (unsigned I = 0, N = std::min<size_t>(Args.size(),
+                                              Shape.ParamKinds.size());
+         I != N; ++I) {
+      if (!isCompatibleCallArg(Shape.ParamKinds[I], Args[I])) {
+        Result = TDK_NonDeducedMismatch;
+        break;
+      }
+    }
+  }
+
+  if (Result && TemplateStatistics)
+    TemplateStatistics->noteDeduction(FunctionTemplate, /*Failed=*/true);
+  return Result;
+}
+
 QualType Sema::adjustCCAndNoReturn(QualType ArgFunctionType,
                                    QualType FunctionType) {
   if (ArgFunctionType.isNull())
@@ -3581,13 +3680,11 @@ QualType Sema::adjustCCAndNoReturn(QualType ArgFunctionType,
 /// about template argument deduction.
 ///
 /// \returns the result of template argument deduction.
-Sema::TemplateDeductionResult
-Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
-                              TemplateArgumentListInfo *ExplicitTemplateArgs,
-                              QualType ArgFunctionType,
-                              FunctionDecl *&Specialization,
-                              TemplateDeductionInfo &Info,
-                              bool InOverloadResolution) {
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsImpl(
+    FunctionTemplateDecl *FunctionTemplate,
+    TemplateArgumentListInfo *ExplicitTemplateArgs, QualType ArgFunctionType,
+    FunctionDecl *&Specialization, TemplateDeductionInfo &Info,
+    bool InOverloadResolution) {
   if (FunctionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
@@ -3783,11 +3880,9 @@ SpecializeCorrespondingLambdaCallOperatorAndInvoker(
 /// \brief Deduce template arguments for a templated conversion
 /// function (C++ [temp.deduct.conv]) and, if successful, produce a
 /// conversion function template specialization.
-Sema::TemplateDeductionResult
-Sema::DeduceTemplateArguments(FunctionTemplateDecl *ConversionTemplate,
-                              QualType ToType,
-                              CXXConversionDecl *&Specialization,
-                              TemplateDeductionInfo &Info) {
+Sema::TemplateDeductionResult Sema::DeduceTemplateArgumentsImpl(
+    FunctionTemplateDecl *ConversionTemplate, QualType ToType,
+    CXXConversionDecl *&Specialization, TemplateDeductionInfo &Info) {
   if (ConversionTemplate->isInvalidDecl())
     return TDK_Invalid;
 
@@ -3918,6 +4013,152 @@ Sema::DeduceTemplateArguments(FunctionTemplateDecl *ConversionTemplate,
   return Result;
 }
 
+//===----------------------------------------------------------------------===//
+// Deduction cache
+//===----------------------------------------------------------------------===//
+
+void Sema::DeducedCallSpecialization::Profile(llvm::FoldingSetNodeID &ID,
+                                              FunctionTemplateDecl *Template,
+                                              ArrayRef<CallArgKey> Args) {
+  ID.AddPointer(Template);
+  ID.AddInteger(Args.size());
+  for (const CallArgKey &Arg : Args) {
+    ID.AddPointer(Arg.first.getAsOpaquePtr());
+    ID.AddInteger(Arg.second);
+  }
+}
+
+/// \brief Compute the key under which the specialization deduced for a call
+/// with the arguments \p Args is remembered.
+///
+/// \returns false if deduction may depend on more than the types and value
+/// kinds of the arguments, in which case the result is not remembered.
+static bool getDeducedCallArgKeys(
+    ASTContext &Context, ArrayRef<Expr *> Args,
+    SmallVectorImpl<Sema::DeducedCallSpecialization::CallArgKey> &Keys) {
+  for (Expr *Arg : Args) {
+    // Initializer lists and overload sets are deduced from by looking at the
+    // expressions themselves, and deduction may complete the bound of an
+    // argument of incomplete array type.
+    QualType ArgType = Arg->getType();
+    if (isa<InitListExpr>(Arg) || ArgType->isPlaceholderType() ||
+        ArgType->isDependentType() || ArgType->isIncompleteArrayType())
+      return false;
+    Keys.push_back(std::make_pair(Context.getCanonicalType(ArgType),
+                                  Arg->getValueKind()));
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Deduction statistics
+//===----------------------------------------------------------------------===//
+
+/// \brief Record the result of deducing the template arguments of
+/// \p Template for -ftemplate-stats.
+static Sema::TemplateDeductionResult
+noteDeductionResult(Sema &S, const Decl *Template,
+                    Sema::TemplateDeductionResult Result) {
+  if (S.TemplateStatistics)
+    S.TemplateStatistics->noteDeduction(Template,
+                                        Result != Sema::TDK_Success);
+  return Result;
+}
+
+Sema::TemplateDeductionResult
+Sema::DeduceTemplateArguments(ClassTemplatePartialSpecializationDecl *Partial,
+                              const TemplateArgumentList &TemplateArgs,
+                              TemplateDeductionInfo &Info) {
+  return noteDeductionResult(
+      *this, Partial->getSpecializedTemplate(),
+      DeduceTemplateArgumentsImpl(Partial, TemplateArgs, Info));
+}
+
+Sema::TemplateDeductionResult
+Sema::DeduceTemplateArguments(VarTemplatePartialSpecializationDecl *Partial,
+                              const TemplateArgumentList &TemplateArgs,
+                              TemplateDeductionInfo &Info) {
+  return noteDeductionResult(
+      *this, Partial->getSpecializedTemplate(),
+      DeduceTemplateArgumentsImpl(Partial, TemplateArgs, Info));
+}
+
+Sema::TemplateDeductionResult Sema::DeduceTemplateArguments(
+    FunctionTemplateDecl *FunctionTemplate,
+    TemplateArgumentListInfo *ExplicitTemplateArgs, ArrayRef<Expr *> Args,
+    FunctionDecl *&Specialization, TemplateDeductionInfo &Info,
+    bool PartialOverloading) {
+  // Without explicit template arguments, the result of deduction only depends
+  // on the types and value kinds of the arguments, so a call with the same
+  // ones as an earlier successful call yields the same specialization. The
+  // specialization may have been found to be invalid since, in which case
+  // deduction is performed again to produce the substitution failure.
+  SmallVector<DeducedCallSpecialization::CallArgKey, 4> ArgKeys;
+  bool Cacheable = !ExplicitTemplateArgs && !PartialOverloading &&
+                   getDeducedCallArgKeys(Context, Args, ArgKeys);
+  llvm::FoldingSetNodeID ID;
+  DeducedCallSpecialization *Known = nullptr;
+  if (Cacheable) {
+    DeducedCallSpecialization::Profile(ID, FunctionTemplate, ArgKeys);
+    void *InsertPos = nullptr;
+    Known = DeducedCallSpecializations.FindNodeOrInsertPos(ID, InsertPos);
+    if (Known && !Known->getSpecialization()->isInvalidDecl()) {
+      Specialization = Known->getSpecialization();
+      return noteDeductionResult(*this, FunctionTemplate, TDK_Success);
+    }
+  }
+
+  TemplateDeductionResult Result =
+      DeduceTemplateArgumentsImpl(FunctionTemplate, ExplicitTemplateArgs, Args,
+                                  Specialization, Info, PartialOverloading);
+  if (Cacheable && Result == TDK_Success) {
+    if (Known) {
+      Known->setSpecialization(Specialization);
+    } else {
+      // Deduction may have remembered other calls, so look up the insertion
+      // position again.
+      void *InsertPos = nullptr;
+      if (!DeducedCallSpecializations.FindNodeOrInsertPos(ID, InsertPos)) {
+        DeducedCallSpecialization::CallArgKey *Keys =
+            BumpAlloc.Allocate<DeducedCallSpecialization::CallArgKey>(
+                ArgKeys.size());
+        std::uninitialized_copy(ArgKeys.begin(), ArgKeys.end(), Keys);
+        DeducedCallSpecializations.InsertNode(
+            new (BumpAlloc) DeducedCallSpecialization(
+                FunctionTemplate, llvm::makeArrayRef(Keys, ArgKeys.size()),
+                Specialization),
+            InsertPos);
+      }
+    }
+  }
+  return noteDeductionResult(*this, FunctionTemplate, Result);
+}
+
+Sema::TemplateDeductionResult
+Sema::DeduceTemplateArguments(FunctionTemplateDecl *FunctionTemplate,
+                              TemplateArgumentListInfo *ExplicitTemplateArgs,
+                              QualType ArgFunctionType,
+                              FunctionDecl *&Specialization,
+                              TemplateDeductionInfo &Info,
+                              bool InOverloadResolution) {
+  return noteDeductionResult(
+      *this, FunctionTemplate,
+      DeduceTemplateArgumentsImpl(FunctionTemplate, ExplicitTemplateArgs,
+                                  ArgFunctionType, Specialization, Info,
+                                  InOverloadResolution));
+}
+
+Sema::TemplateDeductionResult
+Sema::DeduceTemplateArguments(FunctionTemplateDecl *ConversionTemplate,
+                              QualType ToType,
+                              CXXConversionDecl *&Specialization,
+                              TemplateDeductionInfo &Info) {
+  return noteDeductionResult(
+      *this, ConversionTemplate,
+      DeduceTemplateArgumentsImpl(ConversionTemplate, ToType, Specialization,
+                                  Info));
+}
+
 /// \brief Deduce template arguments for a function template when there is
 /// nothing to deduce against (C++0x [temp.arg.explicit]p3).
 ///
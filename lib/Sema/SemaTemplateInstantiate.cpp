@@ -18,11 +18,13 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/LangOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateStats.h"
 
 using namespace clang;
 using namespace sema;
@@ -200,6 +202,31 @@ bool Sema::ActiveTemplateInstantiation::isInstantiationRecord() const {
   llvm_unreachable("Invalid InstantiationKind!");
 }
 
+/// The name of the -ftime-trace event recorded for an instantiation of the
+/// given kind.
+static const char *
+getTimeTraceEventName(Sema::ActiveTemplateInstantiation::InstantiationKind K) {
+  switch (K) {
+  case Sema::ActiveTemplateInstantiation::TemplateInstantiation:
+    return "InstantiateTemplate";
+  case Sema::ActiveTemplateInstantiation::DefaultTemplateArgumentInstantiation:
+    return "InstantiateDefaultTemplateArgument";
+  case Sema::ActiveTemplateInstantiation::DefaultFunctionArgumentInstantiation:
+    return "InstantiateDefaultFunctionArgument";
+  case Sema::ActiveTemplateInstantiation::ExplicitTemplateArgumentSubstitution:
+    return "SubstituteExplicitTemplateArguments";
+  case Sema::ActiveTemplateInstantiation::DeducedTemplateArgumentSubstitution:
+    return "SubstituteDeducedTemplateArguments";
+  case Sema::ActiveTemplateInstantiation::PriorTemplateArgumentSubstitution:
+    return "SubstitutePriorTemplateArgument";
+  case Sema::ActiveTemplateInstantiation::DefaultTemplateArgumentChecking:
+    return "CheckDefaultTemplateArgument";
+  case Sema::ActiveTemplateInstantiation::ExceptionSpecInstantiation:
+    return "InstantiateExceptionSpec";
+  }
+  llvm_unreachable("Invalid InstantiationKind!");
+}
+
 Sema::InstantiatingTemplate::InstantiatingTemplate(
     Sema &SemaRef, ActiveTemplateInstantiation::InstantiationKind Kind,
     SourceLocation PointOfInstantiation, SourceRange InstantiationRange,
@@ -228,6 +255,20 @@ Sema::InstantiatingTemplate::InstantiatingTemplate(
     SemaRef.ActiveTemplateInstantiations.push_back(Inst);
     if (!Inst.isInstantiationRecord())
       ++SemaRef.NonInstantiationEntries;
+
+    // The event ends when the instantiation is popped again, in Clear().
+    if (isTimeTraceEnabled())
+      beginTimeTraceEvent(getTimeTraceEventName(Kind), [&]() -> std::string {
+        std::string Name;
+        llvm::raw_string_ostream OS(Name);
+        if (const NamedDecl *ND = dyn_cast_or_null<NamedDecl>(Entity))
+          ND->getNameForDiagnostic(OS, SemaRef.getPrintingPolicy(),
+                                   /*Qualified=*/true);
+        return OS.str();
+      });
+    if (SemaRef.TemplateStatistics &&
+        Kind == ActiveTemplateInstantiation::TemplateInstantiation)
+      SemaRef.TemplateStatistics->startInstantiation(Entity);
   }
 }
 
@@ -344,7 +385,13 @@ void Sema::InstantiatingTemplate::Clear() {
       SemaRef.ActiveTemplateInstantiationLookupModules.pop_back();
     }
 
+    if (SemaRef.TemplateStatistics &&
+        SemaRef.ActiveTemplateInstantiations.back().Kind ==
+            ActiveTemplateInstantiation::TemplateInstantiation)
+      SemaRef.TemplateStatistics->finishInstantiation();
     SemaRef.ActiveTemplateInstantiations.pop_back();
+    if (isTimeTraceEnabled())
+      endTimeTraceEvent();
     Invalid = true;
   }
 }
@@ -19,9 +19,11 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/TypeLoc.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/PrettyDeclStackTrace.h"
 #include "clang/Sema/Template.h"
+#include "clang/Sema/TemplateStats.h"
 
 using namespace clang;
 
@@ -1398,6 +1400,9 @@ Decl *TemplateDeclInstantiator::VisitFunctionDecl(FunctionDecl *D,
     void *InsertPos = nullptr;
     FunctionDecl *SpecFunc
       = FunctionTemplate->findSpecialization(Innermost, InsertPos);
+    if (SemaRef.TemplateStatistics)
+      SemaRef.TemplateStatistics->noteSpecializationLookup(FunctionTemplate,
+                                                           SpecFunc);
 
     // If we already have a function template specialization, return it.
     if (SpecFunc)
@@ -1675,6 +1680,9 @@ TemplateDeclInstantiator::VisitCXXMethodDecl(CXXMethodDecl *D,
     void *InsertPos = nullptr;
     FunctionDecl *SpecFunc
       = FunctionTemplate->findSpecialization(Innermost, InsertPos);
+    if (SemaRef.TemplateStatistics)
+      SemaRef.TemplateStatistics->noteSpecializationLookup(FunctionTemplate,
+                                                           SpecFunc);
 
     // If we already have a function template specialization, return it.
     if (SpecFunc)
@@ -4672,6 +4680,7 @@ NamedDecl *Sema::FindInstantiatedDecl(SourceLocation Loc, NamedDecl *D,
 /// \brief Performs template instantiation for all implicit template
 /// instantiations we have seen until this point.
 void Sema::PerformPendingInstantiations(bool LocalOnly) {
+  TimeTraceScope TimeScope("PerformPendingInstantiations");
   while (!PendingLocalImplicitInstantiations.empty() ||
          (!LocalOnly && !PendingInstantiations.empty())) {
     PendingImplicitInstantiation Inst;
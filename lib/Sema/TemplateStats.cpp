@@ -0,0 +1,207 @@
+//===--- TemplateStats.cpp - Per-template instantiation statistics --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TemplateStats class, which collects the
+//  per-template statistics written by -ftemplate-stats.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateStats.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/JsonSupport.h"
+#include "clang/Basic/SourceManager.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+const Decl *TemplateStats::getTemplate(const Decl *D) {
+  if (const ClassTemplateSpecializationDecl *Spec =
+          dyn_cast<ClassTemplateSpecializationDecl>(D))
+    D = Spec->getSpecializedTemplate();
+  else if (const VarTemplateSpecializationDecl *Spec =
+               dyn_cast<VarTemplateSpecializationDecl>(D))
+    D = Spec->getSpecializedTemplate();
+  else if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    if (const FunctionTemplateDecl *Template = FD->getPrimaryTemplate())
+      D = Template;
+    else if (const FunctionDecl *Member =
+                 FD->getInstantiatedFromMemberFunction())
+      D = Member;
+  } else if (const CXXRecordDecl *RD = dyn_cast<CXXRecordDecl>(D)) {
+    if (const CXXRecordDecl *Member = RD->getInstantiatedFromMemberClass())
+      D = Member;
+  } else if (const EnumDecl *ED = dyn_cast<EnumDecl>(D)) {
+    if (const EnumDecl *Member = ED->getInstantiatedFromMemberEnum())
+      D = Member;
+  } else if (const VarDecl *VD = dyn_cast<VarDecl>(D)) {
+    if (const VarDecl *Member = VD->getInstantiatedFromStaticDataMember())
+      D = Member;
+  }
+  return D->getCanonicalDecl();
+}
+
+void TemplateStats::startInstantiation(const Decl *Specialization) {
+  Frame F;
+  F.Template = getTemplate(Specialization);
+  F.Specialization = Specialization->getCanonicalDecl();
+  F.Start = ClockType::now();
+  F.StartBytes = Context.getAllocator().getBytesAllocated();
+  F.ChildTime = DurationType(0);
+  F.ChildBytes = 0;
+  Stack.push_back(F);
+}
+
+void TemplateStats::finishInstantiation() {
+  if (Stack.empty())
+    return;
+
+  Frame F = Stack.pop_back_val();
+  DurationType Time =
+      std::chrono::duration_cast<DurationType>(ClockType::now() - F.Start);
+  uint64_t Bytes = Context.getAllocator().getBytesAllocated() - F.StartBytes;
+
+  // Only the outermost of several nested instantiations of the same template
+  // or specialization counts towards its inclusive totals.
+  bool NestedTemplate = false, NestedSpecialization = false;
+  for (const Frame &Outer : Stack) {
+    NestedTemplate |= Outer.Template == F.Template;
+    NestedSpecialization |= Outer.Specialization == F.Specialization;
+  }
+
+  TemplateEntry &Entry = Templates[F.Template];
+  Cost &Spec = Entry.Specializations[F.Specialization];
+  for (Cost *C : {&Entry.Total, &Spec}) {
+    ++C->Instantiations;
+    C->SelfTime += Time - F.ChildTime;
+    C->SelfBytes += Bytes - F.ChildBytes;
+  }
+  if (!NestedTemplate) {
+    Entry.Total.Time += Time;
+    Entry.Total.Bytes += Bytes;
+  }
+  if (!NestedSpecialization) {
+    Spec.Time += Time;
+    Spec.Bytes += Bytes;
+  }
+
+  if (!Stack.empty()) {
+    Stack.back().ChildTime += Time;
+    Stack.back().ChildBytes += Bytes;
+  }
+}
+
+void TemplateStats::noteDeduction(const Decl *Template, bool Failed) {
+  if (IgnoreDeductions)
+    return;
+  TemplateEntry &Entry = Templates[getTemplate(Template)];
+  ++Entry.Deductions;
+  if (Failed)
+    ++Entry.DeductionFailures;
+}
+
+void TemplateStats::noteSpecializationLookup(const Decl *Template,
+                                             bool Found) {
+  TemplateEntry &Entry = Templates[getTemplate(Template)];
+  ++Entry.Lookups;
+  if (Found)
+    ++Entry.LookupHits;
+}
+
+//===----------------------------------------------------------------------===//
+// Report
+//===----------------------------------------------------------------------===//
+
+static void writeName(raw_ostream &OS, const Decl *D,
+                      const PrintingPolicy &Policy) {
+  std::string Name;
+  llvm::raw_string_ostream NameOS(Name);
+  if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+    ND->getNameForDiagnostic(NameOS, Policy, /*Qualified=*/true);
+  writeJSONString(OS, NameOS.str());
+}
+
+static void writeCost(raw_ostream &OS, const TemplateStats::Cost &C) {
+  OS << ",\"instantiations\":" << C.Instantiations
+     << ",\"time us\":" << C.Time.count()
+     << ",\"self time us\":" << C.SelfTime.count()
+     << ",\"ast bytes\":" << C.Bytes
+     << ",\"self ast bytes\":" << C.SelfBytes;
+}
+
+typedef std::pair<const Decl *, TemplateStats::TemplateEntry> TemplateValue;
+typedef std::pair<const Decl *, TemplateStats::Cost> SpecializationValue;
+
+static const TemplateStats::Cost &getCost(const TemplateValue &V) {
+  return V.second.Total;
+}
+
+static const TemplateStats::Cost &getCost(const SpecializationValue &V) {
+  return V.second;
+}
+
+void TemplateStats::write(raw_ostream &OS,
+                          const PrintingPolicy &Policy) const {
+  const SourceManager &SM = Context.getSourceManager();
+
+  // The most expensive templates and specializations come first; ties keep
+  // the order in which they were first seen.
+  std::vector<const TemplateValue *> SortedTemplates;
+  for (const TemplateValue &V : Templates)
+    SortedTemplates.push_back(&V);
+  std::stable_sort(SortedTemplates.begin(), SortedTemplates.end(),
+                   [](const TemplateValue *A, const TemplateValue *B) {
+                     return getCost(*A).Time > getCost(*B).Time;
+                   });
+
+  OS << "{\"templates\":[";
+  bool FirstTemplate = true;
+  for (const TemplateValue *V : SortedTemplates) {
+    const Decl *Template = V->first;
+    const TemplateEntry &Entry = V->second;
+
+    OS << (FirstTemplate ? "\n" : ",\n") << "{\"name\":";
+    FirstTemplate = false;
+    writeName(OS, Template, Policy);
+    OS << ",\"kind\":";
+    writeJSONString(OS, Template->getDeclKindName());
+    OS << ",\"location\":";
+    std::string Location;
+    llvm::raw_string_ostream LocationOS(Location);
+    Template->getLocation().print(LocationOS, SM);
+    writeJSONString(OS, LocationOS.str());
+    writeCost(OS, Entry.Total);
+    OS << ",\"deductions\":" << Entry.Deductions
+       << ",\"deduction failures\":" << Entry.DeductionFailures
+       << ",\"lookups\":" << Entry.Lookups
+       << ",\"lookup hits\":" << Entry.LookupHits
+       << ",\"specializations\":[";
+
+    std::vector<const SpecializationValue *> SortedSpecs;
+    for (const SpecializationValue &S : Entry.Specializations)
+      SortedSpecs.push_back(&S);
+    std::stable_sort(SortedSpecs.begin(), SortedSpecs.end(),
+                     [](const SpecializationValue *A,
+                        const SpecializationValue *B) {
+                       return getCost(*A).Time > getCost(*B).Time;
+                     });
+
+    bool FirstSpec = true;
+    for (const SpecializationValue *S : SortedSpecs) {
+      OS << (FirstSpec ? "\n" : ",\n") << "  {\"name\":";
+      FirstSpec = false;
+      writeName(OS, S->first, Policy);
+      writeCost(OS, S->second);
+      OS << '}';
+    }
+    OS << "]}";
+  }
+  OS << "\n]}\n";
+}
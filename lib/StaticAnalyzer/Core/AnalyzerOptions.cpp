@@ -69,6 +69,33 @@ IPAKind AnalyzerOptions::getIPAMode() {
   return IPAMode;
 }
 
+static ExplorationStrategyKind parseExplorationStrategy(StringRef Strategy) {
+  return llvm::StringSwitch<ExplorationStrategyKind>(Strategy)
+    .Case("dfs", ESK_DFS)
+    .Case("bfs", ESK_BFS)
+    .Case("bfs-block-dfs-contents", ESK_BFSBlockDFSContents)
+    .Case("unexplored-first", ESK_UnexploredFirst)
+    .Case("unexplored-first-queue", ESK_UnexploredFirstQueue)
+    .Default(ESK_NotSet);
+}
+
+bool AnalyzerOptions::isValidExplorationStrategy(StringRef Strategy) {
+  return parseExplorationStrategy(Strategy) != ESK_NotSet;
+}
+
+ExplorationStrategyKind AnalyzerOptions::getExplorationStrategy() {
+  if (ExplorationStrategy == ESK_NotSet) {
+    StringRef StratStr =
+        Config.insert(std::make_pair("exploration-strategy", "dfs"))
+            .first->second;
+    ExplorationStrategy = parseExplorationStrategy(StratStr);
+    // Invalid values are diagnosed when the options are parsed.
+    assert(ExplorationStrategy != ESK_NotSet &&
+           "Exploration strategy is invalid.");
+  }
+  return ExplorationStrategy;
+}
+
 bool
 AnalyzerOptions::mayInlineCXXMemberFunction(CXXInlineableMemberKind K) {
   if (getIPAMode() < IPAK_Inlining)
@@ -344,3 +371,10 @@ bool AnalyzerOptions::shouldWidenLoops() {
     WidenLoops = getBooleanOption("widen-loops", /*Default=*/false);
   return WidenLoops.getValue();
 }
+
+unsigned AnalyzerOptions::getRegionStoreFlatClusterLimit() {
+  if (!RegionStoreFlatClusterLimit.hasValue())
+    RegionStoreFlatClusterLimit =
+        getOptionAsInteger("region-store-flat-cluster-limit", 8);
+  return RegionStoreFlatClusterLimit.getValue();
+}
@@ -14,9 +14,13 @@
 #include "clang/StaticAnalyzer/Core/CheckerManager.h"
 #include "clang/AST/DeclBase.h"
 #include "clang/Analysis/ProgramPoint.h"
+#include "clang/Basic/JsonSupport.h"
 #include "clang/StaticAnalyzer/Core/Checker.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
@@ -74,16 +78,20 @@ void CheckerManager::runCheckersOnASTDecl(const Decl *D, AnalysisManager& mgr,
 
   assert(checkers);
   for (CachedDeclCheckers::iterator
-         I = checkers->begin(), E = checkers->end(); I != E; ++I)
+         I = checkers->begin(), E = checkers->end(); I != E; ++I) {
+    ProfileScope Scope(*this, I->Checker, CK_ASTDecl);
     (*I)(D, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
                                           BugReporter &BR) {
   assert(D && D->hasBody());
 
-  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i) {
+    ProfileScope Scope(*this, BodyCheckers[i].Checker, CK_ASTCodeBody);
     BodyCheckers[i](D, mgr, BR);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -105,6 +113,8 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     return;
   }
 
+  CheckerManager &Mgr = checkCtx.Eng.getCheckerManager();
+  const ExplodedGraph &G = checkCtx.Eng.getGraph();
   ExplodedNodeSet Tmp1, Tmp2;
   const ExplodedNodeSet *PrevSet = &Src;
 
@@ -120,6 +130,8 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
     for (ExplodedNodeSet::iterator NI = PrevSet->begin(), NE = PrevSet->end();
          NI != NE; ++NI) {
+      CheckerManager::ProfileScope Scope(Mgr, I->Checker,
+                                         checkCtx.getCallbackKind(), &G);
       checkCtx.runChecker(*I, B, *NI);
     }
 
@@ -149,6 +161,11 @@ namespace {
       : IsPreVisit(isPreVisit), Checkers(checkers), S(s), Eng(eng),
         WasInlined(wasInlined) {}
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return IsPreVisit ? CheckerManager::CK_PreStmt
+                        : CheckerManager::CK_PostStmt;
+    }
+
     void runChecker(CheckerManager::CheckStmtFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       // FIXME: Remove respondsToCallback from CheckerContext;
@@ -194,6 +211,18 @@ namespace {
       : Kind(visitKind), WasInlined(wasInlined), Checkers(checkers),
         Msg(msg), Eng(eng) { }
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      switch (Kind) {
+      case ObjCMessageVisitKind::Pre:
+        return CheckerManager::CK_PreObjCMessage;
+      case ObjCMessageVisitKind::Post:
+        return CheckerManager::CK_PostObjCMessage;
+      case ObjCMessageVisitKind::MessageNil:
+        return CheckerManager::CK_ObjCMessageNil;
+      }
+      llvm_unreachable("Unknown Kind");
+    }
+
     void runChecker(CheckerManager::CheckObjCMessageFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
 
@@ -261,6 +290,11 @@ namespace {
     : IsPreVisit(isPreVisit), WasInlined(wasInlined), Checkers(checkers),
       Call(call), Eng(eng) { }
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return IsPreVisit ? CheckerManager::CK_PreCall
+                        : CheckerManager::CK_PostCall;
+    }
+
     void runChecker(CheckerManager::CheckCallFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       const ProgramPoint &L = Call.getProgramPoint(IsPreVisit,checkFn.Checker);
@@ -305,6 +339,10 @@ namespace {
       : Checkers(checkers), Loc(loc), IsLoad(isLoad), NodeEx(NodeEx),
         BoundEx(BoundEx), Eng(eng) {}
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return CheckerManager::CK_Location;
+    }
+
     void runChecker(CheckerManager::CheckLocationFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       ProgramPoint::Kind K =  IsLoad ? ProgramPoint::PreLoadKind :
@@ -350,6 +388,10 @@ namespace {
                      const ProgramPoint &pp)
       : Checkers(checkers), Loc(loc), Val(val), S(s), Eng(eng), PP(pp) {}
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return CheckerManager::CK_Bind;
+    }
+
     void runChecker(CheckerManager::CheckBindFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       const ProgramPoint &L = PP.withTag(checkFn.Checker);
@@ -373,8 +415,10 @@ void CheckerManager::runCheckersForBind(ExplodedNodeSet &Dst,
 void CheckerManager::runCheckersForEndAnalysis(ExplodedGraph &G,
                                                BugReporter &BR,
                                                ExprEngine &Eng) {
-  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndAnalysisCheckers.size(); i != e; ++i) {
+    ProfileScope Scope(*this, EndAnalysisCheckers[i].Checker, CK_EndAnalysis);
     EndAnalysisCheckers[i](G, BR, Eng);
+  }
 }
 
 namespace {
@@ -391,6 +435,10 @@ struct CheckBeginFunctionContext {
                             const ProgramPoint &PP)
       : Checkers(Checkers), Eng(Eng), PP(PP) {}
 
+  CheckerManager::CallbackKind getCallbackKind() const {
+    return CheckerManager::CK_BeginFunction;
+  }
+
   void runChecker(CheckerManager::CheckBeginFunctionFunc checkFn,
                   NodeBuilder &Bldr, ExplodedNode *Pred) {
     const ProgramPoint &L = PP.withTag(checkFn.Checker);
@@ -429,6 +477,8 @@ void CheckerManager::runCheckersForEndFunction(NodeBuilderContext &BC,
     const ProgramPoint &L = BlockEntrance(BC.Block,
                                           Pred->getLocationContext(),
                                           checkFn.Checker);
+    ProfileScope Scope(*this, checkFn.Checker, CK_EndFunction,
+                       &Eng.getGraph());
     CheckerContext C(Bldr, Eng, Pred, L);
     checkFn(C);
   }
@@ -448,6 +498,10 @@ namespace {
                                 const Stmt *Cond, ExprEngine &eng)
       : Checkers(checkers), Condition(Cond), Eng(eng) {}
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return CheckerManager::CK_BranchCondition;
+    }
+
     void runChecker(CheckerManager::CheckBranchConditionFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       ProgramPoint L = PostCondition(Condition, Pred->getLocationContext(),
@@ -472,8 +526,10 @@ void CheckerManager::runCheckersForBranchCondition(const Stmt *Condition,
 /// \brief Run checkers for live symbols.
 void CheckerManager::runCheckersForLiveSymbols(ProgramStateRef state,
                                                SymbolReaper &SymReaper) {
-  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = LiveSymbolsCheckers.size(); i != e; ++i) {
+    ProfileScope Scope(*this, LiveSymbolsCheckers[i].Checker, CK_LiveSymbols);
     LiveSymbolsCheckers[i](state, SymReaper);
+  }
 }
 
 namespace {
@@ -493,6 +549,10 @@ namespace {
                             ProgramPoint::Kind K)
       : Checkers(checkers), SR(sr), S(s), Eng(eng), ProgarmPointKind(K) { }
 
+    CheckerManager::CallbackKind getCallbackKind() const {
+      return CheckerManager::CK_DeadSymbols;
+    }
+
     void runChecker(CheckerManager::CheckDeadSymbolsFunc checkFn,
                     NodeBuilder &Bldr, ExplodedNode *Pred) {
       const ProgramPoint &L = ProgramPoint::getProgramPoint(S, ProgarmPointKind,
@@ -539,6 +599,8 @@ CheckerManager::runCheckersForRegionChanges(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    ProfileScope Scope(*this, RegionChangesCheckers[i].CheckFn.Checker,
+                       CK_RegionChanges);
     state = RegionChangesCheckers[i].CheckFn(state, invalidated,
                                              ExplicitRegions, Regions, Call);
   }
@@ -561,6 +623,8 @@ CheckerManager::runCheckersForPointerEscape(ProgramStateRef State,
       //  way), bail out.
       if (!State)
         return nullptr;
+      ProfileScope Scope(*this, PointerEscapeCheckers[i].Checker,
+                         CK_PointerEscape);
       State = PointerEscapeCheckers[i](State, Escaped, Call, Kind, ETraits);
     }
   return State;
@@ -575,6 +639,7 @@ CheckerManager::runCheckersForEvalAssume(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    ProfileScope Scope(*this, EvalAssumeCheckers[i].Checker, CK_EvalAssume);
     state = EvalAssumeCheckers[i](state, Cond, Assumption);
   }
   return state;
@@ -606,6 +671,7 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        ProfileScope Scope(*this, EI->Checker, CK_EvalCall, &Eng.getGraph());
         CheckerContext C(B, Eng, Pred, L);
         evaluated = (*EI)(CE, C);
       }
@@ -633,8 +699,11 @@ void CheckerManager::runCheckersOnEndOfTranslationUnit(
                                                   const TranslationUnitDecl *TU,
                                                   AnalysisManager &mgr,
                                                   BugReporter &BR) {
-  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = EndOfTranslationUnitCheckers.size(); i != e; ++i) {
+    ProfileScope Scope(*this, EndOfTranslationUnitCheckers[i].Checker,
+                       CK_EndOfTranslationUnit);
     EndOfTranslationUnitCheckers[i](TU, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
@@ -645,6 +714,216 @@ void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
     I->second->printState(Out, State, NL, Sep);
 }
 
+//===----------------------------------------------------------------------===//
+// Profiling.
+//===----------------------------------------------------------------------===//
+
+void CheckerManager::ProfileScope::start() {
+  Parent = Mgr->ActiveProfileScope;
+  Mgr->ActiveProfileScope = this;
+  StartNodes = G ? G->size() : 0;
+  Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+}
+
+void CheckerManager::ProfileScope::finish() {
+  llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+  Elapsed -= Start;
+  unsigned Nodes = G ? G->size() - StartNodes : 0;
+
+  // Charge the enclosing callback for the nested one's time only once, here.
+  if (Parent) {
+    Parent->Nested += Elapsed;
+    Parent->NestedNodes += Nodes;
+  }
+  Mgr->ActiveProfileScope = Parent;
+
+  CallbackProfile &P = Mgr->Profiles[ProfileKey(Checker, Kind)];
+  Elapsed -= Nested;
+  P.Time += Elapsed;
+  ++P.NumCalls;
+  // Nested callbacks may have been given a graph when this one was not.
+  if (Nodes >= NestedNodes)
+    P.NumNodes += Nodes - NestedNodes;
+}
+
+static const char *getCallbackKindName(unsigned Kind) {
+  switch (static_cast<CheckerManager::CallbackKind>(Kind)) {
+  case CheckerManager::CK_ASTDecl: return "ASTDecl";
+  case CheckerManager::CK_ASTCodeBody: return "ASTCodeBody";
+  case CheckerManager::CK_EndOfTranslationUnit: return "EndOfTranslationUnit";
+  case CheckerManager::CK_EndAnalysis: return "EndAnalysis";
+  case CheckerManager::CK_PreStmt: return "PreStmt";
+  case CheckerManager::CK_PostStmt: return "PostStmt";
+  case CheckerManager::CK_PreObjCMessage: return "PreObjCMessage";
+  case CheckerManager::CK_PostObjCMessage: return "PostObjCMessage";
+  case CheckerManager::CK_ObjCMessageNil: return "ObjCMessageNil";
+  case CheckerManager::CK_PreCall: return "PreCall";
+  case CheckerManager::CK_PostCall: return "PostCall";
+  case CheckerManager::CK_Location: return "Location";
+  case CheckerManager::CK_Bind: return "Bind";
+  case CheckerManager::CK_BeginFunction: return "BeginFunction";
+  case CheckerManager::CK_EndFunction: return "EndFunction";
+  case CheckerManager::CK_BranchCondition: return "BranchCondition";
+  case CheckerManager::CK_LiveSymbols: return "LiveSymbols";
+  case CheckerManager::CK_DeadSymbols: return "DeadSymbols";
+  case CheckerManager::CK_RegionChanges: return "RegionChanges";
+  case CheckerManager::CK_PointerEscape: return "PointerEscape";
+  case CheckerManager::CK_EvalAssume: return "EvalAssume";
+  case CheckerManager::CK_EvalCall: return "EvalCall";
+  }
+  llvm_unreachable("Unknown callback kind");
+}
+
+namespace {
+/// The profile of one checker: the sum over its callbacks, and the callbacks
+/// themselves, costliest first.
+struct CheckerProfile {
+  typedef std::pair<unsigned, const CheckerManager::CallbackProfile *>
+      CallbackEntry;
+
+  StringRef Name;
+  CheckerManager::CallbackProfile Total;
+  SmallVector<CallbackEntry, 4> Callbacks;
+};
+}
+
+static bool isCostlier(const CheckerManager::CallbackProfile &LHS,
+                       const CheckerManager::CallbackProfile &RHS) {
+  return LHS.Time.getWallTime() > RHS.Time.getWallTime();
+}
+
+/// Group the collected profiles by checker, costliest checker first.
+static std::vector<CheckerProfile>
+collectCheckerProfiles(const CheckerManager::ProfileMapTy &Profiles,
+                       CheckerManager::CallbackProfile &Total) {
+  llvm::DenseMap<const CheckerBase *, unsigned> Index;
+  std::vector<CheckerProfile> Result;
+  for (const auto &Entry : Profiles) {
+    const CheckerBase *Checker = Entry.first.first;
+    std::pair<llvm::DenseMap<const CheckerBase *, unsigned>::iterator, bool>
+        Inserted = Index.insert(std::make_pair(Checker, Result.size()));
+    if (Inserted.second) {
+      Result.push_back(CheckerProfile());
+      Result.back().Name = Checker->getCheckName().getName();
+      if (Result.back().Name.empty())
+        Result.back().Name = "<unnamed checker>";
+    }
+
+    const CheckerManager::CallbackProfile &P = Entry.second;
+    CheckerProfile &CP = Result[Inserted.first->second];
+    CP.Total.Time += P.Time;
+    CP.Total.NumCalls += P.NumCalls;
+    CP.Total.NumNodes += P.NumNodes;
+    CP.Callbacks.push_back(std::make_pair(Entry.first.second, &P));
+
+    Total.Time += P.Time;
+    Total.NumCalls += P.NumCalls;
+    Total.NumNodes += P.NumNodes;
+  }
+
+  for (CheckerProfile &CP : Result)
+    std::sort(CP.Callbacks.begin(), CP.Callbacks.end(),
+              [](const CheckerProfile::CallbackEntry &LHS,
+                 const CheckerProfile::CallbackEntry &RHS) {
+                if (isCostlier(*LHS.second, *RHS.second))
+                  return true;
+                if (isCostlier(*RHS.second, *LHS.second))
+                  return false;
+                return LHS.first < RHS.first;
+              });
+  std::sort(Result.begin(), Result.end(),
+            [](const CheckerProfile &LHS, const CheckerProfile &RHS) {
+              if (isCostlier(LHS.Total, RHS.Total))
+                return true;
+              if (isCostlier(RHS.Total, LHS.Total))
+                return false;
+              return LHS.Name < RHS.Name;
+            });
+  return Result;
+}
+
+static void printProfileRow(raw_ostream &Out,
+                            const CheckerManager::CallbackProfile &P,
+                            const CheckerManager::CallbackProfile &Total,
+                            StringRef Name) {
+  P.Time.print(Total.Time, Out);
+  Out << llvm::format("%9u  %9u  ", P.NumCalls, P.NumNodes) << Name << '\n';
+}
+
+void CheckerManager::printProfile(raw_ostream &Out) const {
+  CallbackProfile Total;
+  std::vector<CheckerProfile> Checkers =
+      collectCheckerProfiles(Profiles, Total);
+  if (Checkers.empty())
+    return;
+
+  Out << "===" << std::string(73, '-') << "===\n"
+      << "                         Analyzer checker profile\n"
+      << "===" << std::string(73, '-') << "===\n";
+  Out << llvm::format("  Total Execution Time: %5.4f seconds "
+                      "(%5.4f wall clock)\n",
+                      Total.Time.getProcessTime(), Total.Time.getWallTime());
+  Out << '\n';
+
+  // Mirror the columns printed by TimeRecord::print.
+  if (Total.Time.getUserTime())
+    Out << "   ---User Time---";
+  if (Total.Time.getSystemTime())
+    Out << "   --System Time--";
+  if (Total.Time.getProcessTime())
+    Out << "   --User+System--";
+  Out << "   ---Wall Time---";
+  if (Total.Time.getMemUsed())
+    Out << "  ---Mem---";
+  Out << "  --Calls--  --Nodes--  --- Name ---\n";
+
+  for (const CheckerProfile &CP : Checkers) {
+    printProfileRow(Out, CP.Total, Total, CP.Name);
+    for (const auto &Callback : CP.Callbacks)
+      printProfileRow(Out, *Callback.second, Total,
+                      std::string("  ") + getCallbackKindName(Callback.first));
+  }
+  printProfileRow(Out, Total, Total, "Total");
+  Out << '\n';
+  Out.flush();
+}
+
+static void printJSONProfileFields(raw_ostream &Out,
+                                   const CheckerManager::CallbackProfile &P) {
+  Out << "\"wall_time\": " << llvm::format("%.6f", P.Time.getWallTime())
+      << ", \"user_time\": " << llvm::format("%.6f", P.Time.getUserTime())
+      << ", \"system_time\": " << llvm::format("%.6f", P.Time.getSystemTime())
+      << ", \"memory\": " << static_cast<int64_t>(P.Time.getMemUsed())
+      << ", \"calls\": " << P.NumCalls
+      << ", \"nodes\": " << P.NumNodes;
+}
+
+void CheckerManager::printProfileAsJSON(raw_ostream &Out) const {
+  CallbackProfile Total;
+  std::vector<CheckerProfile> Checkers =
+      collectCheckerProfiles(Profiles, Total);
+
+  Out << "{\n  \"checkers\": [";
+  for (unsigned I = 0, E = Checkers.size(); I != E; ++I) {
+    const CheckerProfile &CP = Checkers[I];
+    Out << (I ? ",\n" : "\n") << "    {\"name\": ";
+    writeJSONString(Out, CP.Name);
+    Out << ", ";
+    printJSONProfileFields(Out, CP.Total);
+    Out << ",\n     \"callbacks\": [";
+    for (unsigned J = 0, F = CP.Callbacks.size(); J != F; ++J) {
+      Out << (J ? ",\n" : "\n") << "       {\"kind\": \""
+          << getCallbackKindName(CP.Callbacks[J].first) << "\", ";
+      printJSONProfileFields(Out, *CP.Callbacks[J].second);
+      Out << '}';
+    }
+    Out << "]}";
+  }
+  Out << "],\n  \"total\": {";
+  printJSONProfileFields(Out, Total);
+  Out << "}\n}\n";
+}
+
 //===----------------------------------------------------------------------===//
 // Internal registration functions for AST traversing.
 //===----------------------------------------------------------------------===//
@@ -19,8 +19,10 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
@@ -33,6 +35,11 @@ STATISTIC(NumReachedMaxSteps,
             "The # of times we reached the max number of steps.");
 STATISTIC(NumPathsExplored,
             "The # of paths explored by the analyzer.");
+STATISTIC(MaxWorkListSize,
+            "The maximum # of nodes waiting in the work list.");
+STATISTIC(MaxReachedBlocks,
+            "The maximum # of (block, stack frame) pairs reached while "
+            "exploring unexplored blocks first.");
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -157,10 +164,174 @@ WorkList* WorkList::makeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+namespace {
+  /// Identifies a CFG block within a particular stack frame.
+  typedef std::pair<unsigned, const StackFrameContext *> BlockInFrame;
+
+  static BlockInFrame getBlockInFrame(const ExplodedNode *N,
+                                      const BlockEntrance &BE) {
+    return std::make_pair(BE.getBlock()->getBlockID(),
+                          N->getLocationContext()->getCurrentStackFrame());
+  }
+
+  static void updateMaxStatistic(llvm::Statistic &Stat, unsigned Value) {
+    if (Value > Stat)
+      Stat = Value;
+  }
+
+  /// A DFS which first processes the nodes entering CFG blocks that have not
+  /// been reached before in the current stack frame. When the node budget is
+  /// limited, this spends it on new code instead of going around loops.
+  class UnexploredFirstStack : public WorkList {
+    /// Nodes known to lead to statements that have not been explored yet.
+    SmallVector<WorkListUnit, 20> StackUnexplored;
+    /// All other nodes.
+    SmallVector<WorkListUnit, 20> StackOthers;
+    llvm::DenseSet<BlockInFrame> Reached;
+
+  public:
+    bool hasWork() const override {
+      return !StackUnexplored.empty() || !StackOthers.empty();
+    }
+
+    void enqueue(const WorkListUnit &U) override {
+      const ExplodedNode *N = U.getNode();
+      Optional<BlockEntrance> BE = N->getLocation().getAs<BlockEntrance>();
+      // Nodes inside a block continue whatever the choice of its entrance was.
+      if (!BE || Reached.insert(getBlockInFrame(N, *BE)).second)
+        StackUnexplored.push_back(U);
+      else
+        StackOthers.push_back(U);
+
+      updateMaxStatistic(MaxReachedBlocks, Reached.size());
+      updateMaxStatistic(MaxWorkListSize,
+                         StackUnexplored.size() + StackOthers.size());
+    }
+
+    WorkListUnit dequeue() override {
+      SmallVectorImpl<WorkListUnit> &Stack =
+          StackUnexplored.empty() ? StackOthers : StackUnexplored;
+      assert(!Stack.empty());
+      WorkListUnit U = Stack.back();
+      Stack.pop_back();
+      return U;
+    }
+
+    bool visitItemsInWorkList(Visitor &V) override {
+      for (SmallVectorImpl<WorkListUnit>::iterator
+           I = StackUnexplored.begin(), E = StackUnexplored.end(); I != E; ++I) {
+        if (V.visit(*I))
+          return true;
+      }
+      for (SmallVectorImpl<WorkListUnit>::iterator
+           I = StackOthers.begin(), E = StackOthers.end(); I != E; ++I) {
+        if (V.visit(*I))
+          return true;
+      }
+      return false;
+    }
+  };
+
+  /// A priority queue that orders nodes entering a CFG block by the number of
+  /// times that block has been reached in the current stack frame, and
+  /// otherwise behaves like a DFS. Each further trip around a loop is thus
+  /// postponed until less explored code has had its turn.
+  class UnexploredFirstPriorityQueue : public WorkList {
+    struct QueueItem {
+      WorkListUnit Unit;
+      /// How often the block was reached before this node was enqueued.
+      unsigned TimesReached;
+      /// Insertion order, used to break ties in favor of the newest node.
+      unsigned long Order;
+    };
+
+    /// Returns true if \p LHS should be explored after \p RHS.
+    static bool isLowerPriority(const QueueItem &LHS, const QueueItem &RHS) {
+      if (LHS.TimesReached != RHS.TimesReached)
+        return LHS.TimesReached > RHS.TimesReached;
+      return LHS.Order < RHS.Order;
+    }
+
+    std::vector<QueueItem> Heap;
+    llvm::DenseMap<BlockInFrame, unsigned> TimesReached;
+    unsigned long NextOrder;
+
+  public:
+    UnexploredFirstPriorityQueue() : NextOrder(0) {}
+
+    bool hasWork() const override {
+      return !Heap.empty();
+    }
+
+    void enqueue(const WorkListUnit &U) override {
+      const ExplodedNode *N = U.getNode();
+      unsigned Reached = 0;
+      // Nodes inside a block get the highest priority so that blocks are
+      // processed to completion.
+      if (Optional<BlockEntrance> BE = N->getLocation().getAs<BlockEntrance>())
+        Reached = TimesReached[getBlockInFrame(N, *BE)]++;
+
+      QueueItem Item = { U, Reached, NextOrder++ };
+      Heap.push_back(Item);
+      std::push_heap(Heap.begin(), Heap.end(), isLowerPriority);
+
+      updateMaxStatistic(MaxReachedBlocks, TimesReached.size());
+      updateMaxStatistic(MaxWorkListSize, Heap.size());
+    }
+
+    WorkListUnit dequeue() override {
+      assert(!Heap.empty());
+      std::pop_heap(Heap.begin(), Heap.end(), isLowerPriority);
+      WorkListUnit U = Heap.back().Unit;
+      Heap.pop_back();
+      return U;
+    }
+
+    bool visitItemsInWorkList(Visitor &V) override {
+      for (std::vector<QueueItem>::iterator
+           I = Heap.begin(), E = Heap.end(); I != E; ++I) {
+        if (V.visit(I->Unit))
+          return true;
+      }
+      return false;
+    }
+  };
+} // end anonymous namespace
+
+WorkList *WorkList::makeUnexploredFirst() {
+  return new UnexploredFirstStack();
+}
+
+WorkList *WorkList::makeUnexploredFirstPriorityQueue() {
+  return new UnexploredFirstPriorityQueue();
+}
+
+static WorkList *generateWorkList(AnalyzerOptions &Opts) {
+  switch (Opts.getExplorationStrategy()) {
+  case ESK_NotSet:
+  case ESK_DFS:
+    return WorkList::makeDFS();
+  case ESK_BFS:
+    return WorkList::makeBFS();
+  case ESK_BFSBlockDFSContents:
+    return WorkList::makeBFSBlockDFSContents();
+  case ESK_UnexploredFirst:
+    return WorkList::makeUnexploredFirst();
+  case ESK_UnexploredFirstQueue:
+    return WorkList::makeUnexploredFirstPriorityQueue();
+  }
+  llvm_unreachable("Unknown AnalyzerOptions::ExplorationStrategyKind");
+}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
 
+CoreEngine::CoreEngine(SubEngine &subengine, FunctionSummariesTy *FS,
+                       AnalyzerOptions &Opts)
+    : SubEng(subengine), WList(generateWorkList(Opts)),
+      BCounterFactory(G.getAllocator()), FunctionSummaries(FS) {}
+
 /// ExecuteWorkList - Run the worklist algorithm for a maximum number of steps.
 bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
                                    ProgramStateRef InitState) {
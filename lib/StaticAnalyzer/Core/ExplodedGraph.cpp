@@ -26,6 +26,13 @@
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ExplodedGraph"
+
+STATISTIC(NumReclaimedNodes,
+          "The # of ExplodedNodes reclaimed during graph trimming");
+STATISTIC(NumMaxExplodedNodes,
+          "The maximum # of ExplodedNodes alive in a single exploded graph");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -50,7 +57,14 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 ExplodedGraph::ExplodedGraph()
   : NumNodes(0), ReclaimNodeInterval(0) {}
 
-ExplodedGraph::~ExplodedGraph() {}
+ExplodedGraph::~ExplodedGraph() {
+  updatePeakNodeStatistic();
+}
+
+void ExplodedGraph::updatePeakNodeStatistic() const {
+  if (NumNodes > NumMaxExplodedNodes)
+    NumMaxExplodedNodes = NumNodes;
+}
 
 //===----------------------------------------------------------------------===//
 // Node reclamation.
@@ -189,11 +203,16 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
     return;
   ReclaimCounter = ReclaimNodeInterval;
 
+  // The graph never shrinks except here, so this is where it peaks.
+  updatePeakNodeStatistic();
+
   for (NodeVector::iterator it = ChangedNodes.begin(), et = ChangedNodes.end();
        it != et; ++it) {
     ExplodedNode *node = *it;
-    if (shouldCollect(node))
+    if (shouldCollect(node)) {
       collectNode(node);
+      ++NumReclaimedNodes;
+    }
   }
   ChangedNodes.clear();
 }
@@ -12,6 +12,13 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/LineIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace clang;
 using namespace ento;
 
@@ -30,3 +37,87 @@ unsigned FunctionSummariesTy::getTotalNumVisitedBasicBlocks() {
   }
   return Total;
 }
+
+// The summaries are stored as text: a header line holding the format version
+// and the fingerprint, followed by one line per function with tab separated
+// fields:
+//   <USR> <body hash> <reports> <visited blocks> <total blocks> <callee USR>*
+static const char SummaryFileMagic[] = "clang-analyzer-summaries-v3";
+
+bool PersistentFunctionSummaries::load(StringRef Path) {
+  Map.clear();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return false;
+
+  llvm::line_iterator Line(**Buffer, /*SkipBlanks=*/true);
+  if (Line.is_at_eof() ||
+      *Line != (Twine(SummaryFileMagic) + " " + Fingerprint).str())
+    return false;
+
+  for (++Line; !Line.is_at_eof(); ++Line) {
+    SmallVector<StringRef, 8> Fields;
+    Line->split(Fields, "\t");
+    Summary S;
+    if (Fields.size() < 5 || Fields[0].empty() ||
+        Fields[2].getAsInteger(10, S.NumReports) ||
+        Fields[3].getAsInteger(10, S.NumVisitedBlocks) ||
+        Fields[4].getAsInteger(10, S.NumTotalBlocks)) {
+      Map.clear();
+      return false;
+    }
+    S.BodyHash = Fields[1];
+    for (unsigned I = 5, E = Fields.size(); I != E; ++I)
+      S.InlinedCallees.push_back(Fields[I]);
+    Map[Fields[0]] = std::move(S);
+  }
+  return true;
+}
+
+void PersistentFunctionSummaries::prune(
+    llvm::function_ref<bool(StringRef USR)> IsLive) {
+  for (MapTy::iterator I = Map.begin(), E = Map.end(); I != E;) {
+    MapTy::iterator Cur = I++;
+    if (!IsLive(Cur->getKey()))
+      Map.erase(Cur);
+  }
+}
+
+bool PersistentFunctionSummaries::save(StringRef Path) const {
+  // Write to a temporary file first, so that concurrent analyzer runs never
+  // observe a partially written cache.
+  StringRef Dir = llvm::sys::path::parent_path(Path);
+  if (!Dir.empty() && llvm::sys::fs::create_directories(Dir))
+    return false;
+
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return false;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << SummaryFileMagic << ' ' << Fingerprint << '\n';
+    for (MapTy::const_iterator I = Map.begin(), E = Map.end(); I != E; ++I) {
+      const Summary &S = I->second;
+      OS << I->getKey() << '\t' << S.BodyHash << '\t' << S.NumReports << '\t'
+         << S.NumVisitedBlocks << '\t' << S.NumTotalBlocks;
+      for (const std::string &Callee : S.InlinedCallees)
+        OS << '\t' << Callee;
+      OS << '\n';
+    }
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return false;
+    }
+  }
+
+  if (llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return false;
+  }
+  return true;
+}
@@ -17,11 +17,17 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/TaintManager.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ProgramState"
+
+STATISTIC(NumMaxLiveStates,
+          "The maximum # of ProgramStates alive at the same time");
+
 namespace clang { namespace  ento {
 /// Increments the number of times this state is referenced.
 
@@ -397,6 +403,8 @@ ProgramStateRef ProgramStateManager::getPersistentState(ProgramState &State) {
   }
   new (newState) ProgramState(State);
   StateSet.InsertNode(newState, InsertPos);
+  if (StateSet.size() > NumMaxLiveStates)
+    NumMaxLiveStates = StateSet.size();
   return newState;
 }
 
@@ -16,10 +16,15 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/APSIntType.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
 
 using namespace clang;
 using namespace ento;
@@ -52,71 +57,139 @@ public:
     ID.AddPointer(&From());
     ID.AddPointer(&To());
   }
-};
-
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
   // When comparing if one Range is less than another, we should compare
   // the actual APSInt values instead of their pointers.  This keeps the order
   // consistent (instead of comparing by pointer values) and can potentially
   // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first || (!(*rhs.first < *lhs.first) &&
-                                       *lhs.second < *rhs.second);
+  static bool isLess(const Range &lhs, const Range &rhs) {
+    return lhs.From() < rhs.From() ||
+           (!(rhs.From() < lhs.From()) && lhs.To() < rhs.To());
+  }
+};
+
+
+/// A hash-consed, sorted array of ranges backing a RangeSet.
+class RangeSetNode : public llvm::FoldingSetNode {
+  unsigned Size;
+
+public:
+  /// The ranges are stored directly after the node.
+  explicit RangeSetNode(unsigned Size) : Size(Size) {}
+
+  const Range *begin() const {
+    return reinterpret_cast<const Range *>(this + 1);
+  }
+  const Range *end() const { return begin() + Size; }
+  unsigned size() const { return Size; }
+
+  static void Profile(llvm::FoldingSetNodeID &ID, const Range *B,
+                      const Range *E) {
+    for (; B != E; ++B)
+      B->Profile(ID);
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    Profile(ID, begin(), end());
   }
 };
 
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// Almost every set holds one or two ranges, so the ranges are kept in a
+/// single sorted array rather than a balanced tree. The arrays are uniqued by
+/// the Factory, which makes equal sets share storage and lets the results of
+/// Intersect and addRange be memoized on the identity of their operands.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
+  const RangeSetNode *Impl; // null for the empty set.
+
+  explicit RangeSet(const RangeSetNode *Impl) : Impl(Impl) {}
+
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  class Factory {
+    typedef std::pair<const llvm::APSInt *, const llvm::APSInt *> Bounds;
+    typedef std::pair<const RangeSetNode *, Bounds> IntersectKey;
+    typedef std::pair<const RangeSetNode *, const RangeSetNode *> UnionKey;
+
+    llvm::BumpPtrAllocator Alloc;
+    llvm::FoldingSet<RangeSetNode> Nodes;
+    llvm::DenseMap<IntersectKey, const RangeSetNode *> IntersectCache;
+    llvm::DenseMap<UnionKey, const RangeSetNode *> UnionCache;
+
+    /// The memoized results are dropped when a cache grows to this many
+    /// entries. The uniqued sets themselves live as long as the Factory.
+    static const unsigned MaxCachedResults = 4096;
+
+    template <typename KeyT>
+    static void cacheResult(llvm::DenseMap<KeyT, const RangeSetNode *> &Cache,
+                            const KeyT &Key, const RangeSetNode *Result) {
+      if (Cache.size() >= MaxCachedResults)
+        Cache.clear();
+      Cache[Key] = Result;
+    }
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+    friend class RangeSet;
+
+  public:
+    RangeSet getEmptySet() { return RangeSet(nullptr); }
+
+    /// Return the unique set holding \p Ranges, which must be sorted.
+    RangeSet getRangeSet(ArrayRef<Range> Ranges);
+  };
+
+  typedef const Range *iterator;
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
-  RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
+  RangeSet addRange(Factory &F, const RangeSet &RS) const {
+    if (RS.isEmpty())
+      return *this;
+    if (isEmpty())
+      return RS;
+
+    Factory::UnionKey Key(Impl, RS.Impl);
+    llvm::DenseMap<Factory::UnionKey, const RangeSetNode *>::iterator I =
+        F.UnionCache.find(Key);
+    if (I != F.UnionCache.end())
+      return RangeSet(I->second);
+
+    SmallVector<Range, 4> Ranges;
+    std::merge(begin(), end(), RS.begin(), RS.end(),
+               std::back_inserter(Ranges), Range::isLess);
+    Ranges.erase(std::unique(Ranges.begin(), Ranges.end()), Ranges.end());
+    RangeSet Result = F.getRangeSet(Ranges);
+    Factory::cacheResult(F.UnionCache, Key, Result.Impl);
+    return Result;
   }
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return Impl ? Impl->begin() : nullptr; }
+  iterator end() const { return Impl ? Impl->end() : nullptr; }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return !Impl; }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-    : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+    : Impl(F.getRangeSet(Range(from, to)).Impl) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
   ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(Impl); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt* getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return Impl && Impl->size() == 1 ? begin()->getConcreteValue() : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
+  void IntersectInRange(BasicValueFactory &BV,
                         const llvm::APSInt &Lower,
                         const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges,
-                        PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+                        SmallVectorImpl<Range> &newRanges,
+                        iterator &i, iterator &e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -135,24 +208,23 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower),
-                                             BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return begin()->From();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -246,23 +318,34 @@ public:
   // or, alternatively, /removing/ all integers between Upper and Lower.
   RangeSet Intersect(BasicValueFactory &BV, Factory &F,
                      llvm::APSInt Lower, llvm::APSInt Upper) const {
-    if (!pin(Lower, Upper))
-      return F.getEmptySet();
-
-    PrimRangeSet newRanges = F.getEmptySet();
-
-    PrimRangeSet::iterator i = begin(), e = end();
-    if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
-    else {
-      // The order of the next two statements is important!
-      // IntersectInRange() does not reset the iteration state for i and e.
-      // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+    if (isEmpty())
+      return *this;
+
+    Factory::IntersectKey Key(
+        Impl, Factory::Bounds(&BV.getValue(Lower), &BV.getValue(Upper)));
+    llvm::DenseMap<Factory::IntersectKey, const RangeSetNode *>::iterator I =
+        F.IntersectCache.find(Key);
+    if (I != F.IntersectCache.end())
+      return RangeSet(I->second);
+
+    RangeSet Result = F.getEmptySet();
+    if (pin(Lower, Upper)) {
+      SmallVector<Range, 4> newRanges;
+      iterator i = begin(), e = end();
+      if (Lower <= Upper)
+        IntersectInRange(BV, Lower, Upper, newRanges, i, e);
+      else {
+        // The order of the next two statements is important!
+        // IntersectInRange() does not reset the iteration state for i and e.
+        // Therefore, the lower range most be handled first.
+        IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+        IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      }
+      Result = F.getRangeSet(newRanges);
     }
 
-    return newRanges;
+    Factory::cacheResult(F.IntersectCache, Key, Result.Impl);
+    return Result;
   }
 
   void print(raw_ostream &os) const {
@@ -281,11 +364,31 @@ public:
   }
 
   bool operator==(const RangeSet &other) const {
-    return ranges == other.ranges;
+    return Impl == other.Impl;
   }
 };
 } // end anonymous namespace
 
+RangeSet RangeSet::Factory::getRangeSet(ArrayRef<Range> Ranges) {
+  if (Ranges.empty())
+    return getEmptySet();
+
+  llvm::FoldingSetNodeID ID;
+  RangeSetNode::Profile(ID, Ranges.begin(), Ranges.end());
+  void *InsertPos;
+  if (RangeSetNode *N = Nodes.FindNodeOrInsertPos(ID, InsertPos))
+    return RangeSet(N);
+
+  void *Mem = Alloc.Allocate(sizeof(RangeSetNode) +
+                                 Ranges.size() * sizeof(Range),
+                             llvm::alignOf<RangeSetNode>());
+  RangeSetNode *N = new (Mem) RangeSetNode(Ranges.size());
+  std::uninitialized_copy(Ranges.begin(), Ranges.end(),
+                          const_cast<Range *>(N->begin()));
+  Nodes.InsertNode(N, InsertPos);
+  return RangeSet(N);
+}
+
 REGISTER_TRAIT_WITH_PROGRAMSTATE(ConstraintRange,
                                  CLANG_ENTO_PROGRAMSTATE_MAP(SymbolRef,
                                                              RangeSet))
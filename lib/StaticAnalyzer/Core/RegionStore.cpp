@@ -25,10 +25,14 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/SubEngine.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/ImmutableList.h"
 #include "llvm/ADT/ImmutableMap.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 using namespace clang;
 using namespace ento;
@@ -139,10 +143,308 @@ LLVM_DUMP_METHOD void BindingKey::dump() const { llvm::errs() << *this; }
 // Actual Store type.
 //===----------------------------------------------------------------------===//
 
-typedef llvm::ImmutableMap<BindingKey, SVal>    ClusterBindings;
-typedef llvm::ImmutableMapRef<BindingKey, SVal> ClusterBindingsRef;
 typedef std::pair<BindingKey, SVal> BindingPair;
 
+namespace {
+/// A hash-consed, sorted array holding the bindings of a small cluster.
+///
+/// Nodes are reference counted by the ClusterBindings values that use them.
+/// A node that is no longer used is put on a free list, and its memory is
+/// reused for the next node with the same number of bindings.
+class FlatClusterNode : public llvm::FoldingSetNode {
+public:
+  class Factory;
+
+private:
+  Factory *F;
+  unsigned Size;
+  mutable unsigned RefCount;
+
+public:
+  /// The bindings are stored directly after the node.
+  FlatClusterNode(Factory *F, unsigned Size) : F(F), Size(Size), RefCount(0) {}
+
+  const BindingPair *begin() const {
+    return reinterpret_cast<const BindingPair *>(this + 1);
+  }
+  const BindingPair *end() const { return begin() + Size; }
+  unsigned size() const { return Size; }
+
+  void retain() const { ++RefCount; }
+  void release() const;
+
+  static void Profile(llvm::FoldingSetNodeID &ID, const BindingPair *B,
+                      const BindingPair *E) {
+    for (; B != E; ++B) {
+      B->first.Profile(ID);
+      B->second.Profile(ID);
+    }
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, begin(), end()); }
+};
+
+class FlatClusterNode::Factory {
+  llvm::BumpPtrAllocator &Alloc;
+  llvm::FoldingSet<FlatClusterNode> Nodes;
+
+  /// Memory of released nodes, indexed by their number of bindings.
+  std::vector<SmallVector<void *, 4> > FreeNodes;
+
+  friend class FlatClusterNode;
+  void destroy(FlatClusterNode *N);
+
+public:
+  explicit Factory(llvm::BumpPtrAllocator &Alloc) : Alloc(Alloc) {}
+
+  /// Return the unique node holding the bindings in [B, E).
+  const FlatClusterNode *getNode(const BindingPair *B, const BindingPair *E);
+};
+
+void FlatClusterNode::release() const {
+  assert(RefCount > 0 && "Releasing an unused node");
+  if (--RefCount == 0)
+    F->destroy(const_cast<FlatClusterNode *>(this));
+}
+
+/// The bindings within one cluster, ordered by key.
+///
+/// Most clusters hold only a handful of bindings, for which walking and
+/// rebuilding a balanced tree on every update is mostly pointer chasing.
+/// Clusters with at most a configurable number of bindings are therefore kept
+/// in a single sorted array that is searched with a binary search and copied
+/// on update; larger clusters use an ImmutableMap. The representation depends
+/// only on the number of bindings and both forms are uniqued, so equal
+/// clusters are still represented by identical values.
+class ClusterBindings {
+public:
+  typedef llvm::ImmutableMap<BindingKey, SVal> TreeMapTy;
+
+private:
+  /// The bindings of a small cluster, or null.
+  const FlatClusterNode *Flat;
+
+  /// The bindings of a large cluster; empty if the cluster is small.
+  TreeMapTy Tree;
+
+  ClusterBindings(const FlatClusterNode *Flat, TreeMapTy Tree)
+    : Flat(Flat), Tree(Tree) {
+    if (Flat)
+      Flat->retain();
+  }
+
+public:
+  ClusterBindings(const ClusterBindings &X) : Flat(X.Flat), Tree(X.Tree) {
+    if (Flat)
+      Flat->retain();
+  }
+
+  ClusterBindings &operator=(const ClusterBindings &X) {
+    if (X.Flat)
+      X.Flat->retain();
+    if (Flat)
+      Flat->release();
+    Flat = X.Flat;
+    Tree = X.Tree;
+    return *this;
+  }
+
+  ~ClusterBindings() {
+    if (Flat)
+      Flat->release();
+  }
+
+  class iterator {
+    /// The position in the flat array, or null when walking the tree.
+    const BindingPair *FlatI;
+    TreeMapTy::iterator TreeI;
+
+    iterator(const BindingPair *FlatI, TreeMapTy::iterator TreeI)
+      : FlatI(FlatI), TreeI(TreeI) {}
+    friend class ClusterBindings;
+
+  public:
+    const BindingKey &getKey() const {
+      return FlatI ? FlatI->first : TreeI.getKey();
+    }
+    const SVal &getData() const {
+      return FlatI ? FlatI->second : TreeI.getData();
+    }
+
+    iterator &operator++() {
+      if (FlatI)
+        ++FlatI;
+      else
+        ++TreeI;
+      return *this;
+    }
+
+    bool operator==(const iterator &X) const {
+      return FlatI == X.FlatI && TreeI == X.TreeI;
+    }
+    bool operator!=(const iterator &X) const { return !(*this == X); }
+  };
+
+  class Factory {
+    TreeMapTy::Factory TreeF;
+    FlatClusterNode::Factory FlatF;
+
+    /// Clusters with more bindings than this use the tree representation.
+    unsigned FlatLimit;
+
+    ClusterBindings getCluster(const BindingPair *B, const BindingPair *E);
+
+  public:
+    Factory(llvm::BumpPtrAllocator &Alloc)
+      : TreeF(Alloc), FlatF(Alloc), FlatLimit(0) {}
+
+    void setFlatLimit(unsigned Limit) { FlatLimit = Limit; }
+
+    ClusterBindings getEmptyMap() {
+      return ClusterBindings(nullptr, TreeF.getEmptyMap());
+    }
+
+    ClusterBindings add(const ClusterBindings &C, const BindingKey &K,
+                        const SVal &V);
+    ClusterBindings remove(const ClusterBindings &C, const BindingKey &K);
+  };
+
+  bool isEmpty() const { return !Flat && Tree.isEmpty(); }
+
+  const SVal *lookup(const BindingKey &K) const {
+    if (!Flat)
+      return Tree.lookup(K);
+    const BindingPair *I = findInFlat(K);
+    if (I == Flat->end() || !(I->first == K))
+      return nullptr;
+    return &I->second;
+  }
+
+  iterator begin() const {
+    if (Flat)
+      return iterator(Flat->begin(), Tree.end());
+    return iterator(nullptr, Tree.begin());
+  }
+  iterator end() const {
+    if (Flat)
+      return iterator(Flat->end(), Tree.end());
+    return iterator(nullptr, Tree.end());
+  }
+
+  bool operator==(const ClusterBindings &X) const {
+    return Flat == X.Flat && Tree == X.Tree;
+  }
+
+  void Profile(llvm::FoldingSetNodeID &ID) const {
+    ID.AddPointer(Flat);
+    Tree.Profile(ID);
+  }
+
+private:
+  /// Return the first binding in the flat array whose key is not less than
+  /// \p K.
+  const BindingPair *findInFlat(const BindingKey &K) const {
+    return std::lower_bound(Flat->begin(), Flat->end(), K,
+                            [](const BindingPair &P, const BindingKey &Key) {
+                              return P.first < Key;
+                            });
+  }
+};
+} // end anonymous namespace
+
+const FlatClusterNode *
+FlatClusterNode::Factory::getNode(const BindingPair *B, const BindingPair *E) {
+  assert(B != E && "Empty clusters are not stored");
+  llvm::FoldingSetNodeID ID;
+  FlatClusterNode::Profile(ID, B, E);
+  void *InsertPos;
+  if (FlatClusterNode *N = Nodes.FindNodeOrInsertPos(ID, InsertPos))
+    return N;
+
+  unsigned Size = E - B;
+  void *Mem;
+  if (Size < FreeNodes.size() && !FreeNodes[Size].empty()) {
+    Mem = FreeNodes[Size].pop_back_val();
+  } else {
+    Mem = Alloc.Allocate(sizeof(FlatClusterNode) + Size * sizeof(BindingPair),
+                         llvm::alignOf<FlatClusterNode>());
+  }
+  FlatClusterNode *N = new (Mem) FlatClusterNode(this, Size);
+  std::uninitialized_copy(B, E, const_cast<BindingPair *>(N->begin()));
+  Nodes.InsertNode(N, InsertPos);
+  return N;
+}
+
+void FlatClusterNode::Factory::destroy(FlatClusterNode *N) {
+  Nodes.RemoveNode(N);
+  unsigned Size = N->size();
+  N->~FlatClusterNode();
+  if (Size >= FreeNodes.size())
+    FreeNodes.resize(Size + 1);
+  FreeNodes[Size].push_back(N);
+}
+
+ClusterBindings ClusterBindings::Factory::getCluster(const BindingPair *B,
+                                                     const BindingPair *E) {
+  if (B == E)
+    return getEmptyMap();
+  if (unsigned(E - B) <= FlatLimit)
+    return ClusterBindings(FlatF.getNode(B, E), TreeF.getEmptyMap());
+
+  TreeMapTy T = TreeF.getEmptyMap();
+  for (; B != E; ++B)
+    T = TreeF.add(T, B->first, B->second);
+  return ClusterBindings(nullptr, T);
+}
+
+ClusterBindings ClusterBindings::Factory::add(const ClusterBindings &C,
+                                              const BindingKey &K,
+                                              const SVal &V) {
+  if (!C.Flat) {
+    // A tree only ever grows here, so it stays above the flat limit.
+    if (!C.Tree.isEmpty() || FlatLimit == 0)
+      return ClusterBindings(nullptr, TreeF.add(C.Tree, K, V));
+    BindingPair P(K, V);
+    return getCluster(&P, &P + 1);
+  }
+
+  const BindingPair *I = C.findInFlat(K);
+  bool Replace = I != C.Flat->end() && I->first == K;
+  if (Replace && I->second == V)
+    return C;
+
+  SmallVector<BindingPair, 16> Bindings(C.Flat->begin(), I);
+  Bindings.push_back(BindingPair(K, V));
+  Bindings.append(Replace ? I + 1 : I, C.Flat->end());
+  return getCluster(Bindings.begin(), Bindings.end());
+}
+
+ClusterBindings ClusterBindings::Factory::remove(const ClusterBindings &C,
+                                                 const BindingKey &K) {
+  if (!C.Flat) {
+    TreeMapTy T = TreeF.remove(C.Tree, K);
+    if (T == C.Tree)
+      return C;
+
+    // Switch back to the flat form once the cluster is small enough.
+    SmallVector<BindingPair, 16> Bindings;
+    for (TreeMapTy::iterator TI = T.begin(), TE = T.end(); TI != TE; ++TI) {
+      if (Bindings.size() == FlatLimit)
+        return ClusterBindings(nullptr, T);
+      Bindings.push_back(BindingPair(TI.getKey(), TI.getData()));
+    }
+    return getCluster(Bindings.begin(), Bindings.end());
+  }
+
+  const BindingPair *I = C.findInFlat(K);
+  if (I == C.Flat->end() || !(I->first == K))
+    return C;
+
+  SmallVector<BindingPair, 16> Bindings(C.Flat->begin(), I);
+  Bindings.append(I + 1, C.Flat->end());
+  return getCluster(Bindings.begin(), Bindings.end());
+}
+
 typedef llvm::ImmutableMap<const MemRegion *, ClusterBindings>
         RegionBindings;
 
@@ -350,6 +652,7 @@ public:
       AnalyzerOptions &Options = Eng->getAnalysisManager().options;
       SmallStructLimit =
         Options.getOptionAsInteger("region-store-small-struct-limit", 2);
+      CBFactory.setFlatLimit(Options.getRegionStoreFlatClusterLimit());
     }
   }
 
@@ -901,11 +1204,11 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   collectSubRegionBindings(Bindings, svalBuilder, *Cluster, Top, TopKey,
                            /*IncludeAllDefaultBindings=*/false);
 
-  ClusterBindingsRef Result(*Cluster, CBFactory);
+  ClusterBindings Result = *Cluster;
   for (SmallVectorImpl<BindingPair>::const_iterator I = Bindings.begin(),
                                                     E = Bindings.end();
        I != E; ++I)
-    Result = Result.remove(I->first);
+    Result = CBFactory.remove(Result, I->first);
 
   // If we're invalidating a region with a symbolic offset, we need to make sure
   // we don't treat the base region as uninitialized anymore.
@@ -913,13 +1216,14 @@ RegionStoreManager::removeSubRegionBindings(RegionBindingsConstRef B,
   // collectSubRegionBindings.
   if (TopKey.hasSymbolicOffset()) {
     const SubRegion *Concrete = TopKey.getConcreteOffsetRegion();
-    Result = Result.add(BindingKey::Make(Concrete, BindingKey::Default),
-                        UnknownVal());
+    Result = CBFactory.add(Result,
+                           BindingKey::Make(Concrete, BindingKey::Default),
+                           UnknownVal());
   }
 
   if (Result.isEmpty())
     return B.remove(ClusterHead);
-  return B.add(ClusterHead, Result.asImmutableMap());
+  return B.add(ClusterHead, Result);
 }
 
 namespace {
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "CrossTUInjector.h"
 #include "ModelInjector.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
@@ -25,7 +26,11 @@
 #include "clang/Analysis/CodeInjector.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/StaticAnalyzer/Checkers/LocalCheckers.h"
 #include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
@@ -41,10 +46,12 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <memory>
 #include <queue>
 
@@ -64,6 +71,9 @@ STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(NumFunctionsSkippedBySummary,
+                      "The # of functions not analyzed again because their "
+                      "persistent summary was up to date.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -185,13 +195,24 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// The number of path-sensitive issues reported so far. Used to fill in
+  /// the persistent summaries of the analyzed functions.
+  unsigned NumPathReports;
+
+  /// Basic block coverage of the functions skipped because of an unchanged
+  /// persistent summary, added to the coverage statistics.
+  unsigned NumSummarizedBlocks;
+  unsigned NumSummarizedVisitedBlocks;
+
   AnalysisConsumer(const Preprocessor& pp,
                    const std::string& outdir,
                    AnalyzerOptionsRef opts,
                    ArrayRef<std::string> plugins,
                    CodeInjector *injector)
     : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr), PP(pp),
-      OutDir(outdir), Opts(opts), Plugins(plugins), Injector(injector) {
+      OutDir(outdir), Opts(opts), Plugins(plugins), Injector(injector),
+      NumPathReports(0), NumSummarizedBlocks(0),
+      NumSummarizedVisitedBlocks(0) {
     DigestAnalyzerOptions();
     if (Opts->PrintStats) {
       llvm::EnableStatistics();
@@ -291,6 +312,8 @@ public:
     Ctx = &Context;
     checkerMgr = createCheckerManager(*Opts, PP.getLangOpts(), Plugins,
                                       PP.getDiagnostics());
+    if (Opts->PrintStats || Opts->Config.count("checker-profile-json"))
+      checkerMgr->enableProfiling();
 
     Mgr = llvm::make_unique<AnalysisManager>(
         *Ctx, PP.getDiagnostics(), PP.getLangOpts(), PathConsumers,
@@ -304,6 +327,10 @@ public:
 
   void HandleTranslationUnit(ASTContext &C) override;
 
+  /// \brief Print the time spent in each checker with -analyzer-stats, and
+  /// write it to the file named by the checker-profile-json option.
+  void reportCheckerProfile();
+
   /// \brief Determine which inlining mode should be used when this function is
   /// analyzed. This allows to redefine the default inlining policies when
   /// analyzing a given function.
@@ -314,6 +341,12 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// \brief Load the persistent summaries of this translation unit from the
+  /// directory named by the summary-cache-dir option. Returns null if the
+  /// option is not set; \p Path is set to the file to save them to.
+  std::unique_ptr<PersistentFunctionSummaries>
+    loadPersistentSummaries(CallGraph &CG, std::string &Path);
+
   /// \brief Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -454,6 +487,187 @@ AnalysisConsumer::getInliningModeForFunction(const Decl *D,
   return ExprEngine::Inline_Regular;
 }
 
+//===----------------------------------------------------------------------===//
+// Persistent function summaries.
+//===----------------------------------------------------------------------===//
+
+/// \brief Return the declaration of \p D that carries its body, if any.
+static const Decl *getDefinition(const Decl *D) {
+  if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+    const FunctionDecl *Def = nullptr;
+    if (FD->hasBody(Def))
+      return Def;
+  }
+  return D;
+}
+
+/// \brief Return the source text of the definition of \p D.
+static StringRef getDefinitionText(const Decl *D, const SourceManager &SM,
+                                   const LangOptions &LO) {
+  D = getDefinition(D);
+  SourceLocation B = SM.getExpansionLoc(D->getLocStart());
+  SourceLocation E = SM.getExpansionRange(D->getLocEnd()).second;
+  if (B.isInvalid() || E.isInvalid())
+    return StringRef();
+  return Lexer::getSourceText(CharSourceRange::getTokenRange(B, E), SM, LO);
+}
+
+static std::string getHashString(llvm::MD5 &Hash) {
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+/// \brief Hash the code of the function in \p N and of all the functions it
+/// may call according to the call graph, followed by the code of \p Inlined,
+/// the functions that were inlined through calls the call graph cannot see
+/// (such as virtual calls).
+static std::string getCodeHash(CallGraphNode *N,
+                               ArrayRef<const Decl *> Inlined,
+                               const SourceManager &SM,
+                               const LangOptions &LO) {
+  llvm::MD5 Hash;
+  SmallPtrSet<const Decl *, 16> Seen;
+  auto AddDecl = [&](const Decl *D) {
+    if (!D || !Seen.insert(D).second)
+      return false;
+    Hash.update(getDefinitionText(D, SM, LO));
+    Hash.update(StringRef("", 1));
+    return true;
+  };
+
+  SmallVector<CallGraphNode *, 16> Worklist(1, N);
+  while (!Worklist.empty()) {
+    CallGraphNode *Cur = Worklist.pop_back_val();
+    if (!AddDecl(Cur->getDecl()))
+      continue;
+    for (CallGraphNode *Callee : *Cur)
+      Worklist.push_back(Callee);
+  }
+  for (const Decl *D : Inlined)
+    AddDecl(D);
+  return getHashString(Hash);
+}
+
+/// \brief Compute a fingerprint of everything besides the code of the
+/// functions in \p CG that may influence the results of the analysis: the
+/// compiler version, the analyzer options, the predefined macros, the contents
+/// of the included files and the text of the main file outside of function
+/// bodies.
+static std::string getTUFingerprint(CallGraph &CG, AnalyzerOptions &Opts,
+                                    const Preprocessor &PP) {
+  const SourceManager &SM = PP.getSourceManager();
+  const LangOptions &LO = PP.getLangOpts();
+  llvm::MD5 Hash;
+  Hash.update(getClangFullVersion());
+  // Command line macros are not part of any file.
+  Hash.update(PP.getPredefines());
+
+  std::string OptStr;
+  llvm::raw_string_ostream OptOS(OptStr);
+  OptOS << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+        << Opts.AnalysisPurgeOpt << ' ' << Opts.maxBlockVisitOnPath << ' '
+        << Opts.AnalyzeAll << Opts.AnalyzeNestedBlocks
+        << Opts.eagerlyAssumeBinOpBifurcation << Opts.UnoptimizedCFG
+        << Opts.NoRetryExhausted << ' ' << Opts.InlineMaxStackDepth << ' '
+        << Opts.InliningMode << '\n';
+  for (const auto &Checker : Opts.CheckersControlList)
+    OptOS << (Checker.second ? '+' : '-') << Checker.first << '\n';
+  std::vector<std::pair<StringRef, StringRef> > Config;
+  for (const auto &Entry : Opts.Config)
+    Config.push_back(std::make_pair(Entry.getKey(), StringRef(Entry.second)));
+  std::sort(Config.begin(), Config.end());
+  for (const auto &Entry : Config)
+    OptOS << Entry.first << '=' << Entry.second << '\n';
+  Hash.update(OptOS.str());
+
+  // Any change to an included file invalidates all the summaries.
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  std::vector<std::pair<StringRef, const llvm::MemoryBuffer *> > Files;
+  for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
+                                        E = SM.fileinfo_end();
+       I != E; ++I) {
+    if (I->first == MainFile)
+      continue;
+    if (const llvm::MemoryBuffer *Buf = I->second->getRawBuffer())
+      Files.push_back(std::make_pair(I->first->getName(), Buf));
+  }
+  std::sort(Files.begin(), Files.end());
+  for (const auto &File : Files) {
+    Hash.update(File.first);
+    Hash.update(File.second->getBuffer());
+  }
+
+  // The bodies in the main file are covered by the hashes of the individual
+  // summaries; everything around them is covered here.
+  FileID MainFID = SM.getMainFileID();
+  std::vector<std::pair<unsigned, unsigned> > Bodies;
+  for (CallGraph::iterator I = CG.begin(), E = CG.end(); I != E; ++I) {
+    const Decl *D = I->first ? getDefinition(I->first) : nullptr;
+    const Stmt *Body = D ? D->getBody() : nullptr;
+    if (!Body)
+      continue;
+    SourceLocation BodyBegin = SM.getExpansionLoc(Body->getLocStart());
+    SourceLocation BodyEnd = SM.getExpansionRange(Body->getLocEnd()).second;
+    std::pair<FileID, unsigned> BInfo = SM.getDecomposedLoc(BodyBegin);
+    std::pair<FileID, unsigned> EInfo = SM.getDecomposedLoc(BodyEnd);
+    if (BInfo.first != MainFID || EInfo.first != MainFID)
+      continue;
+    Bodies.push_back(std::make_pair(
+        BInfo.second,
+        EInfo.second + Lexer::MeasureTokenLength(BodyEnd, SM, LO)));
+  }
+  std::sort(Bodies.begin(), Bodies.end());
+
+  StringRef MainText = SM.getBufferData(MainFID);
+  unsigned Pos = 0;
+  for (const auto &Body : Bodies) {
+    if (Body.first > Pos)
+      Hash.update(MainText.slice(Pos, Body.first));
+    Hash.update(StringRef("", 1));
+    Pos = std::max(Pos, Body.second);
+  }
+  Hash.update(MainText.substr(Pos));
+  return getHashString(Hash);
+}
+
+std::unique_ptr<PersistentFunctionSummaries>
+AnalysisConsumer::loadPersistentSummaries(CallGraph &CG, std::string &Path) {
+  AnalyzerOptions::ConfigTable::const_iterator Dir =
+      Opts->Config.find("summary-cache-dir");
+  if (Dir == Opts->Config.end() || Dir->second.empty())
+    return nullptr;
+
+  // The bodies imported from other translation units are not covered by the
+  // hashes, so summaries cannot be trusted for cross-TU analysis.
+  if (Opts->Config.count("ctu-dir"))
+    return nullptr;
+
+  SourceManager &SM = Ctx->getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  if (!MainFile)
+    return nullptr;
+
+  // Name the cache after the main file, disambiguated by its full path.
+  SmallString<128> MainPath(MainFile->getName());
+  llvm::sys::fs::make_absolute(MainPath);
+  llvm::MD5 PathHash;
+  PathHash.update(MainPath);
+  SmallString<128> CachePath(Dir->second);
+  llvm::sys::path::append(CachePath,
+                          llvm::sys::path::filename(MainPath) + "-" +
+                              getHashString(PathHash) + ".summaries");
+  Path = CachePath.str();
+
+  std::unique_ptr<PersistentFunctionSummaries> Summaries(
+      new PersistentFunctionSummaries(
+          getTUFingerprint(CG, *Opts, PP)));
+  Summaries->load(Path);
+  return Summaries;
+}
+
 void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   // Build the Call Graph by adding all the top level declarations to the graph.
   // Note: CallGraph can trigger deserialization of more items from a pch
@@ -464,6 +678,21 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     CG.addToCallGraph(LocalTUDecls[i]);
   }
 
+  // Summaries from a previous run let us skip functions that did not change.
+  std::string SummariesPath;
+  std::unique_ptr<PersistentFunctionSummaries> Summaries =
+      loadPersistentSummaries(CG, SummariesPath);
+  llvm::StringMap<const Decl *> USRToDecl;
+  if (Summaries) {
+    for (CallGraph::iterator I = CG.begin(), E = CG.end(); I != E; ++I) {
+      SmallString<128> USR;
+      if (I->first && !index::generateUSRForDecl(I->first, USR))
+        USRToDecl[USR] = I->first;
+    }
+  }
+  const SourceManager &SM = Ctx->getSourceManager();
+  const LangOptions &LO = PP.getLangOpts();
+
   // Walk over all of the call graph nodes in topological order, so that we
   // analyze parents before the children. Skip the functions inlined into
   // the previously processed functions. Use external Visited set to identify
@@ -489,12 +718,68 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
+    SmallString<128> USR;
+    bool UseSummary = Summaries && !index::generateUSRForDecl(D, USR);
+
+    // An unchanged function that produced no issues last time will not
+    // produce any now. Skip it, but still treat the functions it inlined
+    // last time as visited, just like the analysis would.
+    if (UseSummary) {
+      if (const PersistentFunctionSummaries::Summary *S =
+              Summaries->lookup(USR)) {
+        SmallVector<const Decl *, 16> Inlined;
+        bool AllCalleesFound = true;
+        for (const std::string &CalleeUSR : S->InlinedCallees) {
+          const Decl *Callee = USRToDecl.lookup(CalleeUSR);
+          if (!Callee) {
+            AllCalleesFound = false;
+            break;
+          }
+          Inlined.push_back(Callee);
+        }
+        if (AllCalleesFound && S->NumReports == 0 &&
+            S->BodyHash == getCodeHash(N, Inlined, SM, LO)) {
+          ++NumFunctionsSkippedBySummary;
+          NumSummarizedBlocks += S->NumTotalBlocks;
+          NumSummarizedVisitedBlocks += S->NumVisitedBlocks;
+          for (const Decl *Callee : Inlined)
+            Visited.insert(Callee);
+          VisitedAsTopLevel.insert(D);
+          continue;
+        }
+      }
+    }
+
     // Analyze the function.
     SetOfConstDecls VisitedCallees;
+    unsigned NumReportsBefore = NumPathReports;
 
     HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
                (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
 
+    if (UseSummary) {
+      PersistentFunctionSummaries::Summary S;
+      S.NumReports = NumPathReports - NumReportsBefore;
+      const Decl *Def = getDefinition(D);
+      S.NumVisitedBlocks = FunctionSummaries.getNumVisitedBasicBlocks(Def);
+      S.NumTotalBlocks = FunctionSummaries.getNumBasicBlocks(Def);
+      SmallVector<const Decl *, 16> Inlined;
+      for (const Decl *Callee : VisitedCallees) {
+        SmallString<128> CalleeUSR;
+        if (!index::generateUSRForDecl(Callee, CalleeUSR))
+          S.InlinedCallees.push_back(CalleeUSR.str());
+      }
+      std::sort(S.InlinedCallees.begin(), S.InlinedCallees.end());
+      S.InlinedCallees.erase(
+          std::unique(S.InlinedCallees.begin(), S.InlinedCallees.end()),
+          S.InlinedCallees.end());
+      for (const std::string &CalleeUSR : S.InlinedCallees)
+        if (const Decl *Callee = USRToDecl.lookup(CalleeUSR))
+          Inlined.push_back(Callee);
+      S.BodyHash = getCodeHash(N, Inlined, SM, LO);
+      Summaries->update(USR, std::move(S));
+    }
+
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
       // Decls from CallGraph are already canonical. But Decls coming from
@@ -503,6 +788,16 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
                                                  : Callee->getCanonicalDecl());
     VisitedAsTopLevel.insert(D);
   }
+
+  // Drop the summaries of functions that are gone, so that the cache does
+  // not grow as the code changes.
+  if (Summaries) {
+    Summaries->prune(
+        [&](StringRef USR) { return USRToDecl.count(USR) != 0; });
+    if (!Summaries->save(SummariesPath))
+      PP.getDiagnostics().Report(diag::warn_analyzer_summary_cache_write_failed)
+          << SummariesPath;
+  }
 }
 
 void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
@@ -560,15 +855,41 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
 
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
+  if (checkerMgr->isProfilingEnabled())
+    reportCheckerProfile();
+
   // Count how many basic blocks we have not covered.
-  NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
+  // Functions skipped because of their summaries count with the coverage
+  // they had when they were last analyzed.
+  NumBlocksInAnalyzedFunctions =
+      FunctionSummaries.getTotalNumBasicBlocks() + NumSummarizedBlocks;
   if (NumBlocksInAnalyzedFunctions > 0)
     PercentReachableBlocks =
-      (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 100) /
+      ((FunctionSummaries.getTotalNumVisitedBasicBlocks() +
+        NumSummarizedVisitedBlocks) * 100) /
         NumBlocksInAnalyzedFunctions;
 
 }
 
+void AnalysisConsumer::reportCheckerProfile() {
+  if (Opts->PrintStats)
+    checkerMgr->printProfile(llvm::errs());
+
+  AnalyzerOptions::ConfigTable::const_iterator Path =
+      Opts->Config.find("checker-profile-json");
+  if (Path == Opts->Config.end() || Path->second.empty())
+    return;
+
+  std::error_code EC;
+  llvm::raw_fd_ostream Out(Path->second, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    PP.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Path->second << EC.message();
+    return;
+  }
+  checkerMgr->printProfileAsJSON(Out);
+}
+
 static std::string getFunctionName(const Decl *D) {
   if (const ObjCMethodDecl *ID = dyn_cast<ObjCMethodDecl>(D)) {
     return ID->getSelector().getAsString();
@@ -673,7 +994,9 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  BugReporter &BR = Eng.getBugReporter();
+  NumPathReports += std::distance(BR.EQClasses_begin(), BR.EQClasses_end());
+  BR.FlushReports();
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
@@ -707,11 +1030,18 @@ ento::CreateAnalysisConsumer(CompilerInstance &CI) {
 
   AnalyzerOptionsRef analyzerOpts = CI.getAnalyzerOpts();
   bool hasModelPath = analyzerOpts->Config.count("model-path") > 0;
+  bool hasCTUDir = analyzerOpts->Config.count("ctu-dir") > 0;
+
+  std::unique_ptr<CodeInjector> Injector;
+  if (hasModelPath)
+    Injector.reset(new ModelInjector(CI));
+  // Definitions from other translation units take precedence over models.
+  if (hasCTUDir)
+    Injector.reset(new CrossTUInjector(CI, std::move(Injector)));
 
   return llvm::make_unique<AnalysisConsumer>(
       CI.getPreprocessor(), CI.getFrontendOpts().OutputFile, analyzerOpts,
-      CI.getFrontendOpts().Plugins,
-      hasModelPath ? new ModelInjector(CI) : nullptr);
+      CI.getFrontendOpts().Plugins, Injector.release());
 }
 
 //===----------------------------------------------------------------------===//
@@ -0,0 +1,192 @@
+//===-- CrossTUInjector.cpp -------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CrossTUInjector.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTImporter.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Index/USRGeneration.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+using namespace clang;
+using namespace ento;
+
+#define DEBUG_TYPE "CrossTUInjector"
+
+STATISTIC(NumFunctionsImported,
+          "The # of function definitions imported from other TUs");
+STATISTIC(NumImportsFailed,
+          "The # of indexed function definitions that could not be imported");
+STATISTIC(NumUnitsLoaded, "The # of serialized ASTs loaded");
+STATISTIC(NumBudgetExhausted,
+          "The # of imports skipped because the import budget ran out");
+
+CrossTUInjector::CrossTUInjector(CompilerInstance &CI,
+                                 std::unique_ptr<CodeInjector> Fallback)
+    : CI(CI), Fallback(std::move(Fallback)), NumImported(0),
+      IndexLoaded(false) {
+  AnalyzerOptions &Opts = *CI.getAnalyzerOpts();
+  CTUDir = Opts.getOptionAsString("ctu-dir", "");
+  IndexName = Opts.getOptionAsString("ctu-index-name", "externalFnMap.txt");
+  int Budget = Opts.getOptionAsInteger("ctu-import-threshold", 100);
+  ImportBudget = Budget < 0 ? 0 : Budget;
+}
+
+CrossTUInjector::~CrossTUInjector() {}
+
+Stmt *CrossTUInjector::getBody(const FunctionDecl *D) {
+  if (const FunctionDecl *Def = importDefinition(D))
+    return Def->getBody();
+  return Fallback ? Fallback->getBody(D) : nullptr;
+}
+
+Stmt *CrossTUInjector::getBody(const ObjCMethodDecl *D) {
+  return Fallback ? Fallback->getBody(D) : nullptr;
+}
+
+const FunctionDecl *CrossTUInjector::importDefinition(const FunctionDecl *D) {
+  // Only functions that may be defined in another translation unit are
+  // interesting. Methods are left alone, as the importer cannot merge a body
+  // into an existing class yet.
+  if (!D->hasExternalFormalLinkage() || isa<CXXMethodDecl>(D))
+    return nullptr;
+
+  SmallString<128> USR;
+  if (index::generateUSRForDecl(D, USR))
+    return nullptr;
+
+  loadIndex();
+  llvm::StringMap<std::string>::const_iterator It =
+      FunctionFileMap.find(USR.str());
+  if (It == FunctionFileMap.end())
+    return nullptr;
+
+  if (ImportBudget && NumImported >= ImportBudget) {
+    ++NumBudgetExhausted;
+    return nullptr;
+  }
+
+  ASTUnit *Unit = loadUnit(It->second);
+  if (!Unit)
+    return nullptr;
+
+  const FunctionDecl *FromDef = findDefinition(
+      Unit->getASTContext().getTranslationUnitDecl(), USR.str());
+  if (!FromDef) {
+    ++NumImportsFailed;
+    return nullptr;
+  }
+
+  ASTImporter &Importer = getImporter(Unit);
+  const FunctionDecl *ToDef = cast_or_null<FunctionDecl>(
+      Importer.Import(const_cast<FunctionDecl *>(FromDef)));
+  if (!ToDef || !ToDef->hasBody()) {
+    ++NumImportsFailed;
+    return nullptr;
+  }
+
+  ++NumImported;
+  ++NumFunctionsImported;
+  return ToDef;
+}
+
+void CrossTUInjector::loadIndex() {
+  if (IndexLoaded)
+    return;
+  IndexLoaded = true;
+
+  SmallString<128> IndexPath(CTUDir);
+  llvm::sys::path::append(IndexPath, IndexName);
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(IndexPath);
+  if (!Buffer)
+    return;
+
+  // Each line holds the USR of a function definition and the path of the
+  // serialized AST that contains it, relative to CTUDir, separated by a space.
+  SmallVector<StringRef, 32> Lines;
+  (*Buffer)->getBuffer().split(Lines, "\n", /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    std::pair<StringRef, StringRef> Entry = Line.trim().split(' ');
+    if (Entry.first.empty() || Entry.second.empty())
+      continue;
+    // The first definition listed wins, as it would at link time.
+    FunctionFileMap.insert(
+        std::make_pair(Entry.first, Entry.second.trim().str()));
+  }
+}
+
+ASTUnit *CrossTUInjector::loadUnit(StringRef ASTFileName) {
+  auto Known = FileASTUnitMap.insert(
+      std::make_pair(ASTFileName, std::unique_ptr<ASTUnit>()));
+  std::unique_ptr<ASTUnit> &Unit = Known.first->second;
+  if (!Known.second)
+    return Unit.get();
+
+  SmallString<128> ASTPath(ASTFileName);
+  if (!llvm::sys::path::is_absolute(ASTPath)) {
+    ASTPath = CTUDir;
+    llvm::sys::path::append(ASTPath, ASTFileName);
+  }
+
+  // Problems in the other translation units are not the user's concern here;
+  // a unit that cannot be loaded simply provides no definitions.
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+      CompilerInstance::createDiagnostics(new DiagnosticOptions(),
+                                          new IgnoringDiagConsumer());
+  Unit = ASTUnit::LoadFromASTFile(ASTPath.str(), CI.getPCHContainerReader(),
+                                  Diags, FileSystemOptions());
+  if (Unit)
+    ++NumUnitsLoaded;
+  return Unit.get();
+}
+
+ASTImporter &CrossTUInjector::getImporter(ASTUnit *Unit) {
+  std::unique_ptr<ASTImporter> &Importer = Importers[Unit];
+  if (!Importer) {
+    Importer.reset(new ASTImporter(CI.getASTContext(), CI.getFileManager(),
+                                   Unit->getASTContext(),
+                                   Unit->getFileManager(),
+                                   /*MinimalImport=*/false));
+    // The analyzer looks for the body through the declaration of the callee
+    // in this translation unit.
+    Importer->setImportDefinitionsAsRedecls(true);
+  }
+  return *Importer;
+}
+
+const FunctionDecl *CrossTUInjector::findDefinition(const DeclContext *DC,
+                                                    StringRef USR) {
+  for (const Decl *D : DC->decls()) {
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+      if (const FunctionDecl *Def = findDefinition(cast<DeclContext>(D), USR))
+        return Def;
+      continue;
+    }
+
+    const FunctionDecl *FD = dyn_cast<FunctionDecl>(D);
+    if (!FD || !FD->isThisDeclarationADefinition())
+      continue;
+
+    SmallString<128> CurrentUSR;
+    if (!index::generateUSRForDecl(FD, CurrentUSR) && CurrentUSR == USR)
+      return FD;
+  }
+  return nullptr;
+}
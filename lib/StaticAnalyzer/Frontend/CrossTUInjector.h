@@ -0,0 +1,101 @@
+//===-- CrossTUInjector.h ---------------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::CrossTUInjector class which
+/// implements the clang::CodeInjector interface. This class is responsible for
+/// injecting function definitions that live in other translation units.
+///
+/// The definitions are looked up in an index that maps the USR of every
+/// externally visible function definition to the serialized AST of the
+/// translation unit that defines it. The index and the AST files are produced
+/// by a separate pre-pass and placed in the directory named by the ctu-dir
+/// analyzer option. Definitions are imported on demand into the ASTContext of
+/// the analyzed translation unit with the ASTImporter, so that the analyzer
+/// can inline calls across translation unit boundaries.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_CROSSTUINJECTOR_H
+#define LLVM_CLANG_SA_FRONTEND_CROSSTUINJECTOR_H
+
+#include "clang/Analysis/CodeInjector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include <memory>
+#include <string>
+
+namespace clang {
+
+class ASTImporter;
+class ASTUnit;
+class CompilerInstance;
+class DeclContext;
+class FunctionDecl;
+
+namespace ento {
+class CrossTUInjector : public CodeInjector {
+public:
+  /// \brief Create an injector that imports definitions from the translation
+  /// units indexed in the ctu-dir directory, and consults \p Fallback for
+  /// everything it cannot find there.
+  CrossTUInjector(CompilerInstance &CI, std::unique_ptr<CodeInjector> Fallback);
+  ~CrossTUInjector() override;
+
+  Stmt *getBody(const FunctionDecl *D) override;
+  Stmt *getBody(const ObjCMethodDecl *D) override;
+
+private:
+  /// \brief Import the definition of \p D from the translation unit that
+  /// defines it, according to the index. Returns the imported definition, or
+  /// null if there is none or the import budget is exhausted.
+  const FunctionDecl *importDefinition(const FunctionDecl *D);
+
+  /// \brief Read the USR to AST file index the first time it is needed.
+  void loadIndex();
+
+  /// \brief Return the (cached) AST of the given file in the ctu-dir
+  /// directory, or null if it could not be loaded.
+  ASTUnit *loadUnit(StringRef ASTFileName);
+
+  /// \brief Return the importer from \p Unit into the analyzed translation
+  /// unit. Importers are kept so that declarations are imported only once.
+  ASTImporter &getImporter(ASTUnit *Unit);
+
+  /// \brief Find the definition of the function with the given USR in \p DC
+  /// and the namespaces and linkage specifications nested in it.
+  static const FunctionDecl *findDefinition(const DeclContext *DC,
+                                            StringRef USR);
+
+  CompilerInstance &CI;
+  std::unique_ptr<CodeInjector> Fallback;
+
+  /// \brief The directory holding the index and the serialized ASTs.
+  std::string CTUDir;
+
+  /// \brief The name of the index file within CTUDir.
+  std::string IndexName;
+
+  /// \brief The maximum number of function definitions imported per
+  /// translation unit. Zero means no limit.
+  unsigned ImportBudget;
+  unsigned NumImported;
+
+  bool IndexLoaded;
+  llvm::StringMap<std::string> FunctionFileMap;
+
+  /// \brief The units loaded so far, by AST file name. A null unit records
+  /// that the file could not be loaded, so that it is not tried again.
+  llvm::StringMap<std::unique_ptr<ASTUnit>> FileASTUnitMap;
+  llvm::DenseMap<ASTUnit *, std::unique_ptr<ASTImporter>> Importers;
+};
+}
+}
+
+#endif
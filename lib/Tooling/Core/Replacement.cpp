@@ -254,7 +254,51 @@ bool applyAllReplacements(const std::vector<Replacement> &Replaces,
   return Result;
 }
 
+/// \brief Applies \p Replaces to \p Code in a single pass over the input.
+///
+/// This is only done when the replacements are in range and start at strictly
+/// increasing, non-overlapping offsets, which covers the vast majority of mass
+/// rewrites. Replacements sharing an offset or overlapping each other are
+/// resolved by the RewriteBuffer delta mapping in ways that a simple splice
+/// does not reproduce, so for those this returns false and leaves \p Result
+/// untouched.
+static bool applyNonOverlappingReplacements(StringRef Code,
+                                            const Replacements &Replaces,
+                                            std::string &Result) {
+  size_t ResultSize = Code.size();
+  unsigned PrevOffset = 0;
+  unsigned PrevEnd = 0;
+  for (Replacements::const_iterator I = Replaces.begin(), E = Replaces.end();
+       I != E; ++I) {
+    unsigned Offset = I->getOffset();
+    unsigned Length = I->getLength();
+    if (Offset > Code.size() || Length > Code.size() - Offset)
+      return false;
+    if (I != Replaces.begin() && (Offset <= PrevOffset || Offset < PrevEnd))
+      return false;
+    PrevOffset = Offset;
+    PrevEnd = Offset + Length;
+    ResultSize = ResultSize - Length + I->getReplacementText().size();
+  }
+
+  Result.clear();
+  Result.reserve(ResultSize);
+  unsigned Pos = 0;
+  for (Replacements::const_iterator I = Replaces.begin(), E = Replaces.end();
+       I != E; ++I) {
+    Result.append(Code.data() + Pos, I->getOffset() - Pos);
+    Result.append(I->getReplacementText());
+    Pos = I->getOffset() + I->getLength();
+  }
+  Result.append(Code.data() + Pos, Code.size() - Pos);
+  return true;
+}
+
 std::string applyAllReplacements(StringRef Code, const Replacements &Replaces) {
+  std::string Result;
+  if (applyNonOverlappingReplacements(Code, Replaces, Result))
+    return Result;
+
   IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
       new vfs::InMemoryFileSystem);
   FileManager Files(FileSystemOptions(), InMemoryFileSystem);
@@ -274,7 +318,6 @@ std::string applyAllReplacements(StringRef Code, const Replacements &Replaces) {
     if (!Replace.apply(Rewrite))
       return "";
   }
-  std::string Result;
   llvm::raw_string_ostream OS(Result);
   Rewrite.getEditBuffer(ID).write(OS);
   OS.flush();
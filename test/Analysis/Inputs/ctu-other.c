@@ -0,0 +1,11 @@
+int f(int x) {
+  return x + 1;
+}
+
+int g(int x) {
+  return f(x) * 2;
+}
+
+int unindexed(int x) {
+  return x;
+}
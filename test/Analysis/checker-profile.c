@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core.DivideZero,core.NullDereference -analyzer-config checker-profile-json=%t.json %s
+// RUN: FileCheck --input-file=%t.json %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core.DivideZero -analyzer-stats %s 2>&1 | FileCheck --check-prefix=TABLE %s
+
+int divide(int x, int y) {
+  return x / y;
+}
+
+int load(int *p) {
+  return *p;
+}
+
+// CHECK: "checkers": [
+// CHECK-DAG: {"name": "core.DivideZero",
+// CHECK-DAG: {"kind": "PreStmt",
+// CHECK-DAG: {"name": "core.NullDereference",
+// CHECK-DAG: {"kind": "Location",
+// CHECK: "total": {
+
+// TABLE: Analyzer checker profile
+// TABLE: --Calls--  --Nodes--  --- Name ---
+// TABLE-NEXT: core.DivideZero
+// TABLE-NEXT: PreStmt
+// TABLE-NEXT: Total
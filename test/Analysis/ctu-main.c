@@ -0,0 +1,26 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: %clang_cc1 -emit-pch -o %t/ctu-other.c.ast %S/Inputs/ctu-other.c
+// RUN: cp %S/Inputs/externalFnMap.txt %t/
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config ctu-dir=%t -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config ctu-dir=%t,ctu-import-threshold=1 -DBUDGET -verify %s
+
+void clang_analyzer_eval(int);
+
+int f(int);
+int g(int);
+int unindexed(int);
+
+void testCrossTU() {
+  clang_analyzer_eval(f(0) == 1); // expected-warning{{TRUE}}
+#ifndef BUDGET
+  clang_analyzer_eval(g(1) == 4); // expected-warning{{TRUE}}
+#else
+  // The budget was spent on importing f.
+  clang_analyzer_eval(g(1) == 4); // expected-warning{{UNKNOWN}}
+#endif
+}
+
+void testNotIndexed() {
+  clang_analyzer_eval(unindexed(0) == 0); // expected-warning{{UNKNOWN}}
+}
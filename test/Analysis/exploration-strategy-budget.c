@@ -0,0 +1,41 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config max-nodes=2000 -analyzer-config exploration-strategy=unexplored-first -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config max-nodes=2000 -analyzer-config exploration-strategy=unexplored-first-queue -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config max-nodes=2000 %s 2>&1 | FileCheck -check-prefix=CHECK-DFS %s
+
+// Each function has a bug on one side of a branch, and many distinct paths
+// on the other. With a node budget, the default depth-first exploration
+// spends the whole budget on the side that it takes first, so it only finds
+// the bug of one of the functions, whichever side it prefers. The
+// unexplored-first strategies reach the other side of the branch as soon as
+// they stop finding new blocks, and find both.
+
+// CHECK-DFS: warning: Dereference of null pointer
+// CHECK-DFS-NOT: warning: Dereference of null pointer
+
+extern int coin();
+
+// Every combination of steps leaves a different value in 'x', so that no
+// two paths are merged.
+#define STEP(n) if (coin()) x |= 1 << (n);
+#define STEP4(n) STEP(n) STEP(n + 1) STEP(n + 2) STEP(n + 3)
+#define MANY_PATHS { STEP4(0) STEP4(4) STEP4(8) }
+
+int bug_if_true() {
+  int *p = 0;
+  int x = 0;
+  if (coin())
+    *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+  else
+    MANY_PATHS
+  return x;
+}
+
+int bug_if_false() {
+  int *p = 0;
+  int x = 0;
+  if (coin())
+    MANY_PATHS
+  else
+    *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+  return x;
+}
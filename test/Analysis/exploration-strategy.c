@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=dfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=bfs-block-dfs-contents -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=unexplored-first-queue -verify %s
+// RUN: not %clang_cc1 -analyze -analyzer-checker=core -analyzer-config exploration-strategy=depth-first %s 2>&1 | FileCheck -check-prefix=CHECK-INVALID %s
+
+// CHECK-INVALID: invalid input for analyzer-config option 'exploration-strategy', that expects a 'dfs', 'bfs', 'bfs-block-dfs-contents', 'unexplored-first' or 'unexplored-first-queue' value
+
+extern int coin();
+
+void after_loop(int n) {
+  int *p = 0;
+  for (int i = 0; i < n; ++i)
+    coin();
+  *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+}
+
+int inside_loop() {
+  int *x = 0;
+  while (coin()) {
+    if (coin())
+      return *x; // expected-warning{{Dereference of null pointer (loaded from variable 'x')}}
+  }
+  return 0;
+}
+
+void nested_loops(int n) {
+  int d = 0;
+  for (int i = 0; i < n; ++i)
+    for (int j = 0; j < n; ++j)
+      coin();
+  if (coin())
+    (void)(n / d); // expected-warning{{Division by zero}}
+}
@@ -0,0 +1,24 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: %clang_cc1 -emit-pch -o %t/ctu-other.c.ast %S/Inputs/ctu-other.c
+// RUN: %clang_cc1 -emit-pch -o %t/func-mapping-test.c.ast %s
+// RUN: cd %t && clang-func-mapping ctu-other.c.ast func-mapping-test.c.ast | FileCheck %s
+
+// Each externally visible function definition is mapped to the AST file
+// that defines it, in the order of the files on the command line.
+
+// CHECK: c:@F@f ctu-other.c.ast
+// CHECK-NEXT: c:@F@g ctu-other.c.ast
+// CHECK-NEXT: c:@F@unindexed ctu-other.c.ast
+// CHECK-NEXT: c:@F@mapped func-mapping-test.c.ast
+// CHECK-NOT: {{.}}
+
+int declared(int);
+
+static int internal(int x) {
+  return x;
+}
+
+int mapped(int x) {
+  return declared(x) + internal(x);
+}
@@ -0,0 +1,61 @@
+// RUN: %clang_cc1 -triple x86_64-pc-linux-gnu -analyze -analyzer-checker=core,debug.ExprInspection -verify %s
+
+// Range sets are uniqued, and the results of intersecting and joining them
+// are memoized. These check that reused results match fresh ones.
+
+void clang_analyzer_eval(int);
+
+void same_bounds_on_two_paths(int x, int c) {
+  if (c) {
+    if (x < 0 || x > 100)
+      return;
+  } else {
+    if (x < 0 || x > 100)
+      return;
+  }
+  clang_analyzer_eval(x >= 0 && x <= 100); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x == 50); // expected-warning{{UNKNOWN}}
+}
+
+void outside_range(int x) {
+  switch (x) {
+  case 11 ... 19:
+    return;
+  default:
+    break;
+  }
+  clang_analyzer_eval(x < 11 || x > 19); // expected-warning{{TRUE}}
+  clang_analyzer_eval(x == 5); // expected-warning{{UNKNOWN}}
+  switch (x) {
+  case 11 ... 19:
+    clang_analyzer_eval(0); // no-warning
+    break;
+  }
+}
+
+void wrapping_bounds(unsigned u) {
+  if (u - 5 > 10)
+    return;
+  clang_analyzer_eval(u >= 5 && u <= 15); // expected-warning{{TRUE}}
+  if (u - 5 > 10)
+    clang_analyzer_eval(0); // no-warning
+}
+
+// Enough distinct constraints on one symbol to fill up the caches, so that
+// they are cleared on the way.
+#define C1(n) if (x == (n)) return;
+#define C4(n) C1(n) C1(n + 1) C1(n + 2) C1(n + 3)
+#define C16(n) C4(n) C4(n + 4) C4(n + 8) C4(n + 12)
+#define C64(n) C16(n) C16(n + 16) C16(n + 32) C16(n + 48)
+#define C256(n) C64(n) C64(n + 64) C64(n + 128) C64(n + 192)
+#define C1024(n) C256(n) C256(n + 256) C256(n + 512) C256(n + 768)
+
+void many_bounds(int x) {
+  C1024(0)
+  C1024(1024)
+  C1024(2048)
+  clang_analyzer_eval(x == 100); // expected-warning{{FALSE}}
+  clang_analyzer_eval(x == 3071); // expected-warning{{FALSE}}
+  clang_analyzer_eval(x == 3072); // expected-warning{{UNKNOWN}}
+  clang_analyzer_eval(x < 0 || x > 3071); // expected-warning{{TRUE}}
+}
@@ -0,0 +1,54 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: cp %s %t/main.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress -verify %t/main.c 2> %t/first.txt
+// RUN: FileCheck -check-prefix=FIRST %s < %t/first.txt
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress -verify %t/main.c 2> %t/second.txt
+// RUN: FileCheck -check-prefix=SECOND-BUGGY %s < %t/second.txt
+// RUN: FileCheck -check-prefix=SECOND-CLEAN %s < %t/second.txt
+//
+// Change the body of inlined() only. The functions that call it are analyzed
+// again; the others are still skipped.
+// RUN: sed -e 's/x [+] 1;/x + 2;/' %s > %t/main.c
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/cache -analyzer-display-progress -verify %t/main.c 2> %t/third.txt
+// RUN: FileCheck -check-prefix=THIRD %s < %t/third.txt
+// RUN: FileCheck -check-prefix=THIRD-UNCHANGED %s < %t/third.txt
+//
+// A cache that cannot be written is diagnosed.
+// RUN: touch %t/not-a-directory
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-config summary-cache-dir=%t/not-a-directory/cache %t/main.c 2>&1 | FileCheck -check-prefix=WRITE-ERROR %s
+// WRITE-ERROR: warning: unable to write analyzer summary cache '{{.*}}not-a-directory{{.*}}'
+
+// Functions that are unchanged since the previous run and reported nothing
+// are not analyzed again. Functions with issues are, so that their issues
+// are reported again.
+
+int inlined(int x) {
+  return x + 1;
+}
+
+int clean(int x) {
+  return inlined(x);
+}
+
+int unchanged(int x) {
+  return x * 2;
+}
+
+void buggy(int *p) {
+  if (p)
+    return;
+  *p = 1; // expected-warning{{Dereference of null pointer}}
+}
+
+// FIRST-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} clean
+// FIRST-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} unchanged
+// FIRST-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} buggy
+
+// SECOND-BUGGY: ANALYZE (Path,  Inline_Regular): {{.*}} buggy
+// SECOND-CLEAN-NOT: ANALYZE (Path,  Inline_Regular): {{.*}} clean
+// SECOND-CLEAN-NOT: ANALYZE (Path,  Inline_Regular): {{.*}} unchanged
+// SECOND-CLEAN-NOT: ANALYZE (Path,  Inline_Regular): {{.*}} inlined
+
+// THIRD-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} clean
+// THIRD-DAG: ANALYZE (Path,  Inline_Regular): {{.*}} buggy
+// THIRD-UNCHANGED-NOT: ANALYZE (Path,  Inline_Regular): {{.*}} unchanged
@@ -0,0 +1,37 @@
+// REQUIRES: x86-registered-target
+// Diagnostics from generating code for the module in parts are reported
+// like those of a whole module, and follow the warning options. The parts are
+// generated on different threads, so each diagnostic is checked on its own.
+//
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj %s -o %t.o \
+// RUN:   -codegen-partition-output %t.1.o -codegen-partition-output %t.2.o \
+// RUN:   -mllvm -warn-stack-size=0 2> %t.err
+// RUN: FileCheck < %t.err %s --check-prefix=REGULAR
+// RUN: FileCheck < %t.err %s --check-prefix=ASM
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj %s -o %t.o \
+// RUN:   -codegen-partition-output %t.1.o -codegen-partition-output %t.2.o \
+// RUN:   -mllvm -warn-stack-size=0 -Werror=frame-larger-than= 2> %t.err
+// RUN: FileCheck < %t.err %s --check-prefix=PROMOTE
+// RUN: FileCheck < %t.err %s --check-prefix=ASM
+// RUN: not %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj %s -o %t.o \
+// RUN:   -codegen-partition-output %t.1.o -codegen-partition-output %t.2.o \
+// RUN:   -mllvm -warn-stack-size=0 -Wno-frame-larger-than= 2> %t.err
+// RUN: FileCheck < %t.err %s --check-prefix=IGNORE
+// RUN: FileCheck < %t.err %s --check-prefix=ASM
+
+extern void doIt(char *);
+
+// REGULAR: warning: stack frame size of {{[0-9]+}} bytes in function 'stackSizeWarning'
+// PROMOTE: error: stack frame size of {{[0-9]+}} bytes in function 'stackSizeWarning'
+// IGNORE-NOT: stack frame size of {{[0-9]+}} bytes in function 'stackSizeWarning'
+void stackSizeWarning() {
+  char buffer[80];
+  doIt(buffer);
+}
+
+// ASM: error: invalid instruction mnemonic 'not_an_instruction'
+void inlineAsmError() {
+  __asm__("not_an_instruction");
+}
+
+int other(int x) { return x + 1; }
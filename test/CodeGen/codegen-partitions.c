@@ -0,0 +1,30 @@
+// REQUIRES: x86-registered-target
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s -o %t.o \
+// RUN:   -codegen-partition-output %t.1.o -codegen-partition-output %t.2.o
+// RUN: llvm-nm %t.o %t.1.o %t.2.o | FileCheck %s
+//
+// Module-level inline assembly keeps the module whole.
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -O1 -emit-obj %s -o %t.o \
+// RUN:   -codegen-partition-output %t.1.o -DMODULE_ASM
+// RUN: llvm-nm %t.o %t.1.o | FileCheck -check-prefix=CHECK-ASM %s
+
+// CHECK-DAG: T f1
+// CHECK-DAG: T f2
+// CHECK-DAG: T f3
+// CHECK-DAG: t helper
+// CHECK-DAG: D counter
+
+// CHECK-ASM: T asm_sym
+// CHECK-ASM-NOT: asm_sym
+
+#ifdef MODULE_ASM
+__asm__(".text\n.globl asm_sym\nasm_sym:\n ret\n");
+#endif
+
+int counter = 1;
+
+__attribute__((noinline)) static int helper(int x) { return x * counter; }
+
+int f1(int x) { return helper(x) + 1; }
+int f2(int x) { return helper(x) - 1; }
+int f3(int x) { return x << 2; }
@@ -0,0 +1,43 @@
+// Objects that are linked are generated in parts, and all of the parts are
+// given to the linker.
+// RUN: %clang -target x86_64-unknown-linux -### -fcodegen-partitions=3 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-LINK %s
+//
+// CHECK-LINK: "-cc1"
+// CHECK-LINK-SAME: "-o" "[[OBJ:[^"]*\.o]]"
+// CHECK-LINK-SAME: "-codegen-partition-output" "[[PART1:[^"]*\.o]]"
+// CHECK-LINK-SAME: "-codegen-partition-output" "[[PART2:[^"]*\.o]]"
+// CHECK-LINK: "[[OBJ]]" "[[PART1]]" "[[PART2]]"
+
+// Linkers that do not take their inputs through the common path get the
+// parts too.
+// RUN: %clang -target x86_64-pc-windows-msvc -### -fcodegen-partitions=3 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-MSVC %s
+// RUN: %clang -target x86_64-unknown-unknown -### -fcodegen-partitions=3 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-GCC %s
+//
+// CHECK-MSVC: "-cc1"
+// CHECK-MSVC-SAME: "-o" "[[OBJ:[^"]*\.o]]"
+// CHECK-MSVC-SAME: "-codegen-partition-output" "[[PART1:[^"]*\.o]]"
+// CHECK-MSVC-SAME: "-codegen-partition-output" "[[PART2:[^"]*\.o]]"
+// CHECK-MSVC: "{{[^"]*}}link{{(.exe)?}}"
+// CHECK-MSVC-SAME: "[[OBJ]]" "[[PART1]]" "[[PART2]]"
+//
+// CHECK-GCC: "-cc1"
+// CHECK-GCC-SAME: "-o" "[[OBJ:[^"]*\.o]]"
+// CHECK-GCC-SAME: "-codegen-partition-output" "[[PART1:[^"]*\.o]]"
+// CHECK-GCC-SAME: "-codegen-partition-output" "[[PART2:[^"]*\.o]]"
+// CHECK-GCC: "[[OBJ]]" "[[PART1]]" "[[PART2]]"
+
+// Objects that are not linked by the driver stay whole.
+// RUN: %clang -target x86_64-unknown-linux -### -c -fcodegen-partitions=3 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-NOLINK %s
+// RUN: %clang -target x86_64-unknown-linux -### -fcodegen-partitions=1 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-NOLINK %s
+//
+// CHECK-NOLINK-NOT: "-codegen-partition-output"
+
+// RUN: %clang -target x86_64-unknown-linux -### -fcodegen-partitions=0 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=CHECK-INVALID %s
+//
+// CHECK-INVALID: invalid integral value '0' in '-fcodegen-partitions=0'
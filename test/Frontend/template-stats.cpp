@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-unknown-unknown -ftemplate-stats -fsyntax-only -o %t.o %s
+// RUN: FileCheck --input-file=%t.template-stats.json %s
+// RUN: %clang -### -c -ftemplate-stats %s 2>&1 | FileCheck --check-prefix=DRIVER %s
+
+namespace ns {
+template <unsigned N> struct Fact {
+  static const unsigned Value = N * Fact<N - 1>::Value;
+};
+template <> struct Fact<0> {
+  static const unsigned Value = 1;
+};
+
+template <typename T> T twice(T X) { return X + X; }
+template <typename T> T *twice(T *X) { return X; }
+}
+
+unsigned f = ns::Fact<3>::Value;
+unsigned g = ns::Fact<3>::Value;
+int h = ns::twice(1) + ns::twice(2);
+
+// CHECK: {"templates":[
+// CHECK-DAG: {"name":"ns::Fact","kind":"ClassTemplate","location":"{{.*}}template-stats.cpp:6:{{[0-9]+}}","instantiations":3,{{.*}},"deductions":0,"deduction failures":0,"lookups":5,"lookup hits":2,"specializations":[
+// CHECK-DAG:   {"name":"ns::Fact<3>","instantiations":1,
+// CHECK-DAG:   {"name":"ns::Fact<1>","instantiations":1,
+// CHECK-DAG: {"name":"ns::twice","kind":"FunctionTemplate","location":"{{.*}}template-stats.cpp:13:{{[0-9]+}}","instantiations":1,{{.*}},"deductions":2,"deduction failures":0,"lookups":2,"lookup hits":1,"specializations":[
+// CHECK-DAG:   {"name":"ns::twice<int>","instantiations":1,
+// CHECK-DAG: {"name":"ns::twice","kind":"FunctionTemplate","location":"{{.*}}template-stats.cpp:14:{{[0-9]+}}","instantiations":0,{{.*}},"deductions":2,"deduction failures":2,"lookups":0,"lookup hits":0,"specializations":[]}
+// CHECK: ]}
+
+// DRIVER: "-ftemplate-stats"
@@ -0,0 +1,23 @@
+// RUN: %clang_cc1 -std=c++11 -triple x86_64-unknown-unknown -ftime-trace -ftime-trace-granularity=0 -emit-llvm -o %t.ll %s
+// RUN: FileCheck --input-file=%t.json %s
+// RUN: %clang -### -c -ftime-trace -ftime-trace-granularity=100 %s 2>&1 | FileCheck --check-prefix=DRIVER %s
+
+namespace ns {
+template <typename T> struct Holder {
+  T Value;
+  T get() const { return Value; }
+};
+}
+
+int use(ns::Holder<int> H) { return H.get(); }
+
+// CHECK: {"traceEvents":[
+// CHECK-DAG: "name":"ParseClass","args":{"detail":"ns::Holder"}
+// CHECK-DAG: "name":"InstantiateTemplate","args":{"detail":"ns::Holder<int>"}
+// CHECK-DAG: "name":"ParseFunctionDefinition","args":{"detail":"use"}
+// CHECK-DAG: "name":"CodeGenFunction","args":{"detail":"use"}
+// CHECK-DAG: "name":"Backend","args":{"detail":"{{.*}}time-trace.cpp"}
+// CHECK-DAG: "name":"Total Frontend"
+// CHECK: "name":"process_name"
+
+// DRIVER: "-ftime-trace" "-ftime-trace-granularity=100"
@@ -0,0 +1,2 @@
+int first_fn(int);
+struct first_struct { int x; };
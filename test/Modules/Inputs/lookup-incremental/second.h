@@ -0,0 +1,3 @@
+int second_fn(int);
+int shared_fn(int);
+enum { second_value = 2 };
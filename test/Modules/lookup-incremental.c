@@ -0,0 +1,32 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t -I %S/Inputs/lookup-incremental -verify %s
+// RUN: %clang_cc1 -x c++ -fmodules -fimplicit-module-maps -fmodules-cache-path=%t -I %S/Inputs/lookup-incremental -verify %s
+// expected-no-diagnostics
+
+// The translation unit's lookup table already exists when the second module
+// is imported. Its new names are added to the table as they are loaded; a
+// name that is already in the table makes it be rebuilt instead.
+
+#ifdef __cplusplus
+#define GLOBAL ::
+#else
+#define GLOBAL
+#endif
+
+#include "first.h"
+
+int shared_fn(int);
+
+int use_first(void) {
+  struct first_struct s = { GLOBAL first_fn(1) };
+  return s.x + GLOBAL shared_fn(0);
+}
+
+#include "second.h"
+
+int use_second(void) {
+  struct first_struct s = { second_value };
+  return GLOBAL second_fn(s.x) + GLOBAL shared_fn(GLOBAL first_fn(0));
+}
+
+int shared_fn(int x) { return x; }
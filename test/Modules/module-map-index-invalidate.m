@@ -0,0 +1,39 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/include
+// RUN: echo 'module A { header "a.h" }' > %t/include/module.modulemap
+// RUN: echo 'int a;' > %t/include/a.h
+// RUN: echo 'int z;' > %t/include/z.h
+// RUN: touch -t 200001010000 %t/include/module.modulemap
+//
+// The first compilation indexes the module map, and the second one reads the
+// saved index instead of writing it again.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache1 -fmodule-map-index-path=%t/index -I %t/include -fsyntax-only -verify %s
+// RUN: ls %t/index | count 1
+// RUN: touch -t 200001010000 %t/index/*
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache2 -fmodule-map-index-path=%t/index -I %t/include -fsyntax-only -verify %s
+// RUN: find %t/index -type f -newer %t/include/module.modulemap | count 0
+//
+// Modifying the module map invalidates the saved index; the file is indexed
+// again, and the new declarations are found at their new offsets. The index
+// of a module map modified this second is not written, so backdate the new
+// one; its size still differs from the indexed one.
+// RUN: printf 'module Z { header "z.h" }\nmodule A { header "a.h" }\n' > %t/include/module.modulemap
+// RUN: touch -t 200001010000 %t/include/module.modulemap
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache3 -fmodule-map-index-path=%t/index -I %t/include -fsyntax-only -verify %s -DWITH_Z
+// RUN: ls %t/index | count 1
+// RUN: cat %t/index/* | FileCheck %s
+
+// CHECK: decl 0 0 0 Z
+// CHECK: decl {{[1-9][0-9]*}} 0 0 A
+
+@import A;
+
+#ifdef WITH_Z
+@import Z;
+int use = a + z;
+#else
+int use = a;
+#endif
+
+// expected-no-diagnostics
@@ -0,0 +1,14 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache -fmodule-map-index-path=%t/index -I %S/Inputs/module-map-index-private -fsyntax-only -verify %s
+// RUN: ls %t/index | count 2
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache -fmodule-map-index-path=%t/index -I %S/Inputs/module-map-index-private -fsyntax-only -verify %s
+
+// The header belongs to a submodule that is declared on its own in the
+// private module map. Its top-level module, declared in the public module
+// map, is parsed first, although it does not name the header.
+
+#include "Foo_Private.h"
+
+int use = foo_private;
+
+// expected-no-diagnostics
@@ -0,0 +1,21 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache -fmodule-map-index-path=%t/index -I %S/Inputs/module-map-index -fsyntax-only -verify %s
+// RUN: ls %t/index | FileCheck -check-prefix=INDEX %s
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache -fmodule-map-index-path=%t/index -I %S/Inputs/module-map-index -fsyntax-only -verify %s
+// RUN: not %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t/cache-full -I %S/Inputs/module-map-index -fsyntax-only %s 2>&1 | FileCheck -check-prefix=FULL %s
+// RUN: %clang -### -fsyntax-only -fmodule-map-index-path=%t/index %s 2>&1 | FileCheck -check-prefix=DRIVER %s
+
+// With a module map index, only the declarations of the modules that are
+// imported, and of the modules of the headers that are included, are parsed;
+// the error in module B is never seen.
+
+// INDEX: .mmi
+// FULL: error: expected umbrella, header, submodule, or module export
+// DRIVER: "-fmodule-map-index-path={{.*}}index"
+
+@import A;
+#include "c.h"
+
+int use = a + c;
+
+// expected-no-diagnostics
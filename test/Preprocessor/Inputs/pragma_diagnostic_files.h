@@ -0,0 +1,8 @@
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-variable"
+void headerIgnored() { int a; }
+template <typename T> void headerIgnoredLate() { T a; }
+#pragma clang diagnostic pop
+
+void headerWarned() { int a; } // expected-warning {{unused variable 'a'}}
+template <typename T> void headerWarnedLate() { T a; } // expected-warning {{unused variable 'a'}}
@@ -0,0 +1,47 @@
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/a %t/b/sub
+// RUN: echo 'int from_b;' > %t/b/x.h
+// RUN: echo 'int from_b_sub;' > %t/b/sub/y.h
+// RUN: touch -t 200001010000 %t/a %t/b %t/b/sub
+//
+// The first compilation saves its lookups, and the second one uses them
+// without writing the unchanged cache again.
+// RUN: %clang_cc1 -fsyntax-only -verify -fheader-search-cache-path=%t/cache -I %t/a -I %t/b %s -DFROM_B
+// RUN: ls %t/cache | count 1
+// RUN: touch -t 200001010000 %t/cache/*
+// RUN: %clang_cc1 -fsyntax-only -verify -fheader-search-cache-path=%t/cache -I %t/a -I %t/b %s -DFROM_B
+// RUN: find %t/cache -type f -newer %t/a | count 0
+//
+// A cache that cannot be written is diagnosed.
+// RUN: echo > %t/not-a-directory
+// RUN: %clang_cc1 -fsyntax-only -fheader-search-cache-path=%t/not-a-directory -I %t/a -I %t/b %s -DFROM_B 2>&1 | FileCheck -check-prefix=WRITE-ERROR %s
+// WRITE-ERROR: warning: unable to write header search cache '{{.*}}not-a-directory{{.*}}'
+//
+// Adding headers to a directory that was skipped makes them visible.
+// RUN: echo 'int from_a;' > %t/a/x.h
+// RUN: mkdir %t/a/sub
+// RUN: echo 'int from_a_sub;' > %t/a/sub/y.h
+// RUN: %clang_cc1 -fsyntax-only -verify -fheader-search-cache-path=%t/cache -I %t/a -I %t/b %s
+//
+// Different search directories use a different cache file.
+// RUN: %clang_cc1 -fsyntax-only -verify -fheader-search-cache-path=%t/cache -I %t/b %s -DFROM_B
+// RUN: ls %t/cache | count 2
+//
+// RUN: %clang -### -fsyntax-only -fheader-search-cache-path=%t/cache %s 2>&1 | FileCheck %s
+// CHECK: "-fheader-search-cache-path={{.*}}cache"
+
+// expected-no-diagnostics
+
+#include "x.h"
+#include "sub/y.h"
+
+#if __has_include("missing.h") || __has_include(<sub/missing.h>)
+#error found a missing header
+#endif
+
+#ifdef FROM_B
+int check = from_b + from_b_sub;
+#else
+int check = from_a + from_a_sub;
+#endif
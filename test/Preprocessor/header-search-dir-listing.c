@@ -0,0 +1,21 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/a/sub %t/b/sub
+// RUN: echo 'int from_b;' > %t/b/x.h
+// RUN: echo 'int from_b_sub;' > %t/b/sub/y.h
+// RUN: echo 'int from_a_sub;' > %t/a/sub/z.h
+// RUN: %clang_cc1 -fsyntax-only -verify -fheader-search-dir-listing -I %t/a -I %t/b %s
+//
+// RUN: %clang -### -fsyntax-only -fheader-search-dir-listing %s 2>&1 | FileCheck %s
+// CHECK: "-fheader-search-dir-listing"
+
+// expected-no-diagnostics
+
+#include "x.h"
+#include "sub/y.h"
+#include <sub/z.h>
+
+#if __has_include("missing.h") || __has_include(<sub/missing.h>)
+#error found a missing header
+#endif
+
+int check = from_b + from_b_sub + from_a_sub;
@@ -0,0 +1,30 @@
+// RUN: %clang_cc1 -fsyntax-only -Wunused-variable -I %S/Inputs -verify %s
+
+// The diagnostic state at a location is looked up by its offset in its file,
+// relative to the pragmas in the file and in the files that it includes. The
+// templates are only instantiated at the end of the translation unit, after
+// all of the pragmas.
+
+void before() { int a; } // expected-warning {{unused variable 'a'}}
+
+#include "pragma_diagnostic_files.h"
+
+void after() { int a; } // expected-warning {{unused variable 'a'}}
+
+#define DECLARE(x) int x;
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-variable"
+void ignored() { DECLARE(a) }
+template <typename T> void ignoredLate() { T a; }
+#pragma clang diagnostic pop
+
+void warned() { DECLARE(a) } // expected-warning {{unused variable 'a'}}
+template <typename T> void warnedLate() { T a; } // expected-warning {{unused variable 'a'}}
+
+void use() {
+  headerIgnoredLate<int>();
+  headerWarnedLate<int>(); // expected-note {{requested here}}
+  ignoredLate<int>();
+  warnedLate<int>(); // expected-note {{requested here}}
+}
@@ -0,0 +1,134 @@
+// RUN: %clang_cc1 -std=c++1y -triple x86_64-unknown-unknown -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++1y -triple x86_64-unknown-unknown -fsyntax-only -verify %s -fexperimental-constexpr-bytecode
+// RUN: %clang -### -fsyntax-only -fexperimental-constexpr-bytecode %s 2>&1 | FileCheck %s
+
+// CHECK: "-fexperimental-constexpr-bytecode"
+
+// Calls evaluated by the bytecode interpreter must give the same results, and
+// calls that it gives up on must give the same diagnostics, as the tree
+// walker.
+
+constexpr int fib(int n) {
+  int a = 0, b = 1;
+  for (int i = 0; i < n; ++i) {
+    int t = a + b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+static_assert(fib(10) == 55, "");
+static_assert(fib(46) == 1836311903, "");
+
+constexpr unsigned gcd(unsigned a, unsigned b) {
+  while (b) {
+    unsigned t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+static_assert(gcd(84, 36) == 12, "");
+
+constexpr int collatz(long long n) {
+  int steps = 0;
+  do {
+    if (n == 1)
+      break;
+    n = n % 2 ? 3 * n + 1 : n / 2;
+  } while (++steps);
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr int sum_odd(int n) {
+  int s = 0;
+  for (int i = 0; i < n; ++i) {
+    if (i % 2 == 0)
+      continue;
+    s += i;
+  }
+  return s;
+}
+static_assert(sum_odd(10) == 25, "");
+
+constexpr bool is_prime(int n) {
+  if (n < 2)
+    return false;
+  for (int d = 2; d * d <= n; ++d)
+    if (n % d == 0)
+      return false;
+  return true;
+}
+static_assert(is_prime(7919) && !is_prime(7917), "");
+
+constexpr unsigned mix(unsigned h, int n) {
+  for (int i = 0; i < n; ++i)
+    h = (h ^ i) * 16777619u;
+  return h;
+}
+static_assert(mix(2166136261u, 5) == 3122569199u, "");
+
+constexpr signed char wrap(signed char c) {
+  c += 100;
+  return c;
+}
+static_assert(wrap(100) == -56, "");
+
+constexpr unsigned long long bit(int n) { return 1ull << n; }
+static_assert(bit(63) == 0x8000000000000000ull, "");
+
+constexpr int post(int n) {
+  int m = n++;
+  return m * 10 + n;
+}
+static_assert(post(4) == 45, "");
+
+enum class Color : unsigned char { Red, Green, Blue };
+constexpr Color next(Color c) {
+  return c == Color::Blue ? Color::Red : Color(int(c) + 1);
+}
+static_assert(next(next(next(Color::Red))) == Color::Red, "");
+
+constexpr int Limit = 10;
+constexpr int clamp(int n) {
+  return n > Limit ? Limit : n < -Limit ? -Limit : n;
+}
+static_assert(clamp(12) == 10 && clamp(-12) == -10 && clamp(3) == 3, "");
+
+constexpr int scale(int n, int by = 3) { return n * by; }
+constexpr int use_scale(int n) { return scale(n) + scale(n, 2); }
+static_assert(use_scale(4) == 20, "");
+
+// Not compiled: pointer parameter.
+constexpr unsigned fnv(const char *s, unsigned h = 2166136261u) {
+  return *s ? fnv(s + 1, (h ^ *s) * 16777619u) : h;
+}
+static_assert(fnv("") == 2166136261u, "");
+
+constexpr int add(int a, int b) { return a + b; }
+static_assert(add(__INT_MAX__, 1), ""); // expected-error {{constant expression}} expected-note {{outside the range}} expected-note {{in call to 'add(2147483647, 1)'}}
+
+constexpr int divide(int a, int b) { return a / b; }
+static_assert(divide(1, 0), ""); // expected-error {{constant expression}} expected-note {{division by zero}} expected-note {{in call to 'divide(1, 0)'}}
+
+constexpr int shl(int a, int b) { return a << b; }
+static_assert(shl(1, 32), ""); // expected-error {{constant expression}} expected-note {{shift count 32 >= width of type 'int'}} expected-note {{in call to 'shl(1, 32)'}}
+
+constexpr int noret(int n) {
+  if (n)
+    return 1;
+} // expected-warning {{control may reach end of non-void function}} expected-note {{control reached end of constexpr function}}
+static_assert(noret(0), ""); // expected-error {{constant expression}} expected-note {{in call to 'noret(0)'}}
+
+// Reads of variables whose initializer is on another declaration, or nowhere.
+struct Consts {
+  static const int Scale;
+};
+const int Consts::Scale = 7;
+constexpr int read_member(int n) { return n * Consts::Scale; }
+static_assert(read_member(3) == 21, "");
+
+extern const int Offset;
+constexpr int read_extern(int n) { return n + Offset; } // expected-note {{subexpression not valid in a constant expression}}
+static_assert(read_extern(1) == 1, ""); // expected-error {{constant expression}} expected-note {{in call to 'read_extern(1)'}}
@@ -0,0 +1,27 @@
+// RUN: %clang_cc1 -std=c++11 -fsyntax-only -verify %s
+
+// The specialization deduced for a call is reused for later calls with the
+// same argument types. Make sure that the value kinds of the arguments are
+// taken into account, and that failed deductions are performed again.
+
+template<typename T> T &&fwd(T &&);
+
+typedef int myint;
+
+void test_value_kinds(int i, myint j) {
+  int &a = fwd(i);
+  int &&b = fwd(0);
+  int &&c = fwd(static_cast<int &&>(i));
+  int &d = fwd(j);
+  int &&e = fwd(static_cast<myint &&>(j));
+  int &f = fwd(0); // expected-error{{non-const lvalue reference to type 'int' cannot bind to}}
+}
+
+template<typename T> auto size(T *) -> decltype(sizeof(T), char());
+int size(...);
+
+struct S;
+static_assert(sizeof(size((S *)0)) == sizeof(int), "");
+struct S {};
+static_assert(sizeof(size((S *)0)) == sizeof(char), "");
+static_assert(sizeof(size((S *)0)) == sizeof(char), "");
@@ -0,0 +1,42 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Function template candidates whose parameters cannot match the kinds of the
+// arguments are rejected before template argument deduction. Make sure that
+// this does not reject viable candidates, and that the reason for the failure
+// is still given when a rejected candidate is diagnosed.
+
+template<typename T> struct complex {};
+struct Derived : complex<int> {};
+struct S { int m; };
+
+template<typename T> void f(complex<T>); // expected-note{{candidate template ignored: could not match 'complex<type-parameter-0-0>' against 'int'}}
+template<typename T> void f(T *); // expected-note-re{{candidate template ignored: could not match '{{.*}}' against 'int'}}
+template<typename T> void f(int T::*); // expected-note-re{{candidate template ignored: could not match '{{.*}}' against 'int'}}
+template<typename T> void f(T, T); // expected-note{{candidate function template not viable: requires 2 arguments, but 1 was provided}}
+
+void test_f() {
+  f(0); // expected-error{{no matching function for call to 'f'}}
+}
+
+template<typename T> int &g(const complex<T> &);
+template<typename T> char &g(T *);
+template<typename T> long &g(int T::*);
+
+template<typename T> short &h(T, ...);
+
+void test_g(Derived d, int (&a)[3], void fn()) {
+  int &x = g(d);
+  char &y1 = g(a);
+  char &y2 = g(fn);
+  char &y3 = g((S *)nullptr);
+  long &z = g(&S::m);
+  short &w = h(0, 1, 2);
+}
+
+// The address of an overloaded function is deduced from by special rules, so
+// it is never rejected early.
+template<typename T> int k(T *);
+void ovl(int);
+void ovl(double);
+int test_k() { return k(&ovl); } // expected-error{{no matching function for call to 'k'}}
+// expected-note@-3{{candidate template ignored: couldn't infer template argument 'T'}}
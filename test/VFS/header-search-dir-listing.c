@@ -0,0 +1,20 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: echo 'int from_disk;' > %t/real.h
+// RUN: sed -e "s:INPUT_DIR:%S/Inputs:g" -e "s:OUT_DIR:%t:g" %S/Inputs/vfsoverlay.yaml > %t.yaml
+// RUN: %clang_cc1 -Werror -fheader-search-dir-listing -I %t -ivfsoverlay %t.yaml -fsyntax-only %s
+// REQUIRES: shell
+
+// The overlay lists not_real.h under the name of the file it is mapped to,
+// which must not hide it from header search.
+#include "not_real.h"
+#include "real.h"
+
+#if __has_include("missing.h")
+#error found a missing header
+#endif
+
+void foo() {
+  bar();
+}
+
+int check = from_disk;
@@ -0,0 +1,89 @@
+//===--- tools/clang-func-mapping/ClangFnMapGen.cpp - Function map tool ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the clang-func-mapping tool, which writes the index
+//  used by the static analyzer for cross translation unit inlining. For each
+//  externally visible function defined in the main file of the given
+//  serialized ASTs it prints a line holding the USR of the function and the
+//  AST file, exactly as it was named on the command line:
+//
+//    cd ctu-dir && clang-func-mapping *.ast > externalFnMap.txt
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/PCHContainerOperations.h"
+#include "clang/Index/USRGeneration.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace clang;
+using namespace llvm;
+
+static cl::list<std::string> ASTFiles(cl::Positional, cl::OneOrMore,
+                                      cl::desc("<ast files>"));
+
+static void mapFunctionNames(const DeclContext *DC, const SourceManager &SM,
+                             StringRef ASTFile) {
+  for (const Decl *D : DC->decls()) {
+    if (isa<NamespaceDecl>(D) || isa<LinkageSpecDecl>(D)) {
+      mapFunctionNames(cast<DeclContext>(D), SM, ASTFile);
+      continue;
+    }
+
+    // The analyzer only imports free functions; see CrossTUInjector.
+    const FunctionDecl *FD = dyn_cast<FunctionDecl>(D);
+    if (!FD || isa<CXXMethodDecl>(FD) ||
+        !FD->isThisDeclarationADefinition() ||
+        !FD->hasExternalFormalLinkage() ||
+        !SM.isInMainFile(FD->getLocation()))
+      continue;
+
+    SmallString<128> USR;
+    if (index::generateUSRForDecl(FD, USR))
+      continue;
+    outs() << USR << ' ' << ASTFile << '\n';
+  }
+}
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;
+
+  cl::ParseCommandLineOptions(argc, argv, "clang function mapping tool\n");
+
+  RawPCHContainerReader PCHContainerRdr;
+  int Result = 0;
+  for (const std::string &ASTFile : ASTFiles) {
+    IntrusiveRefCntPtr<DiagnosticsEngine> Diags =
+        CompilerInstance::createDiagnostics(new DiagnosticOptions());
+    std::unique_ptr<ASTUnit> Unit = ASTUnit::LoadFromASTFile(
+        ASTFile, PCHContainerRdr, Diags, FileSystemOptions());
+    if (!Unit) {
+      errs() << "error: could not load '" << ASTFile << "'\n";
+      Result = 1;
+      continue;
+    }
+
+    mapFunctionNames(Unit->getASTContext().getTranslationUnitDecl(),
+                     Unit->getSourceManager(), ASTFile);
+  }
+  return Result;
+}
@@ -15,6 +15,7 @@
 #include "MatchVerifier.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Tooling/Tooling.h"
 #include "gtest/gtest.h"
 
@@ -82,5 +83,75 @@ TEST(GetParents, ReturnsMultipleParentsInTemplateInstantiations) {
           hasAncestor(cxxRecordDecl(unless(isTemplateInstantiation())))))));
 }
 
+TEST(GetParents, ComputesParentsPerTopLevelDecl) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "void f() { int x; }"
+      "namespace n { void g() { int y; } }"
+      "template<typename T> struct C { void h() { T z; } };"
+      "void i() { C<int>().h(); }");
+  ASSERT_TRUE(AST.get());
+  ASTContext &Context = AST->getASTContext();
+  const TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+  auto Find = [&](StringRef Name) {
+    return selectFirst<VarDecl>(
+        "v", match(decl(hasDescendant(varDecl(hasName(Name)).bind("v"))),
+                   *TU, Context));
+  };
+
+  // A declaration in a later top-level declaration.
+  const VarDecl *Y = Find("y");
+  ASSERT_TRUE(Y != nullptr);
+  auto Parents = Context.getParents(*Y);
+  ASSERT_EQ(1u, Parents.size());
+  const auto *YStmt = Parents[0].get<DeclStmt>();
+  ASSERT_TRUE(YStmt != nullptr);
+  auto StmtParents = Context.getParents(*YStmt);
+  ASSERT_EQ(1u, StmtParents.size());
+  EXPECT_TRUE(StmtParents[0].get<CompoundStmt>() != nullptr);
+
+  // A declaration in an earlier one, which has not been visited yet.
+  const VarDecl *X = Find("x");
+  ASSERT_TRUE(X != nullptr);
+  EXPECT_EQ(1u, Context.getParents(*X).size());
+
+  const FunctionDecl *G = cast<FunctionDecl>(Y->getDeclContext());
+  EXPECT_TRUE(Context.getParents(*G)[0].get<NamespaceDecl>() != nullptr);
+
+  // The remaining declarations, once everything has been visited.
+  Context.buildParentMap();
+  const VarDecl *Z = Find("z");
+  ASSERT_TRUE(Z != nullptr);
+  EXPECT_EQ(1u, Context.getParents(*Z).size());
+
+  EXPECT_TRUE(Context.getParents(*TU).empty());
+}
+
+TEST(GetParents, ReturnsAllParentsOfSharedNodes) {
+  // The instantiation of C<int>::f() is traversed from the first top-level
+  // declaration, and shares its body with the out-of-line definition.
+  const char Code[] = "template<typename T> struct C { void f(); };"
+                      "void g() { C<int>().f(); }"
+                      "template<typename T> void C<T>::f() {}";
+
+  MatchVerifier<Stmt> Verifier;
+  EXPECT_TRUE(Verifier.match(
+      Code, compoundStmt(
+                hasParent(cxxMethodDecl(isTemplateInstantiation())),
+                hasParent(cxxMethodDecl(unless(isTemplateInstantiation()))))));
+
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(Code);
+  ASSERT_TRUE(AST.get());
+  ASTContext &Context = AST->getASTContext();
+  const CXXMethodDecl *F = selectFirst<CXXMethodDecl>(
+      "f", match(decl(hasDescendant(
+                     cxxMethodDecl(hasName("f"), isDefinition(),
+                                   unless(isTemplateInstantiation()))
+                         .bind("f"))),
+                 *Context.getTranslationUnitDecl(), Context));
+  ASSERT_TRUE(F != nullptr);
+  ASSERT_TRUE(F->getBody() != nullptr);
+  EXPECT_EQ(2u, Context.getParents(*F->getBody()).size());
+}
+
 } // end namespace ast_matchers
 } // end namespace clang
@@ -4897,6 +4897,46 @@ TEST(MatchFinder, CheckProfiling) {
   EXPECT_EQ("MyID", Records.begin()->getKey());
 }
 
+TEST(MatchFinder, MatchesInParallel) {
+  struct RecordNames : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {
+      const auto *D = Result.Nodes.getNodeAs<NamedDecl>("d");
+      Names.push_back(D->getNameAsString());
+    }
+    std::vector<std::string> Names;
+  };
+
+  std::string Code = "class A {}; typedef A B;";
+  for (unsigned I = 0; I != 32; ++I) {
+    std::string N = std::to_string(I);
+    Code += "class C" + N + " : public B {};";
+    Code += "void f" + N + "() { int x = 0; (void)x; }";
+  }
+  std::unique_ptr<ASTUnit> AST(tooling::buildASTFromCode(Code));
+  ASSERT_TRUE(AST.get());
+
+  auto Run = [&](unsigned NumThreads) {
+    MatchFinder::MatchFinderOptions Options;
+    Options.NumThreads = NumThreads;
+    MatchFinder Finder(std::move(Options));
+    RecordNames Callback;
+    Finder.addMatcher(
+        cxxRecordDecl(isDerivedFrom("B"), isDefinition()).bind("d"),
+        &Callback);
+    Finder.addMatcher(varDecl(hasAncestor(functionDecl())).bind("d"),
+                      &Callback);
+    Finder.addMatcher(
+        functionDecl(hasDescendant(varDecl(hasName("x")))).bind("d"),
+        &Callback);
+    Finder.matchAST(AST->getASTContext());
+    return Callback.Names;
+  };
+
+  std::vector<std::string> Expected = Run(1);
+  EXPECT_EQ(32u * 3, Expected.size());
+  EXPECT_EQ(Expected, Run(4));
+}
+
 class VerifyStartOfTranslationUnit : public MatchFinder::MatchCallback {
 public:
   VerifyStartOfTranslationUnit() : Called(false) {}
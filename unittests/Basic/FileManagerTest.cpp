@@ -12,6 +12,7 @@
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -246,6 +247,29 @@ TEST_F(FileManagerTest, addRemoveStatCache) {
   manager.removeStatCache(statCache);
 }
 
+// directoryMayContain() rules out the files whose names are not in the
+// listings of the directories on the way to them.
+TEST(FileManagerDirectoryListingTest, directoryMayContain) {
+  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> FS(new vfs::InMemoryFileSystem);
+  FS->addFile("/a/x.h", 0, MemoryBuffer::getMemBuffer(""));
+  FS->addFile("/a/sub/y.h", 0, MemoryBuffer::getMemBuffer(""));
+  FileManager manager((FileSystemOptions()), FS);
+
+  const DirectoryEntry *dir = manager.getDirectory("/a");
+  ASSERT_TRUE(dir != nullptr);
+  EXPECT_TRUE(manager.directoryMayContain(dir, "x.h"));
+  EXPECT_TRUE(manager.directoryMayContain(dir, "X.h"));
+  EXPECT_FALSE(manager.directoryMayContain(dir, "z.h"));
+  EXPECT_TRUE(manager.directoryMayContain(dir, "sub/y.h"));
+  EXPECT_FALSE(manager.directoryMayContain(dir, "sub/z.h"));
+  EXPECT_FALSE(manager.directoryMayContain(dir, "other/y.h"));
+  EXPECT_FALSE(manager.directoryMayContain(dir, "x.h/y.h"));
+
+  // Virtual files are not in the listings.
+  manager.getVirtualFile("/a/v.h", 0, 0);
+  EXPECT_TRUE(manager.directoryMayContain(dir, "v.h"));
+}
+
 #endif  // !LLVM_ON_WIN32
 
 } // anonymous namespace
@@ -0,0 +1,57 @@
+//===- unittests/Basic/IdentifierTableTest.cpp - IdentifierTable tests ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+unsigned hash(StringRef Name) {
+  unsigned Hash = 0;
+  for (char C : Name)
+    Hash = IdentifierTable::updateHash(Hash, C);
+  return Hash;
+}
+
+TEST(IdentifierTableTest, GetWithHashFindsSameIdentifiers) {
+  LangOptions LangOpts;
+  LangOpts.CPlusPlus = true;
+  IdentifierTable Table(LangOpts);
+
+  IdentifierInfo &Int = Table.getWithHash("int", hash("int"));
+  EXPECT_EQ(&Table.get("int"), &Int);
+  EXPECT_EQ(tok::kw_int, Int.getTokenID());
+
+  IdentifierInfo &Foo = Table.getWithHash("foo", hash("foo"));
+  EXPECT_EQ(&Table.get("foo"), &Foo);
+  EXPECT_EQ(&Foo, &Table.getWithHash("foo", hash("foo")));
+  EXPECT_EQ(tok::identifier, Foo.getTokenID());
+}
+
+TEST(IdentifierTableTest, GetWithHashHandlesCollisions) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  // Identifiers whose hashes agree in all of the bits that select the cache
+  // entry must still be told apart.
+  IdentifierInfo &A = Table.getWithHash("a", 0);
+  IdentifierInfo &B = Table.getWithHash("b", 0);
+  IdentifierInfo &AB = Table.getWithHash("ab", 0);
+  EXPECT_NE(&A, &B);
+  EXPECT_NE(&A, &AB);
+  EXPECT_EQ(&A, &Table.getWithHash("a", 0));
+  EXPECT_EQ(&B, &Table.get("b"));
+  EXPECT_EQ("ab", AB.getName());
+}
+
+} // end anonymous namespace
@@ -170,6 +170,42 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, nullptr));
 }
 
+TEST_F(SourceManagerTest, getLineNumberAlternatingFiles) {
+  const char *Sources[] = {
+    "a\nb\nc\nd\n",
+    "x\n\ny\n\nz\n",
+    "1\r\n2\r\n3",
+    "p\nq",
+    "only one line",
+    "\n\n\n\n\n\n"
+  };
+  const unsigned NumSources = llvm::array_lengthof(Sources);
+
+  FileID IDs[NumSources];
+  for (unsigned I = 0; I != NumSources; ++I)
+    IDs[I] = SourceMgr.createFileID(MemoryBuffer::getMemBuffer(Sources[I]));
+
+  // Query every file in turn, more files than the line number cache holds,
+  // and make sure that switching between them never produces stale results.
+  for (unsigned Round = 0; Round != 3; ++Round) {
+    for (unsigned I = 0; I != NumSources; ++I) {
+      const char *Source = Sources[I];
+      unsigned Len = strlen(Source);
+      unsigned ExpectedLine = 1;
+      for (unsigned Pos = 0; Pos != Len; ++Pos) {
+        bool Invalid = false;
+        EXPECT_EQ(ExpectedLine,
+                  SourceMgr.getLineNumber(IDs[I], Pos, &Invalid));
+        EXPECT_FALSE(Invalid);
+        // Also hit another file in between to force a cache switch.
+        EXPECT_EQ(1U, SourceMgr.getLineNumber(IDs[(I + 1) % NumSources], 0));
+        if (Source[Pos] == '\n')
+          ++ExpectedLine;
+      }
+    }
+  }
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
@@ -358,4 +394,36 @@ TEST_F(SourceManagerTest, isBeforeInTranslationUnitWithMacroInInclude) {
 
 #endif
 
+class NullExternalSLocEntrySource : public ExternalSLocEntrySource {
+  bool ReadSLocEntry(int ID) override { return true; }
+  std::pair<SourceLocation, StringRef> getModuleImportLoc(int ID) override {
+    return std::make_pair(SourceLocation(), StringRef());
+  }
+};
+
+TEST_F(SourceManagerTest, exhaustSLocSpace) {
+  NullExternalSLocEntrySource External;
+  SourceMgr.setExternalSLocEntrySource(&External);
+
+  // Loaded entries that do not fit are refused rather than wrapping around.
+  EXPECT_EQ(0U, SourceMgr.AllocateLoadedSLocEntries(1, ~0U).second);
+
+  // Leave room for exactly 100 bytes of local entries, including the
+  // location just past the end of each of them.
+  unsigned Loaded = SourceMgr.AllocateLoadedSLocEntries(1, 1).second;
+  unsigned Base = SourceMgr.AllocateLoadedSLocEntries(
+      1, Loaded - SourceMgr.getNextLocalOffset() - 100).second;
+  ASSERT_EQ(100U, Base - SourceMgr.getNextLocalOffset());
+
+  std::string Source(99, ' ');
+  FileID FID = SourceMgr.createFileID(MemoryBuffer::getMemBuffer(Source));
+  EXPECT_TRUE(FID.isValid());
+  EXPECT_EQ(Base, SourceMgr.getNextLocalOffset());
+
+#if GTEST_HAS_DEATH_TEST
+  EXPECT_DEATH(SourceMgr.createFileID(MemoryBuffer::getMemBuffer("")),
+               "ran out of source locations");
+#endif
+}
+
 } // anonymous namespace
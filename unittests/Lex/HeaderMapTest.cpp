@@ -8,11 +8,15 @@
 //===--------------------------------------------------------------===//
 
 #include "clang/Basic/CharInfo.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemOptions.h"
 #include "clang/Lex/HeaderMap.h"
 #include "clang/Lex/HeaderMapTypes.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SwapByteOrder.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 #include <cassert>
 #include <type_traits>
@@ -23,15 +27,19 @@ using namespace llvm;
 namespace {
 
 // Lay out a header file for testing.
-template <unsigned NumBuckets, unsigned NumBytes> struct MapFile {
+template <unsigned NumBuckets, unsigned NumBytes,
+          class BucketTy = HMapBucket>
+struct MapFile {
   HMapHeader Header;
-  HMapBucket Buckets[NumBuckets];
+  BucketTy Buckets[NumBuckets];
   unsigned char Bytes[NumBytes];
 
   void init() {
     memset(this, 0, sizeof(MapFile));
     Header.Magic = HMAP_HeaderMagicNumber;
-    Header.Version = HMAP_HeaderVersion;
+    Header.Version = std::is_same<BucketTy, HMapBucketV2>::value
+                         ? HMAP_HeaderVersion2
+                         : HMAP_HeaderVersion;
     Header.NumBuckets = NumBuckets;
     Header.StringsOffset = sizeof(Header) + sizeof(Buckets);
   }
@@ -60,6 +68,9 @@ static inline unsigned getHash(StringRef Str) {
   return Result;
 }
 
+static inline void setHash(HMapBucket &, unsigned) {}
+static inline void setHash(HMapBucketV2 &B, unsigned Hash) { B.Hash = Hash; }
+
 template <class FileTy> struct FileMaker {
   FileTy &File;
   unsigned SI = 1;
@@ -81,6 +92,7 @@ template <class FileTy> struct FileMaker {
         File.Buckets[I].Key = Key;
         File.Buckets[I].Prefix = Prefix;
         File.Buckets[I].Suffix = Suffix;
+        setHash(File.Buckets[I], Hash);
         ++File.Header.NumEntries;
         return;
       }
@@ -118,7 +130,7 @@ TEST(HeaderMapTest, checkHeaderReserved) {
 TEST(HeaderMapTest, checkHeaderVersion) {
   MapFile<1, 1> File;
   File.init();
-  ++File.Header.Version;
+  File.Header.Version = HMAP_HeaderVersion2 + 1;
   bool NeedsSwap;
   ASSERT_FALSE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
 }
@@ -181,6 +193,79 @@ TEST(HeaderMapTest, lookupFilename) {
   ASSERT_EQ("bc", Map.lookupFilename("a", DestPath));
 }
 
+TEST(HeaderMapTest, checkHeaderVersion2) {
+  MapFile<1, 1, HMapBucketV2> File;
+  File.init();
+  bool NeedsSwap;
+  ASSERT_TRUE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
+  ASSERT_FALSE(NeedsSwap);
+
+  File.swapBytes();
+  ASSERT_TRUE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
+  ASSERT_TRUE(NeedsSwap);
+}
+
+TEST(HeaderMapTest, checkHeaderVersion2NotEnoughBuckets) {
+  // Version 2 buckets are larger; the buckets of a version 1 map with the
+  // same number of buckets do not fit.
+  MapFile<4, 1> File;
+  File.init();
+  File.Header.Version = HMAP_HeaderVersion2;
+  bool NeedsSwap;
+  ASSERT_FALSE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
+}
+
+TEST(HeaderMapTest, lookupFilenameVersion2) {
+  typedef MapFile<4, 16, HMapBucketV2> FileTy;
+  FileTy File;
+  File.init();
+
+  FileMaker<FileTy> Maker(File);
+  auto a = Maker.addString("a");
+  auto b = Maker.addString("b");
+  auto c = Maker.addString("c");
+  auto d = Maker.addString("d");
+  Maker.addBucket(HeaderMapImpl::getHashV2("a"), a, b, c);
+  Maker.addBucket(HeaderMapImpl::getHashV2("d"), d, c, b);
+
+  bool NeedsSwap;
+  ASSERT_TRUE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
+  ASSERT_FALSE(NeedsSwap);
+  HeaderMapImpl Map(File.getBuffer(), NeedsSwap);
+
+  SmallString<8> DestPath;
+  ASSERT_EQ("bc", Map.lookupFilename("a", DestPath));
+  ASSERT_EQ("bc", Map.lookupFilename("A", DestPath));
+  ASSERT_EQ("cb", Map.lookupFilename("d", DestPath));
+  ASSERT_EQ("", Map.lookupFilename("b", DestPath));
+}
+
+TEST(HeaderMapTest, lookupFilenameVersion2Collision) {
+  typedef MapFile<2, 7, HMapBucketV2> FileTy;
+  FileTy File;
+  File.init();
+
+  // Put "a" in the bucket that "b" hashes to, but with the hash of "a"; the
+  // lookup of "b" has to probe past it to the one for "b".
+  FileMaker<FileTy> Maker(File);
+  auto a = Maker.addString("a");
+  auto b = Maker.addString("b");
+  auto c = Maker.addString("c");
+  unsigned HashB = HeaderMapImpl::getHashV2("b");
+  Maker.addBucket(HashB, a, b, c);
+  File.Buckets[HashB & 1].Hash = HeaderMapImpl::getHashV2("a");
+  Maker.addBucket(HashB, b, c, a);
+
+  bool NeedsSwap;
+  ASSERT_TRUE(HeaderMapImpl::checkHeader(*File.getBuffer(), NeedsSwap));
+  HeaderMapImpl Map(File.getBuffer(), NeedsSwap);
+
+  // The table is full; a key that is not in it must not probe forever.
+  SmallString<8> DestPath;
+  ASSERT_EQ("ca", Map.lookupFilename("b", DestPath));
+  ASSERT_EQ("", Map.lookupFilename("z", DestPath));
+}
+
 template <class FileTy, class PaddingTy> struct PaddedFile {
   FileTy File;
   PaddingTy Padding;
@@ -256,4 +341,76 @@ TEST(HeaderMapTest, lookupFilenameTruncatedPrefix) {
   ASSERT_EQ("", Map.lookupFilename("a", DestPath));
 }
 
+template <class FileTy> static StringRef getContents(const FileTy &File) {
+  return StringRef(reinterpret_cast<const char *>(&File), sizeof(File));
+}
+
+TEST(HeaderMapTest, createSharesUnchangedFiles) {
+  typedef MapFile<2, 7> FileTy;
+  FileTy File;
+  File.init();
+  FileMaker<FileTy> Maker(File);
+  auto a = Maker.addString("a");
+  auto b = Maker.addString("b");
+  auto c = Maker.addString("c");
+  Maker.addBucket(getHash("a"), a, b, c);
+
+  SmallString<128> Path;
+  int FD;
+  ASSERT_FALSE(sys::fs::createTemporaryFile("header-map-test", "hmap", FD,
+                                            Path));
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << getContents(File);
+  }
+
+  // Header maps of the same file share their contents.
+  FileManager FM((FileSystemOptions()));
+  const FileEntry *FE = FM.getFile(Path);
+  ASSERT_TRUE(FE);
+  std::unique_ptr<const HeaderMap> First(HeaderMap::Create(FE, FM));
+  std::unique_ptr<const HeaderMap> Second(HeaderMap::Create(FE, FM));
+  ASSERT_TRUE(First && Second);
+  EXPECT_EQ(First->getFileName(), Second->getFileName());
+
+  // A header map of the file after it has changed sees the new contents,
+  // while the existing ones keep the old ones.
+  typedef MapFile<2, 15> ChangedFileTy;
+  ChangedFileTy ChangedFile;
+  ChangedFile.init();
+  FileMaker<ChangedFileTy> ChangedMaker(ChangedFile);
+  a = ChangedMaker.addString("a");
+  auto d = ChangedMaker.addString("d");
+  auto e = ChangedMaker.addString("e");
+  ChangedMaker.addBucket(getHash("a"), a, d, e);
+  {
+    std::error_code EC;
+    raw_fd_ostream OS(Path, EC, sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << getContents(ChangedFile);
+  }
+
+  FileManager ChangedFM((FileSystemOptions()));
+  const FileEntry *ChangedFE = ChangedFM.getFile(Path);
+  ASSERT_TRUE(ChangedFE);
+  std::unique_ptr<const HeaderMap> Changed(
+      HeaderMap::Create(ChangedFE, ChangedFM));
+  ASSERT_TRUE(Changed);
+  EXPECT_NE(First->getFileName(), Changed->getFileName());
+
+  SmallString<8> DestPath;
+  EXPECT_EQ("bc", First->lookupFilename("a", DestPath));
+  EXPECT_EQ("de", Changed->lookupFilename("a", DestPath));
+
+  // Once no header map uses the contents any more, they are read again.
+  First.reset();
+  Second.reset();
+  Changed.reset();
+  Changed.reset(HeaderMap::Create(ChangedFE, ChangedFM));
+  ASSERT_TRUE(Changed);
+  EXPECT_EQ("de", Changed->lookupFilename("a", DestPath));
+
+  sys::fs::remove(Path);
+}
+
 } // end namespace
@@ -45,6 +45,32 @@ TEST(Rewriter, AdjacentInsertAndDelete) {
             applyAllReplacements("line1\nline2\nline3\nline4", Replaces));
 }
 
+TEST(Rewriter, ManyNonOverlappingReplacements) {
+  std::string Code;
+  std::string Expected;
+  Replacements Replaces;
+  for (unsigned i = 0; i != 1000; ++i) {
+    unsigned Offset = Code.size();
+    Code += "abc;";
+    Expected += "xy;";
+    Replaces.insert(Replacement("<file>", Offset, 3, "xy"));
+  }
+  // Adjacent insertion right after a replaced range.
+  Replaces.insert(Replacement("<file>", 3, 0, "!"));
+  Expected.insert(2, "!");
+  EXPECT_EQ(Expected, applyAllReplacements(Code, Replaces));
+}
+
+TEST(Rewriter, MultipleInsertionsAtSameOffset) {
+  Replacements Replaces;
+  Replaces.insert(Replacement("<file>", 1, 0, "a"));
+  Replaces.insert(Replacement("<file>", 1, 0, "b"));
+  Replaces.insert(Replacement("<file>", 2, 0, "c"));
+  // Insertions at the same offset are not handled by the single-pass splice;
+  // make sure the result still matches what the Rewriter produces.
+  EXPECT_EQ("xabycz", applyAllReplacements("xyz", Replaces));
+}
+
 } // end namespace
 } // end namespace tooling
 } // end namespace clang